@@ -0,0 +1,174 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "lib/accountmodel.h"
+#include "lib/accountsnapshot.h"
+
+#include <QFile>
+#include <QImage>
+#include <QStandardPaths>
+#include <QTest>
+
+#include <cstdlib>
+
+// glibc's own entry points, the ones below count and forward to them
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void __libc_free(void *ptr);
+}
+
+// Only what the test thread allocates while counting is seen, not the thread pools
+static thread_local bool s_counting = false;
+static thread_local int s_allocations = 0;
+
+extern "C" {
+void *malloc(size_t size) noexcept
+{
+    if (s_counting) {
+        ++s_allocations;
+    }
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) noexcept
+{
+    if (s_counting) {
+        ++s_allocations;
+    }
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) noexcept
+{
+    if (s_counting) {
+        ++s_allocations;
+    }
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) noexcept
+{
+    __libc_free(ptr);
+}
+}
+
+static void setupEnvironment()
+{
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+    // Nothing may revalidate, and so replace, the rows the test reads from the snapshot
+    qputenv("DBUS_SYSTEM_BUS_ADDRESS", "unix:path=/nonexistent/user-manager-autotest");
+}
+Q_CONSTRUCTOR_FUNCTION(setupEnvironment)
+
+class AccountModelDataTest : public QObject
+{
+    Q_OBJECT
+    private Q_SLOTS:
+        void initTestCase();
+        void cleanupTestCase();
+
+        void testHookCounts();
+        void testCommonRolesDoNotAllocate_data();
+        void testCommonRolesDoNotAllocate();
+
+    private:
+        AccountModel* m_model = nullptr;
+};
+
+void AccountModelDataTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+
+    QImage face(64, 64, QImage::Format_ARGB32_Premultiplied);
+    face.fill(Qt::darkCyan);
+
+    QVector<AccountSnapshot::Record> records;
+    for (uint uid : {2001u, 2002u}) {
+        AccountSnapshot::Record record;
+        record.path = QStringLiteral("/org/freedesktop/Accounts/User%1").arg(uid);
+        record.details = {
+            {QStringLiteral("Uid"), qulonglong(uid)},
+            {QStringLiteral("UserName"), QStringLiteral("user%1").arg(uid)},
+            {QStringLiteral("RealName"), QStringLiteral("User Number %1").arg(uid)}
+        };
+        record.face = face;
+        records.append(record);
+    }
+    QVERIFY(AccountSnapshot::save(AccountSnapshot::defaultFileName(), records));
+
+    m_model = new AccountModel(nullptr);
+    QVERIFY(m_model->loadedFromSnapshot());
+    QCOMPARE(m_model->rowCount(), 3);
+
+    // The session tracking behind the Logged role is set up once the event loop runs
+    QTest::qWait(100);
+}
+
+void AccountModelDataTest::cleanupTestCase()
+{
+    delete m_model;
+    QFile::remove(AccountSnapshot::defaultFileName());
+}
+
+void AccountModelDataTest::testHookCounts()
+{
+    // Would the hook not see anything, the test below would pass for nothing
+    s_allocations = 0;
+    s_counting = true;
+    const QString text = QString::number(1234567).repeated(10);
+    s_counting = false;
+
+    QVERIFY(!text.isEmpty());
+    QVERIFY(s_allocations > 0);
+}
+
+void AccountModelDataTest::testCommonRolesDoNotAllocate_data()
+{
+    QTest::addColumn<int>("role");
+
+    QTest::newRow("display") << int(Qt::DisplayRole);
+    QTest::newRow("decoration") << int(Qt::DecorationRole);
+    QTest::newRow("username") << int(AccountModel::Username);
+    QTest::newRow("logged") << int(AccountModel::Logged);
+}
+
+void AccountModelDataTest::testCommonRolesDoNotAllocate()
+{
+    QFETCH(int, role);
+    const QModelIndex index = m_model->index(0, 0);
+
+    // The first call builds the row record, every later one only hands it out
+    QVariant value = m_model->data(index, role);
+    QVERIFY(value.isValid());
+
+    s_allocations = 0;
+    s_counting = true;
+    for (int i = 0; i < 1000; ++i) {
+        value = m_model->data(index, role);
+    }
+    s_counting = false;
+
+    QVERIFY(value.isValid());
+    QCOMPARE(s_allocations, 0);
+}
+
+QTEST_MAIN(AccountModelDataTest)
+
+#include "accountmodeldatatest.moc"
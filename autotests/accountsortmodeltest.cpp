@@ -0,0 +1,233 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "lib/accountmodel.h"
+#include "lib/accountsortmodel.h"
+#include "lib/modeltest.h"
+
+#include <QSignalSpy>
+#include <QStandardItemModel>
+#include <QTest>
+
+class AccountSortModelTest : public QObject
+{
+    Q_OBJECT
+    private Q_SLOTS:
+        void init();
+        void cleanup();
+
+        void testInitialOrder();
+        void testInsertMiddle();
+        void testInsertAboveEverything();
+        void testRemove();
+        void testRenameAcrossGroups();
+        void testLoggedFlip();
+        void testSetGrouped();
+
+    private:
+        QStandardItem* account(const QString &name, bool logged = false, bool administrator = false) const;
+        QStringList shown() const;
+        void checkMapping() const;
+
+        QStandardItemModel* m_source = nullptr;
+        AccountSortModel* m_proxy = nullptr;
+        ModelTest* m_tester = nullptr;
+};
+
+/*
+ * What AccountModel reports for a loaded account, the sort keys only look at these roles.
+ */
+QStandardItem* AccountSortModelTest::account(const QString &name, bool logged, bool administrator) const
+{
+    QStandardItem *item = new QStandardItem(name);
+    item->setData(true, AccountModel::Created);
+    item->setData(name.toLower(), AccountModel::Username);
+    item->setData(logged, AccountModel::Logged);
+    item->setData(administrator, AccountModel::Administrator);
+    return item;
+}
+
+QStringList AccountSortModelTest::shown() const
+{
+    QStringList names;
+    for (int row = 0; row < m_proxy->rowCount(); ++row) {
+        names << m_proxy->index(row, 0).data().toString();
+    }
+    return names;
+}
+
+void AccountSortModelTest::checkMapping() const
+{
+    QCOMPARE(m_proxy->rowCount(), m_source->rowCount());
+    for (int row = 0; row < m_proxy->rowCount(); ++row) {
+        const QModelIndex index = m_proxy->index(row, 0);
+        QCOMPARE(m_proxy->mapFromSource(m_proxy->mapToSource(index)), index);
+        QCOMPARE(index.data().toString(), m_proxy->mapToSource(index).data().toString());
+    }
+    for (int row = 0; row < m_source->rowCount(); ++row) {
+        const QModelIndex index = m_source->index(row, 0);
+        QCOMPARE(m_proxy->mapToSource(m_proxy->mapFromSource(index)), index);
+    }
+}
+
+void AccountSortModelTest::init()
+{
+    m_source = new QStandardItemModel(this);
+    m_source->appendRow(account(QStringLiteral("Alice")));
+    m_source->appendRow(account(QStringLiteral("Bob"), false, true));
+    m_source->appendRow(account(QStringLiteral("Carol"), true));
+
+    // The "new user" row, always last
+    QStandardItem *newUser = new QStandardItem(QStringLiteral("New User"));
+    newUser->setData(false, AccountModel::Created);
+    m_source->appendRow(newUser);
+
+    m_proxy = new AccountSortModel(this);
+    m_proxy->setSourceModel(m_source);
+    m_tester = new ModelTest(m_proxy, this);
+}
+
+void AccountSortModelTest::cleanup()
+{
+    delete m_tester;
+    delete m_proxy;
+    delete m_source;
+}
+
+void AccountSortModelTest::testInitialOrder()
+{
+    QCOMPARE(shown(), QStringList({QStringLiteral("Carol"), QStringLiteral("Bob"), QStringLiteral("Alice"), QStringLiteral("New User")}));
+    checkMapping();
+}
+
+void AccountSortModelTest::testInsertMiddle()
+{
+    QSignalSpy spy(m_proxy, &QAbstractItemModel::rowsInserted);
+    m_source->insertRow(2, account(QStringLiteral("Dave")));
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.first().at(1).toInt(), 3);
+    QCOMPARE(shown(), QStringList({QStringLiteral("Carol"), QStringLiteral("Bob"), QStringLiteral("Alice"),
+                                   QStringLiteral("Dave"), QStringLiteral("New User")}));
+    checkMapping();
+}
+
+void AccountSortModelTest::testInsertAboveEverything()
+{
+    // What AccountModel does when the current user is not among the cached users:
+    // the row goes to the top of the source but sorts last among the accounts
+    m_source->insertRow(0, account(QStringLiteral("Zed")));
+    QCOMPARE(shown(), QStringList({QStringLiteral("Carol"), QStringLiteral("Bob"), QStringLiteral("Alice"),
+                                   QStringLiteral("Zed"), QStringLiteral("New User")}));
+    checkMapping();
+
+    // Every row above the insertion was renumbered, a change must still find its row
+    m_source->item(1)->setData(true, AccountModel::Logged);
+    QCOMPARE(shown(), QStringList({QStringLiteral("Alice"), QStringLiteral("Carol"), QStringLiteral("Bob"),
+                                   QStringLiteral("Zed"), QStringLiteral("New User")}));
+    checkMapping();
+
+    // Several rows at once, some of which end up next to each other
+    m_source->invisibleRootItem()->insertRows(1, {account(QStringLiteral("Aaron")), account(QStringLiteral("Yvonne"), true), account(QStringLiteral("Abe"))});
+    QCOMPARE(shown(), QStringList({QStringLiteral("Alice"), QStringLiteral("Carol"), QStringLiteral("Yvonne"),
+                                   QStringLiteral("Bob"), QStringLiteral("Aaron"), QStringLiteral("Abe"),
+                                   QStringLiteral("Zed"), QStringLiteral("New User")}));
+    checkMapping();
+}
+
+void AccountSortModelTest::testRemove()
+{
+    m_source->insertRow(0, account(QStringLiteral("Zed")));
+
+    QSignalSpy spy(m_proxy, &QAbstractItemModel::rowsRemoved);
+    m_source->removeRow(2);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.first().at(1).toInt(), 1);
+    QCOMPARE(shown(), QStringList({QStringLiteral("Carol"), QStringLiteral("Alice"), QStringLiteral("Zed"), QStringLiteral("New User")}));
+    checkMapping();
+
+    m_source->removeRows(0, 2);
+    QCOMPARE(shown(), QStringList({QStringLiteral("Carol"), QStringLiteral("New User")}));
+    checkMapping();
+}
+
+void AccountSortModelTest::testRenameAcrossGroups()
+{
+    QSignalSpy spy(m_proxy, &QAbstractItemModel::rowsMoved);
+
+    // Alice becomes an administrator and sorts before Bob by name
+    m_source->item(0)->setData(true, AccountModel::Administrator);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(shown(), QStringList({QStringLiteral("Carol"), QStringLiteral("Alice"), QStringLiteral("Bob"), QStringLiteral("New User")}));
+    checkMapping();
+
+    // A rename within the group only moves the row there
+    m_source->item(0)->setText(QStringLiteral("Zoe"));
+    QCOMPARE(shown(), QStringList({QStringLiteral("Carol"), QStringLiteral("Bob"), QStringLiteral("Zoe"), QStringLiteral("New User")}));
+    checkMapping();
+
+    // Names compare case-insensitively and numbers by value
+    m_source->item(1)->setText(QStringLiteral("user10"));
+    m_source->item(0)->setText(QStringLiteral("User9"));
+    QCOMPARE(shown(), QStringList({QStringLiteral("Carol"), QStringLiteral("User9"), QStringLiteral("user10"), QStringLiteral("New User")}));
+    checkMapping();
+}
+
+void AccountSortModelTest::testLoggedFlip()
+{
+    m_source->item(2)->setData(false, AccountModel::Logged);
+    QCOMPARE(shown(), QStringList({QStringLiteral("Bob"), QStringLiteral("Alice"), QStringLiteral("Carol"), QStringLiteral("New User")}));
+    checkMapping();
+
+    m_source->item(0)->setData(true, AccountModel::Logged);
+    m_source->item(2)->setData(true, AccountModel::Logged);
+    QCOMPARE(shown(), QStringList({QStringLiteral("Alice"), QStringLiteral("Carol"), QStringLiteral("Bob"), QStringLiteral("New User")}));
+    checkMapping();
+
+    // A change to a role the order does not depend on does not move anything
+    QSignalSpy moved(m_proxy, &QAbstractItemModel::rowsMoved);
+    QSignalSpy changed(m_proxy, &QAbstractItemModel::dataChanged);
+    m_source->item(1)->setData(QStringLiteral("bob@example.org"), AccountModel::Email);
+    QCOMPARE(moved.count(), 0);
+    QCOMPARE(changed.count(), 1);
+    QCOMPARE(changed.first().at(0).value<QModelIndex>().row(), 2);
+}
+
+void AccountSortModelTest::testSetGrouped()
+{
+    QSignalSpy spy(m_proxy, &QAbstractItemModel::layoutChanged);
+    m_proxy->setGrouped(false);
+    QVERIFY(!m_proxy->isGrouped());
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(shown(), QStringList({QStringLiteral("Alice"), QStringLiteral("Bob"), QStringLiteral("Carol"), QStringLiteral("New User")}));
+    checkMapping();
+
+    // Changes keep working on the ungrouped order
+    m_source->insertRow(0, account(QStringLiteral("Beth"), true));
+    QCOMPARE(shown(), QStringList({QStringLiteral("Alice"), QStringLiteral("Beth"), QStringLiteral("Bob"),
+                                   QStringLiteral("Carol"), QStringLiteral("New User")}));
+    checkMapping();
+
+    m_proxy->setGrouped(true);
+    QCOMPARE(shown(), QStringList({QStringLiteral("Beth"), QStringLiteral("Carol"), QStringLiteral("Bob"),
+                                   QStringLiteral("Alice"), QStringLiteral("New User")}));
+    checkMapping();
+}
+
+QTEST_GUILESS_MAIN(AccountSortModelTest)
+
+#include "accountsortmodeltest.moc"
@@ -0,0 +1,270 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "lib/areascaler.h"
+
+#include <QImage>
+#include <QRandomGenerator>
+#include <QTest>
+
+#include <algorithm>
+#include <cmath>
+
+Q_DECLARE_METATYPE(AreaScaler::Kernel)
+
+/*
+ * Averages the area each destination pixel covers in double precision, the
+ * result every kernel has to match within one level.
+ */
+static QImage referenceScaled(const QImage &source, const QSize &size)
+{
+    QImage result(size, source.format());
+    const double scaleX = double(source.width()) / size.width();
+    const double scaleY = double(source.height()) / size.height();
+
+    for (int y = 0; y < size.height(); ++y) {
+        const double top = y * scaleY;
+        const double bottom = (y + 1) * scaleY;
+        uchar *line = result.scanLine(y);
+        for (int x = 0; x < size.width(); ++x) {
+            const double left = x * scaleX;
+            const double right = (x + 1) * scaleX;
+            double sum[4] = { 0, 0, 0, 0 };
+            for (int j = int(top); j < std::min(source.height(), int(std::ceil(bottom))); ++j) {
+                const double height = std::min<double>(j + 1, bottom) - std::max<double>(j, top);
+                const uchar *pixel = source.constScanLine(j);
+                for (int i = int(left); i < std::min(source.width(), int(std::ceil(right))); ++i) {
+                    const double area = (std::min<double>(i + 1, right) - std::max<double>(i, left)) * height;
+                    for (int c = 0; c < 4; ++c) {
+                        sum[c] += area * pixel[4 * i + c];
+                    }
+                }
+            }
+            for (int c = 0; c < 4; ++c) {
+                line[4 * x + c] = uchar(qBound(0.0, std::round(sum[c] / (scaleX * scaleY)), 255.0));
+            }
+        }
+    }
+
+    return result;
+}
+
+// Noise is the worst case for a resampler, with alpha to exercise premultiplication
+static QImage noise(const QSize &size)
+{
+    QRandomGenerator random(size.width() * 7919 + size.height());
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < size.height(); ++y) {
+        QRgb *line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < size.width(); ++x) {
+            const int alpha = random.bounded(256);
+            line[x] = qRgba(random.bounded(alpha + 1), random.bounded(alpha + 1), random.bounded(alpha + 1), alpha);
+        }
+    }
+    return image;
+}
+
+static int maxDifference(const QImage &a, const QImage &b)
+{
+    int difference = 0;
+    for (int y = 0; y < a.height(); ++y) {
+        const uchar *lineA = a.constScanLine(y);
+        const uchar *lineB = b.constScanLine(y);
+        for (int x = 0; x < 4 * a.width(); ++x) {
+            difference = std::max(difference, std::abs(lineA[x] - lineB[x]));
+        }
+    }
+    return difference;
+}
+
+static const AreaScaler::Kernel s_kernels[] = { AreaScaler::Scalar, AreaScaler::SSE2, AreaScaler::AVX2 };
+
+class AreaScalerTest : public QObject
+{
+    Q_OBJECT
+    private Q_SLOTS:
+        void initTestCase();
+        void cleanup();
+
+        void testMatchesReference_data();
+        void testMatchesReference();
+        void testKernelsAgree_data();
+        void testKernelsAgree();
+        void testDoesNotAlias_data();
+        void testDoesNotAlias();
+
+        void benchmarkScale_data();
+        void benchmarkScale();
+
+    private:
+        AreaScaler::Kernel m_defaultKernel = AreaScaler::Scalar;
+};
+
+void AreaScalerTest::initTestCase()
+{
+    m_defaultKernel = AreaScaler::kernel();
+    qDebug() << "Kernel picked for this CPU:" << AreaScaler::kernelName(m_defaultKernel);
+}
+
+void AreaScalerTest::cleanup()
+{
+    AreaScaler::setKernel(m_defaultKernel);
+}
+
+void AreaScalerTest::testMatchesReference_data()
+{
+    QTest::addColumn<AreaScaler::Kernel>("kernel");
+    QTest::addColumn<QSize>("source");
+    QTest::addColumn<QSize>("size");
+
+    const QList<QPair<QSize, QSize>> sizes = {
+        {QSize(640, 480), QSize(48, 48)},
+        {QSize(1000, 750), QSize(192, 144)},
+        {QSize(97, 61), QSize(17, 13)},
+        {QSize(300, 300), QSize(299, 299)},
+        {QSize(256, 256), QSize(128, 128)},
+        {QSize(50, 1), QSize(7, 1)},
+        {QSize(33, 33), QSize(33, 33)}
+    };
+    for (AreaScaler::Kernel kernel : s_kernels) {
+        for (const auto &size : sizes) {
+            const QByteArray name = QByteArray(AreaScaler::kernelName(kernel)) + ' '
+                + QByteArray::number(size.first.width()) + 'x' + QByteArray::number(size.first.height()) + " to "
+                + QByteArray::number(size.second.width()) + 'x' + QByteArray::number(size.second.height());
+            QTest::newRow(name.constData()) << kernel << size.first << size.second;
+        }
+    }
+}
+
+void AreaScalerTest::testMatchesReference()
+{
+    QFETCH(AreaScaler::Kernel, kernel);
+    QFETCH(QSize, source);
+    QFETCH(QSize, size);
+
+    if (!AreaScaler::setKernel(kernel)) {
+        QSKIP("The CPU does not have this instruction set");
+    }
+
+    const QImage image = noise(source);
+    const QImage scaled = AreaScaler::scaled(image, size);
+    QCOMPARE(scaled.size(), size);
+    QCOMPARE(scaled.format(), QImage::Format_ARGB32_Premultiplied);
+    QVERIFY(maxDifference(scaled, referenceScaled(image, size)) <= 1);
+}
+
+void AreaScalerTest::testKernelsAgree_data()
+{
+    QTest::addColumn<AreaScaler::Kernel>("kernel");
+
+    QTest::newRow("SSE2") << AreaScaler::SSE2;
+    QTest::newRow("AVX2") << AreaScaler::AVX2;
+}
+
+void AreaScalerTest::testKernelsAgree()
+{
+    QFETCH(AreaScaler::Kernel, kernel);
+
+    if (!AreaScaler::isSupported(kernel)) {
+        QSKIP("The CPU does not have this instruction set");
+    }
+
+    const QImage image = noise(QSize(1203, 907));
+    QVERIFY(AreaScaler::setKernel(AreaScaler::Scalar));
+    const QImage scalar = AreaScaler::scaled(image, QSize(192, 145));
+    QVERIFY(AreaScaler::setKernel(kernel));
+    QCOMPARE(AreaScaler::kernel(), kernel);
+    QVERIFY(maxDifference(AreaScaler::scaled(image, QSize(192, 145)), scalar) <= 1);
+}
+
+void AreaScalerTest::testDoesNotAlias_data()
+{
+    QTest::addColumn<AreaScaler::Kernel>("kernel");
+
+    for (AreaScaler::Kernel kernel : s_kernels) {
+        QTest::newRow(AreaScaler::kernelName(kernel)) << kernel;
+    }
+}
+
+void AreaScalerTest::testDoesNotAlias()
+{
+    QFETCH(AreaScaler::Kernel, kernel);
+
+    if (!AreaScaler::setKernel(kernel)) {
+        QSKIP("The CPU does not have this instruction set");
+    }
+
+    // A one pixel checkerboard shrunk 16 times has to come out flat grey
+    QImage checkerboard(QSize(1024, 1024), QImage::Format_RGB32);
+    for (int y = 0; y < checkerboard.height(); ++y) {
+        QRgb *line = reinterpret_cast<QRgb*>(checkerboard.scanLine(y));
+        for (int x = 0; x < checkerboard.width(); ++x) {
+            line[x] = (x + y) % 2 ? qRgb(255, 255, 255) : qRgb(0, 0, 0);
+        }
+    }
+
+    const QImage scaled = AreaScaler::scaled(checkerboard, QSize(64, 64));
+    for (int y = 0; y < scaled.height(); ++y) {
+        for (int x = 0; x < scaled.width(); ++x) {
+            const int grey = qGreen(scaled.pixel(x, y));
+            QVERIFY2(grey >= 127 && grey <= 128, qPrintable(QStringLiteral("%1 at %2,%3").arg(grey).arg(x).arg(y)));
+        }
+    }
+}
+
+void AreaScalerTest::benchmarkScale_data()
+{
+    QTest::addColumn<int>("kernel");
+    QTest::addColumn<QSize>("size");
+
+    // A camera photo shrunk into a face and into the largest avatar, -1 is Qt's smooth scaler
+    for (const QSize &size : {QSize(192, 144), QSize(600, 450)}) {
+        const QByteArray suffix = ' ' + QByteArray::number(size.width()) + 'x' + QByteArray::number(size.height());
+        QTest::newRow(QByteArray("Qt smooth" + suffix).constData()) << -1 << size;
+        for (AreaScaler::Kernel kernel : s_kernels) {
+            QTest::newRow(QByteArray(AreaScaler::kernelName(kernel) + suffix).constData()) << int(kernel) << size;
+        }
+    }
+}
+
+void AreaScalerTest::benchmarkScale()
+{
+    QFETCH(int, kernel);
+    QFETCH(QSize, size);
+
+    if (kernel >= 0 && !AreaScaler::setKernel(static_cast<AreaScaler::Kernel>(kernel))) {
+        QSKIP("The CPU does not have this instruction set");
+    }
+
+    static const QImage image = noise(QSize(4000, 3000));
+    QImage scaled;
+    if (kernel < 0) {
+        QBENCHMARK {
+            scaled = image.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        }
+    } else {
+        QBENCHMARK {
+            scaled = AreaScaler::scaled(image, size);
+        }
+    }
+    QCOMPARE(scaled.size(), size);
+}
+
+QTEST_GUILESS_MAIN(AreaScalerTest)
+
+#include "areascalertest.moc"
@@ -0,0 +1,171 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "avatarcropper.h"
+
+#include <QImageReader>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+
+Q_DECLARE_METATYPE(QImageIOHandler::Transformations)
+
+// A 48 MP camera picture
+static const QSize s_cameraSize(8000, 6000);
+
+// Red grows to the right, green downwards, so a pixel tells where it came from
+static QRgb gradient(int x, int y, const QSize &size)
+{
+    return qRgb(x * 255 / (size.width() - 1), y * 255 / (size.height() - 1), 128);
+}
+
+class AvatarCropperTest : public QObject
+{
+    Q_OBJECT
+    private Q_SLOTS:
+        void initTestCase();
+
+        void testProxy();
+        void testSelect_data();
+        void testSelect();
+        void testCrop();
+
+        void benchmarkDecode_data();
+        void benchmarkDecode();
+
+    private:
+        QTemporaryDir m_dir;
+        QString m_path;
+};
+
+void AvatarCropperTest::initTestCase()
+{
+    // Nothing is reused from avatars stored by earlier runs
+    QStandardPaths::setTestModeEnabled(true);
+
+    QVERIFY(m_dir.isValid());
+    m_path = m_dir.filePath(QStringLiteral("camera.jpg"));
+
+    QImage image(s_cameraSize, QImage::Format_RGB32);
+    for (int y = 0; y < image.height(); ++y) {
+        QRgb *line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            line[x] = gradient(x, y, s_cameraSize);
+        }
+    }
+    QVERIFY(image.save(m_path, "JPEG", 90));
+}
+
+void AvatarCropperTest::testProxy()
+{
+    const AvatarCropper::Proxy proxy = AvatarCropper::readProxy(m_path);
+    QVERIFY(!proxy.isNull());
+    QCOMPARE(proxy.fileSize, s_cameraSize);
+    QCOMPARE(proxy.transformation, QImageIOHandler::Transformations(QImageIOHandler::TransformationNone));
+    QCOMPARE(proxy.image.size(), s_cameraSize.scaled(1024, 1024, Qt::KeepAspectRatio));
+
+    QVERIFY(AvatarCropper::readProxy(m_dir.filePath(QStringLiteral("missing.jpg"))).isNull());
+}
+
+void AvatarCropperTest::testSelect_data()
+{
+    QTest::addColumn<QImageIOHandler::Transformations>("transformation");
+    QTest::addColumn<QRect>("region");
+    QTest::addColumn<QRect>("clip");
+
+    // 1024x768 shown for 8000x6000, a proxy pixel is 7.8125 file pixels
+    QTest::newRow("none") << QImageIOHandler::Transformations(QImageIOHandler::TransformationNone)
+                          << QRect(512, 384, 256, 256) << QRect(4000, 3000, 2000, 2000);
+    QTest::newRow("mirror") << QImageIOHandler::Transformations(QImageIOHandler::TransformationMirror)
+                            << QRect(0, 0, 256, 256) << QRect(6000, 0, 2000, 2000);
+
+    // Shown as 768x1024 for 6000x8000, the top left corner is the bottom left of the file
+    QTest::newRow("rotate90") << QImageIOHandler::Transformations(QImageIOHandler::TransformationRotate90)
+                              << QRect(0, 0, 256, 256) << QRect(0, 4000, 2000, 2000);
+}
+
+void AvatarCropperTest::testSelect()
+{
+    QFETCH(QImageIOHandler::Transformations, transformation);
+    QFETCH(QRect, region);
+    QFETCH(QRect, clip);
+
+    AvatarCropper::Proxy proxy;
+    proxy.fileSize = s_cameraSize;
+    proxy.transformation = transformation;
+    const QSize shown = transformation & QImageIOHandler::TransformationRotate90 ? s_cameraSize.transposed() : s_cameraSize;
+    proxy.image = QImage(shown.scaled(1024, 1024, Qt::KeepAspectRatio), QImage::Format_RGB32);
+
+    const AvatarCropper::Selection selection = AvatarCropper::select(proxy, region);
+    QCOMPARE(selection.clip, clip);
+    QCOMPARE(selection.size, QSize(600, 600));
+}
+
+void AvatarCropperTest::testCrop()
+{
+    const AvatarCropper::Proxy proxy = AvatarCropper::readProxy(m_path);
+    const AvatarCropper::Selection selection = AvatarCropper::select(proxy, QRect(512, 384, 256, 256));
+
+    const AvatarCropper::Crop crop = AvatarCropper::crop(m_path, selection);
+    QVERIFY(crop.stored.isEmpty());
+    QVERIFY(!crop.key.isEmpty());
+    QCOMPARE(crop.image.size(), selection.size);
+
+    // The middle of the crop is the middle of the clip, give or take JPEG
+    const QPoint center = selection.clip.center();
+    const QRgb expected = gradient(center.x(), center.y(), s_cameraSize);
+    const QRgb actual = crop.image.pixel(crop.image.width() / 2, crop.image.height() / 2);
+    QVERIFY2(qAbs(qRed(actual) - qRed(expected)) <= 4 && qAbs(qGreen(actual) - qGreen(expected)) <= 4,
+             qPrintable(QStringLiteral("%1 instead of %2").arg(actual, 0, 16).arg(expected, 0, 16)));
+}
+
+void AvatarCropperTest::benchmarkDecode_data()
+{
+    QTest::addColumn<QString>("kind");
+    QTest::newRow("proxy") << QStringLiteral("proxy");
+    QTest::newRow("crop") << QStringLiteral("crop");
+    QTest::newRow("full") << QStringLiteral("full");
+}
+
+void AvatarCropperTest::benchmarkDecode()
+{
+    QFETCH(QString, kind);
+
+    const AvatarCropper::Proxy proxy = AvatarCropper::readProxy(m_path);
+    const AvatarCropper::Selection selection = AvatarCropper::select(proxy, QRect(256, 128, 512, 512));
+
+    if (kind == QLatin1String("proxy")) {
+        QBENCHMARK {
+            QVERIFY(!AvatarCropper::readProxy(m_path).isNull());
+        }
+    } else if (kind == QLatin1String("crop")) {
+        QBENCHMARK {
+            QVERIFY(!AvatarCropper::crop(m_path, selection).image.isNull());
+        }
+    } else {
+        // What picking the region used to cost: the whole picture, then the selection out of it
+        QBENCHMARK {
+            const QImage image = QImageReader(m_path).read();
+            QVERIFY(!image.copy(selection.clip).scaled(selection.size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation).isNull());
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(AvatarCropperTest)
+
+#include "avatarcroppertest.moc"
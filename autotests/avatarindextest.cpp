@@ -0,0 +1,157 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "lib/avatarindex.h"
+
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTest>
+
+#include <algorithm>
+
+static void setupEnvironment()
+{
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+}
+Q_CONSTRUCTOR_FUNCTION(setupEnvironment)
+
+class AvatarIndexTest : public QObject
+{
+    Q_OBJECT
+    private Q_SLOTS:
+        void initTestCase();
+        void cleanupTestCase();
+
+        void testSymlinkLoop();
+        void testFailedDecodeIsRemembered();
+        void testRewrittenPictureReloads();
+
+    private:
+        int findRow(AvatarIndex *index, const QString &relative) const;
+
+        QString m_root;
+};
+
+void AvatarIndexTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    m_root = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QStringLiteral("/user-manager/avatars");
+    QDir(m_root).removeRecursively();
+    QVERIFY(QDir().mkpath(m_root + QStringLiteral("/animals")));
+
+    QImage image(32, 32, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::red);
+    QVERIFY(image.save(m_root + QStringLiteral("/animals/cat.png")));
+
+    QFile broken(m_root + QStringLiteral("/animals/broken.png"));
+    QVERIFY(broken.open(QIODevice::WriteOnly));
+    broken.write("not a picture");
+    broken.close();
+
+    // Both point back up the tree
+    QVERIFY(QFile::link(m_root, m_root + QStringLiteral("/animals/all")));
+    QVERIFY(QFile::link(QStringLiteral(".."), m_root + QStringLiteral("/animals/parent")));
+}
+
+void AvatarIndexTest::cleanupTestCase()
+{
+    QDir(m_root).removeRecursively();
+}
+
+int AvatarIndexTest::findRow(AvatarIndex *index, const QString &relative) const
+{
+    const QString path = m_root + QLatin1Char('/') + relative;
+    for (int row = 0; row < index->rowCount(); ++row) {
+        if (index->index(row).data(AvatarIndex::PathRole).toString() == path) {
+            return row;
+        }
+    }
+    return -1;
+}
+
+void AvatarIndexTest::testSymlinkLoop()
+{
+    AvatarIndex index;
+    QTRY_VERIFY(findRow(&index, QStringLiteral("animals/cat.png")) >= 0);
+    QVERIFY(findRow(&index, QStringLiteral("animals/broken.png")) >= 0);
+
+    // Nothing is found again through the links
+    QCOMPARE(findRow(&index, QStringLiteral("animals/all/animals/cat.png")), -1);
+    QCOMPARE(findRow(&index, QStringLiteral("animals/parent/animals/cat.png")), -1);
+}
+
+void AvatarIndexTest::testFailedDecodeIsRemembered()
+{
+    AvatarIndex index;
+    QTRY_VERIFY(findRow(&index, QStringLiteral("animals/broken.png")) >= 0);
+    const QModelIndex cat = index.index(findRow(&index, QStringLiteral("animals/cat.png")));
+    const QModelIndex broken = index.index(findRow(&index, QStringLiteral("animals/broken.png")));
+
+    QVERIFY(!cat.data(Qt::DecorationRole).isValid());
+    QTRY_VERIFY(cat.data(Qt::DecorationRole).canConvert<QPixmap>());
+
+    // The first request starts a decode which fails, later ones get nothing
+    QVERIFY(!broken.data(Qt::DecorationRole).isValid());
+    QTest::qWait(200);
+    QVERIFY(!broken.data(Qt::DecorationRole).isValid());
+
+    // Replaced with a picture, the failure is forgotten once the directory was rescanned
+    QSignalSpy spy(&index, &QAbstractItemModel::dataChanged);
+    QImage image(32, 32, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::blue);
+    QVERIFY(image.save(m_root + QStringLiteral("/../fixed.png")));
+    QVERIFY(QFile::remove(m_root + QStringLiteral("/animals/broken.png")));
+    QVERIFY(QFile::rename(m_root + QStringLiteral("/../fixed.png"), m_root + QStringLiteral("/animals/broken.png")));
+    QTRY_VERIFY(spy.count() > 0);
+    QTRY_VERIFY(broken.data(Qt::DecorationRole).canConvert<QPixmap>());
+}
+
+void AvatarIndexTest::testRewrittenPictureReloads()
+{
+    AvatarIndex index;
+    QTRY_VERIFY(findRow(&index, QStringLiteral("animals/cat.png")) >= 0);
+    const QModelIndex cat = index.index(findRow(&index, QStringLiteral("animals/cat.png")));
+    QVERIFY(!cat.data(Qt::DecorationRole).isValid());
+    QTRY_VERIFY(cat.data(Qt::DecorationRole).canConvert<QPixmap>());
+    QCOMPARE(cat.data(Qt::DecorationRole).value<QPixmap>().toImage().pixelColor(0, 0), QColor(Qt::red));
+
+    // Same name and root, other picture. The thumbnail cache goes by seconds, so it is made newer
+    QSignalSpy spy(&index, &QAbstractItemModel::dataChanged);
+    const QString path = m_root + QStringLiteral("/animals/cat.png");
+    QImage image(48, 48, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::green);
+    QVERIFY(image.save(m_root + QStringLiteral("/../green.png")));
+    QVERIFY(QFile::remove(path));
+    QVERIFY(QFile::rename(m_root + QStringLiteral("/../green.png"), path));
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.setFileTime(QDateTime::currentDateTime().addSecs(10), QFileDevice::FileModificationTime));
+    file.close();
+
+    QTRY_VERIFY(std::any_of(spy.cbegin(), spy.cend(), [&cat](const QList<QVariant> &signal) {
+        return signal.at(0).toModelIndex() == cat && signal.at(2).value<QVector<int>>().contains(Qt::DecorationRole);
+    }));
+    QTRY_COMPARE(cat.data(Qt::DecorationRole).value<QPixmap>().toImage().pixelColor(0, 0), QColor(Qt::green));
+}
+
+QTEST_MAIN(AvatarIndexTest)
+
+#include "avatarindextest.moc"
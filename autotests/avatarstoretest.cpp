@@ -0,0 +1,150 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "lib/avatarstore.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+
+class AvatarStoreTest : public QObject
+{
+    Q_OBJECT
+    private Q_SLOTS:
+        void initTestCase();
+        void init();
+        void cleanup();
+
+        void testInsertAndFind();
+        void testSameDataStoredOnce();
+        void testCleanedUpObject();
+        void testContentHash();
+
+    private:
+        void write(const QString &path, const QByteArray &data);
+
+        QString m_store;
+        QTemporaryDir* m_dir = nullptr;
+};
+
+void AvatarStoreTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    m_store = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/user-manager/avatars");
+}
+
+void AvatarStoreTest::init()
+{
+    QDir(m_store).removeRecursively();
+    m_dir = new QTemporaryDir;
+    QVERIFY(m_dir->isValid());
+}
+
+void AvatarStoreTest::cleanup()
+{
+    delete m_dir;
+    m_dir = nullptr;
+    QDir(m_store).removeRecursively();
+}
+
+void AvatarStoreTest::write(const QString &path, const QByteArray &data)
+{
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QCOMPARE(file.write(data), qint64(data.size()));
+}
+
+void AvatarStoreTest::testInsertAndFind()
+{
+    QVERIFY(AvatarStore::find("crop-1").isEmpty());
+
+    const QByteArray data("an encoded avatar");
+    const QString object = AvatarStore::insert("crop-1", data);
+    QVERIFY(!object.isEmpty());
+
+    // Named after its content
+    QCOMPARE(QFileInfo(object).fileName(), QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Sha256).toHex()));
+    QFile file(object);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.readAll(), data);
+
+    QCOMPARE(AvatarStore::find("crop-1"), QFileInfo(object).canonicalFilePath());
+    QVERIFY(AvatarStore::find("crop-2").isEmpty());
+}
+
+void AvatarStoreTest::testSameDataStoredOnce()
+{
+    const QString first = AvatarStore::insert("crop-1", "same");
+    const QString second = AvatarStore::insert("crop-2", "same");
+    QCOMPARE(second, first);
+    QCOMPARE(QDir(m_store + QStringLiteral("/objects")).entryList(QDir::Files).count(), 1);
+    QCOMPARE(AvatarStore::find("crop-2"), AvatarStore::find("crop-1"));
+
+    // A key made again points at the new data
+    const QString other = AvatarStore::insert("crop-1", "other");
+    QVERIFY(other != first);
+    QCOMPARE(AvatarStore::find("crop-1"), QFileInfo(other).canonicalFilePath());
+    QCOMPARE(AvatarStore::find("crop-2"), QFileInfo(first).canonicalFilePath());
+}
+
+void AvatarStoreTest::testCleanedUpObject()
+{
+    const QString object = AvatarStore::insert("crop-1", "data");
+    QVERIFY(QFile::remove(object));
+
+    // The key is left dangling, as after the cache was cleaned
+    QVERIFY(AvatarStore::find("crop-1").isEmpty());
+    QCOMPARE(AvatarStore::insert("crop-1", "data"), object);
+    QCOMPARE(AvatarStore::find("crop-1"), QFileInfo(object).canonicalFilePath());
+}
+
+void AvatarStoreTest::testContentHash()
+{
+    const QString a = m_dir->filePath(QStringLiteral("a"));
+    const QString b = m_dir->filePath(QStringLiteral("b"));
+    const QString c = m_dir->filePath(QStringLiteral("c"));
+    write(a, "face");
+    write(b, "face");
+    write(c, "fact");
+
+    QCOMPARE(AvatarStore::contentHash(a), QCryptographicHash::hash("face", QCryptographicHash::Sha256).toHex());
+    QVERIFY(AvatarStore::contentHash(m_dir->filePath(QStringLiteral("missing"))).isEmpty());
+    QVERIFY(AvatarStore::contentHash(m_dir->path()).isEmpty());
+
+    QVERIFY(AvatarStore::sameContent(a, b));
+    QVERIFY(!AvatarStore::sameContent(a, c));
+    QVERIFY(!AvatarStore::sameContent(a, m_dir->filePath(QStringLiteral("missing"))));
+
+    // Rewritten with the same size, the remembered hash goes with the old mtime
+    write(b, "fact");
+    QFile file(b);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.setFileTime(QDateTime::currentDateTime().addSecs(10), QFileDevice::FileModificationTime));
+    file.close();
+    QVERIFY(!AvatarStore::sameContent(a, b));
+    QVERIFY(AvatarStore::sameContent(b, c));
+}
+
+QTEST_GUILESS_MAIN(AvatarStoreTest)
+
+#include "avatarstoretest.moc"
@@ -0,0 +1,186 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "lib/datachangecoalescer.h"
+
+#include <QSignalSpy>
+#include <QStringListModel>
+#include <QTest>
+
+class DataChangeCoalescerTest : public QObject
+{
+    Q_OBJECT
+    private Q_SLOTS:
+        void init();
+        void cleanup();
+
+        void testMerge();
+        void testInsertAbove();
+        void testInsertInside();
+        void testRemove();
+        void testMove();
+        void testLayoutChanged();
+        void testTimer();
+
+    private:
+        /* Text of the first and last row of each dataChanged, the rows are named after their initial position */
+        QStringList flushed();
+
+        QStringListModel* m_model = nullptr;
+        DataChangeCoalescer* m_coalescer = nullptr;
+        QSignalSpy* m_spy = nullptr;
+};
+
+void DataChangeCoalescerTest::init()
+{
+    QStringList rows;
+    for (int row = 0; row < 10; ++row) {
+        rows << QString::number(row);
+    }
+    m_model = new QStringListModel(rows);
+    m_coalescer = new DataChangeCoalescer(m_model);
+    m_spy = new QSignalSpy(m_coalescer, &DataChangeCoalescer::dataChanged);
+}
+
+void DataChangeCoalescerTest::cleanup()
+{
+    delete m_spy;
+    m_spy = nullptr;
+    // Owns the coalescer
+    delete m_model;
+    m_model = nullptr;
+    m_coalescer = nullptr;
+}
+
+QStringList DataChangeCoalescerTest::flushed()
+{
+    m_spy->clear();
+    m_coalescer->flush();
+
+    QStringList ranges;
+    for (const QList<QVariant> &signal : qAsConst(*m_spy)) {
+        const QModelIndex first = signal.at(0).toModelIndex();
+        const QModelIndex last = signal.at(1).toModelIndex();
+        ranges << first.data().toString() + QLatin1Char('-') + last.data().toString();
+    }
+    return ranges;
+}
+
+void DataChangeCoalescerTest::testMerge()
+{
+    m_coalescer->add(2, {Qt::DisplayRole});
+    m_coalescer->add(3, {Qt::ToolTipRole});
+    m_coalescer->add(4, 5);
+    m_coalescer->add(8);
+    // Out of range, counted but never emitted
+    m_coalescer->add(20);
+
+    QCOMPARE(flushed(), QStringList({QStringLiteral("2-5"), QStringLiteral("8-8")}));
+    // Merged with a range for every role, so all of them
+    QVERIFY(m_spy->at(0).at(2).value<QVector<int>>().isEmpty());
+    QCOMPARE(m_coalescer->requestedCount(), quint64(5));
+    QCOMPARE(m_coalescer->emittedCount(), quint64(2));
+
+    // Nothing pending, nothing emitted
+    QVERIFY(flushed().isEmpty());
+    QCOMPARE(m_coalescer->emittedCount(), quint64(2));
+}
+
+void DataChangeCoalescerTest::testInsertAbove()
+{
+    m_coalescer->add(3, 4);
+    QVERIFY(m_model->insertRows(0, 2));
+    QCOMPARE(flushed(), QStringList({QStringLiteral("3-4")}));
+}
+
+void DataChangeCoalescerTest::testInsertInside()
+{
+    m_coalescer->add(2, 5);
+    QVERIFY(m_model->insertRows(4, 2));
+
+    // The new rows are not reported, the range around them goes out in two parts
+    QCOMPARE(flushed(), QStringList({QStringLiteral("2-3"), QStringLiteral("4-5")}));
+    QCOMPARE(m_spy->at(1).at(0).toModelIndex().row(), 6);
+    QCOMPARE(m_coalescer->requestedCount(), quint64(1));
+    QCOMPARE(m_coalescer->emittedCount(), quint64(2));
+}
+
+void DataChangeCoalescerTest::testRemove()
+{
+    m_coalescer->add(2, 6);
+    m_coalescer->add(8);
+    m_coalescer->add(1);
+    QVERIFY(m_model->removeRows(3, 2));
+    QVERIFY(m_model->removeRows(0, 2));
+
+    // Row 1 is gone, what is left of 2-6 is contiguous again
+    QCOMPARE(flushed(), QStringList({QStringLiteral("2-6"), QStringLiteral("8-8")}));
+    QCOMPARE(m_spy->at(0).at(0).toModelIndex().row(), 0);
+}
+
+void DataChangeCoalescerTest::testMove()
+{
+    m_coalescer->add(1);
+    m_coalescer->add(7);
+    // Down past its destination and up before it, the other rows shift around them
+    QVERIFY(m_model->moveRows(QModelIndex(), 1, 1, QModelIndex(), 5));
+    QVERIFY(m_model->moveRows(QModelIndex(), 7, 1, QModelIndex(), 2));
+
+    QStringList ranges = flushed();
+    QCOMPARE(ranges.count(), 2);
+    ranges.sort();
+    QCOMPARE(ranges, QStringList({QStringLiteral("1-1"), QStringLiteral("7-7")}));
+
+    // A range with a row moved out of its middle
+    m_coalescer->add(0, 4);
+    const QString moved = m_model->index(2, 0).data().toString();
+    QVERIFY(m_model->moveRows(QModelIndex(), 2, 1, QModelIndex(), 9));
+    m_spy->clear();
+    m_coalescer->flush();
+    QStringList rows;
+    for (const QList<QVariant> &signal : qAsConst(*m_spy)) {
+        for (int row = signal.at(0).toModelIndex().row(); row <= signal.at(1).toModelIndex().row(); ++row) {
+            rows << m_model->index(row, 0).data().toString();
+        }
+    }
+    QCOMPARE(rows.count(), 5);
+    QVERIFY(rows.contains(moved));
+}
+
+void DataChangeCoalescerTest::testLayoutChanged()
+{
+    m_coalescer->add(3, {Qt::DisplayRole});
+    m_coalescer->add(6, {Qt::ToolTipRole});
+    Q_EMIT m_model->layoutChanged();
+
+    QCOMPARE(flushed(), QStringList({QStringLiteral("0-9")}));
+    QCOMPARE(m_spy->at(0).at(2).value<QVector<int>>(), QVector<int>({Qt::DisplayRole, Qt::ToolTipRole}));
+}
+
+void DataChangeCoalescerTest::testTimer()
+{
+    m_coalescer->add(1);
+    m_coalescer->add(2);
+    QVERIFY(m_spy->isEmpty());
+    QVERIFY(m_spy->wait());
+    QCOMPARE(m_spy->count(), 1);
+}
+
+QTEST_GUILESS_MAIN(DataChangeCoalescerTest)
+
+#include "datachangecoalescertest.moc"
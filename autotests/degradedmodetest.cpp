@@ -0,0 +1,193 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "fakeaccountsservice.h"
+#include "lib/accountmodel.h"
+#include "lib/accountsnapshot.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTest>
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+// Short enough to keep the test fast, long enough not to trip over a loaded machine
+static const int s_callTimeout = 300;
+
+static void setupEnvironment()
+{
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+}
+Q_CONSTRUCTOR_FUNCTION(setupEnvironment)
+
+class DegradedModeTest : public QObject
+{
+    Q_OBJECT
+    private Q_SLOTS:
+        void initTestCase();
+        void init();
+        void cleanup();
+
+        void testSlowServiceWithinDeadline();
+        void testDegradesWhenDeadlineMissed();
+        void testHungServiceStaysDegraded();
+        void testConstructorDoesNotBlock();
+
+    private:
+        void waitForUsers(AccountModel *model);
+
+        FakeAccountsService* m_service = nullptr;
+};
+
+void DegradedModeTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    if (!FakeAccountsService::redirectSystemBus()) {
+        QSKIP("No session bus to run the fake accountsservice on");
+    }
+
+    KSharedConfig::Ptr config = KSharedConfig::openConfig(QStringLiteral("kcm_usermanagerrc"));
+    config->group("DBus").writeEntry("CallTimeout", s_callTimeout);
+    config->sync();
+}
+
+void DegradedModeTest::init()
+{
+    // Every model has to go through the service, not start from the last one's snapshot
+    QFile::remove(AccountSnapshot::defaultFileName());
+
+    m_service = new FakeAccountsService(this);
+    m_service->addUser(2001, QStringLiteral("alice"), QStringLiteral("Alice Liddell"));
+    m_service->addUser(2002, QStringLiteral("bob"), QStringLiteral("Bob Cratchit"));
+    QVERIFY(m_service->start());
+}
+
+void DegradedModeTest::cleanup()
+{
+    delete m_service;
+    m_service = nullptr;
+    QFile::remove(AccountSnapshot::defaultFileName());
+}
+
+void DegradedModeTest::waitForUsers(AccountModel *model)
+{
+    QTRY_COMPARE_WITH_TIMEOUT(model->data(model->index(0, 0), AccountModel::Username).toString(), QStringLiteral("alice"), 5000);
+    QTRY_COMPARE_WITH_TIMEOUT(model->data(model->index(1, 0), AccountModel::Username).toString(), QStringLiteral("bob"), 5000);
+}
+
+void DegradedModeTest::testSlowServiceWithinDeadline()
+{
+    m_service->setLatency(s_callTimeout / 3);
+
+    AccountModel model(nullptr);
+    QSignalSpy degraded(&model, &AccountModel::degradedChanged);
+    QCOMPARE(model.callTimeout(), s_callTimeout);
+
+    waitForUsers(&model);
+    QCOMPARE(model.data(model.index(0, 0), Qt::DisplayRole).toString(), QStringLiteral("Alice Liddell"));
+    QVERIFY(!model.isDegraded());
+    QCOMPARE(degraded.count(), 0);
+}
+
+void DegradedModeTest::testDegradesWhenDeadlineMissed()
+{
+    AccountModel model(nullptr);
+    QSignalSpy degraded(&model, &AccountModel::degradedChanged);
+    waitForUsers(&model);
+
+    m_service->setLatency(s_callTimeout * 4);
+    const QModelIndex alice = model.index(0, 0);
+
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(model.setData(alice, QStringLiteral("Alice"), AccountModel::RealName));
+    QVERIFY(timer.elapsed() < s_callTimeout);
+
+    QVERIFY(degraded.wait(s_callTimeout * 4));
+    QCOMPARE(degraded.first().first().toBool(), true);
+    QVERIFY(model.isDegraded());
+
+    // Read-only, but what is cached is still shown
+    QVERIFY(!model.setData(alice, QStringLiteral("Alice Again"), AccountModel::RealName));
+    QCOMPARE(model.data(alice, AccountModel::Username).toString(), QStringLiteral("alice"));
+    QCOMPARE(model.data(model.index(1, 0), Qt::DisplayRole).toString(), QStringLiteral("Bob Cratchit"));
+
+    // Once the service is quick again the probe lifts the read-only mode. Calls sent
+    // before that still miss their deadline, let them run out first.
+    m_service->setLatency(0);
+    QTest::qWait(s_callTimeout * 2);
+    QTRY_VERIFY_WITH_TIMEOUT(!model.isDegraded(), s_callTimeout * 10);
+    QCOMPARE(degraded.last().first().toBool(), false);
+    QVERIFY(model.setData(alice, QStringLiteral("Alice Again"), AccountModel::RealName));
+}
+
+void DegradedModeTest::testHungServiceStaysDegraded()
+{
+    AccountModel model(nullptr);
+    QSignalSpy degraded(&model, &AccountModel::degradedChanged);
+    waitForUsers(&model);
+
+    // The bus still answers Peer.Ping for a hung service, the probe must not be fooled
+    m_service->setHung(true);
+    QVERIFY(model.setData(model.index(0, 0), QStringLiteral("Alice"), AccountModel::RealName));
+    QVERIFY(degraded.wait(s_callTimeout * 4));
+    QVERIFY(model.isDegraded());
+
+    const int probes = m_service->callCount(QStringLiteral("Get"));
+    QTest::qWait(s_callTimeout * 8);
+    QVERIFY(m_service->callCount(QStringLiteral("Get")) > probes);
+    QVERIFY(model.isDegraded());
+    QCOMPARE(degraded.count(), 1);
+
+    // Answering again, the list is resynced as signals may have been lost meanwhile
+    const int resyncs = m_service->callCount(QStringLiteral("ListCachedUsers"));
+    m_service->setHung(false);
+    QTest::qWait(s_callTimeout * 2);
+    QTRY_VERIFY_WITH_TIMEOUT(!model.isDegraded(), s_callTimeout * 10);
+    QTRY_VERIFY_WITH_TIMEOUT(m_service->callCount(QStringLiteral("ListCachedUsers")) > resyncs, s_callTimeout * 4);
+}
+
+void DegradedModeTest::testConstructorDoesNotBlock()
+{
+    m_service->setHung(true);
+
+    QElapsedTimer timer;
+    timer.start();
+    AccountModel model(nullptr);
+    QVERIFY(timer.elapsed() < s_callTimeout);
+
+    QSignalSpy degraded(&model, &AccountModel::degradedChanged);
+    QVERIFY(degraded.wait(s_callTimeout * 4));
+    QVERIFY(model.isDegraded());
+
+    // Nothing listed yet, only the "new user" row, and it stays usable
+    QCOMPARE(model.rowCount(), 1);
+    QVERIFY(!model.data(model.index(0, 0), AccountModel::Created).toBool());
+
+    m_service->setHung(false);
+    QTest::qWait(s_callTimeout * 2);
+    QTRY_VERIFY_WITH_TIMEOUT(!model.isDegraded(), s_callTimeout * 10);
+    waitForUsers(&model);
+}
+
+QTEST_MAIN(DegradedModeTest)
+
+#include "degradedmodetest.moc"
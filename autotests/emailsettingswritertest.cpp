@@ -0,0 +1,95 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "lib/emailsettingswriter.h"
+
+#include <QFile>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTest>
+
+class EmailSettingsWriterTest : public QObject
+{
+    Q_OBJECT
+    private Q_SLOTS:
+        void initTestCase();
+        void init();
+
+        void testBatch();
+        void testWhileWriting();
+        void testWrittenOnDestruction();
+};
+
+void EmailSettingsWriterTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void EmailSettingsWriterTest::init()
+{
+    QFile::remove(QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation) + QStringLiteral("/emaildefaults"));
+}
+
+void EmailSettingsWriterTest::testBatch()
+{
+    EmailSettingsWriter writer;
+    QSignalSpy spy(&writer, &EmailSettingsWriter::written);
+
+    // What AccountInfo::save() does, with a change of mind in between
+    writer.set(KEMailSettings::RealName, QStringLiteral("Someone Else"));
+    writer.set(KEMailSettings::EmailAddress, QStringLiteral("someone@example.org"));
+    writer.set(KEMailSettings::RealName, QStringLiteral("Some One"));
+    QCOMPARE(writer.writeCount(), 0);
+
+    QVERIFY(spy.wait());
+    QCOMPARE(writer.writeCount(), 1);
+    QVERIFY(!spy.wait(100));
+
+    const KEMailSettings settings;
+    QCOMPARE(settings.getSetting(KEMailSettings::RealName), QStringLiteral("Some One"));
+    QCOMPARE(settings.getSetting(KEMailSettings::EmailAddress), QStringLiteral("someone@example.org"));
+}
+
+void EmailSettingsWriterTest::testWhileWriting()
+{
+    EmailSettingsWriter writer;
+    QSignalSpy spy(&writer, &EmailSettingsWriter::written);
+
+    writer.set(KEMailSettings::RealName, QStringLiteral("First"));
+    QTRY_COMPARE(writer.writeCount(), 1);
+
+    // Queued behind the running write, never alongside it
+    writer.set(KEMailSettings::RealName, QStringLiteral("Second"));
+    QTRY_COMPARE(spy.count(), 2);
+    QCOMPARE(writer.writeCount(), 2);
+    QCOMPARE(KEMailSettings().getSetting(KEMailSettings::RealName), QStringLiteral("Second"));
+}
+
+void EmailSettingsWriterTest::testWrittenOnDestruction()
+{
+    {
+        EmailSettingsWriter writer;
+        writer.set(KEMailSettings::EmailAddress, QStringLiteral("last@example.org"));
+    }
+
+    QCOMPARE(KEMailSettings().getSetting(KEMailSettings::EmailAddress), QStringLiteral("last@example.org"));
+}
+
+QTEST_GUILESS_MAIN(EmailSettingsWriterTest)
+
+#include "emailsettingswritertest.moc"
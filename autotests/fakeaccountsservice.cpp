@@ -0,0 +1,199 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "fakeaccountsservice.h"
+
+#include <QDBusError>
+#include <QDBusMessage>
+#include <QDBusObjectPath>
+#include <QDBusVariant>
+#include <QTimer>
+
+static const char s_service[] = "org.freedesktop.Accounts";
+static const char s_path[] = "/org/freedesktop/Accounts";
+static const char s_userInterface[] = "org.freedesktop.Accounts.User";
+static const char s_propertiesInterface[] = "org.freedesktop.DBus.Properties";
+static const char s_connectionName[] = "fake-accountsservice";
+
+FakeAccountsService::FakeAccountsService(QObject* parent)
+ : QDBusVirtualObject(parent)
+ , m_connection(QString::fromLatin1(s_connectionName))
+{
+}
+
+FakeAccountsService::~FakeAccountsService()
+{
+    if (m_connection.isConnected()) {
+        m_connection.unregisterService(QString::fromLatin1(s_service));
+        m_connection.unregisterObject(QString::fromLatin1(s_path), QDBusConnection::UnregisterTree);
+    }
+    QDBusConnection::disconnectFromBus(QString::fromLatin1(s_connectionName));
+}
+
+bool FakeAccountsService::redirectSystemBus()
+{
+    const QByteArray sessionBus = qgetenv("DBUS_SESSION_BUS_ADDRESS");
+    if (sessionBus.isEmpty()) {
+        return false;
+    }
+
+    qputenv("DBUS_SYSTEM_BUS_ADDRESS", sessionBus);
+    return true;
+}
+
+bool FakeAccountsService::start()
+{
+    m_connection = QDBusConnection::connectToBus(QDBusConnection::SessionBus, QString::fromLatin1(s_connectionName));
+    if (!m_connection.isConnected()) {
+        return false;
+    }
+
+    // One handler for the manager and every user object below it
+    if (!m_connection.registerVirtualObject(QString::fromLatin1(s_path), this, QDBusConnection::SubPath)) {
+        return false;
+    }
+    return m_connection.registerService(QString::fromLatin1(s_service));
+}
+
+void FakeAccountsService::addUser(uint uid, const QString& userName, const QString& realName)
+{
+    m_users.insert(userPath(uid), {
+        {QStringLiteral("Uid"), qulonglong(uid)},
+        {QStringLiteral("UserName"), userName},
+        {QStringLiteral("RealName"), realName},
+        {QStringLiteral("Email"), QString()},
+        {QStringLiteral("IconFile"), QString()},
+        {QStringLiteral("HomeDirectory"), QString()},
+        {QStringLiteral("AccountType"), 0},
+        {QStringLiteral("Locked"), false},
+        {QStringLiteral("SystemAccount"), false}
+    });
+}
+
+QString FakeAccountsService::userPath(uint uid)
+{
+    return QLatin1String(s_path) + QLatin1String("/User") + QString::number(uid);
+}
+
+void FakeAccountsService::setLatency(int msec)
+{
+    m_latency = msec;
+}
+
+void FakeAccountsService::setHung(bool hung)
+{
+    m_hung = hung;
+}
+
+int FakeAccountsService::callCount(const QString& member) const
+{
+    return m_calls.value(member);
+}
+
+QString FakeAccountsService::introspect(const QString& path) const
+{
+    if (path == QLatin1String(s_path)) {
+        return QStringLiteral("<interface name=\"org.freedesktop.Accounts\"/>");
+    }
+    if (m_users.contains(path)) {
+        return QStringLiteral("<interface name=\"org.freedesktop.Accounts.User\"/>");
+    }
+    return QString();
+}
+
+bool FakeAccountsService::handleMessage(const QDBusMessage& message, const QDBusConnection& connection)
+{
+    Q_UNUSED(connection)
+    if (message.type() != QDBusMessage::MethodCallMessage) {
+        return false;
+    }
+
+    const QString path = message.path();
+    const QString member = message.member();
+    const QVariantList arguments = message.arguments();
+    ++m_calls[member];
+
+    // Taken off the bus and never answered, callers run into their deadline
+    if (m_hung) {
+        return true;
+    }
+
+    if (message.interface() == QLatin1String(s_propertiesInterface)) {
+        if (member == QLatin1String("Get") && arguments.count() == 2) {
+            const QString property = arguments.at(1).toString();
+            if (path == QLatin1String(s_path) && property == QLatin1String("DaemonVersion")) {
+                send(message.createReply(QVariant::fromValue(QDBusVariant(QStringLiteral("0.6.55")))));
+                return true;
+            }
+            const auto user = m_users.constFind(path);
+            if (user != m_users.constEnd() && user->contains(property)) {
+                send(message.createReply(QVariant::fromValue(QDBusVariant(user->value(property)))));
+                return true;
+            }
+        } else if (member == QLatin1String("GetAll") && m_users.contains(path)) {
+            send(message.createReply(QVariant(m_users.value(path))));
+            return true;
+        }
+        send(message.createErrorReply(QDBusError::InvalidArgs, QStringLiteral("No such property")));
+        return true;
+    }
+
+    if (path == QLatin1String(s_path)) {
+        if (member == QLatin1String("ListCachedUsers")) {
+            QList<QDBusObjectPath> users;
+            for (auto it = m_users.constBegin(); it != m_users.constEnd(); ++it) {
+                users.append(QDBusObjectPath(it.key()));
+            }
+            send(message.createReply(QVariant::fromValue(users)));
+            return true;
+        }
+        if (member == QLatin1String("FindUserById") && !arguments.isEmpty()) {
+            const QString user = userPath(uint(arguments.first().toLongLong()));
+            if (m_users.contains(user)) {
+                send(message.createReply(QVariant::fromValue(QDBusObjectPath(user))));
+            } else {
+                send(message.createErrorReply(QStringLiteral("org.freedesktop.Accounts.Error.Failed"), QStringLiteral("Failed to look up user")));
+            }
+            return true;
+        }
+    }
+
+    // SetRealName(), SetEmail()... store the value and tell about it like the real one
+    auto user = m_users.find(path);
+    if (user != m_users.end() && member.startsWith(QLatin1String("Set")) && !arguments.isEmpty()) {
+        user->insert(member.mid(3), arguments.first());
+        send(message.createReply());
+        send(QDBusMessage::createSignal(path, QString::fromLatin1(s_userInterface), QStringLiteral("Changed")));
+        return true;
+    }
+
+    send(message.createErrorReply(QDBusError::UnknownMethod, QStringLiteral("Not faked: ") + member));
+    return true;
+}
+
+void FakeAccountsService::send(const QDBusMessage& message)
+{
+    if (m_latency <= 0) {
+        m_connection.send(message);
+        return;
+    }
+
+    QTimer::singleShot(m_latency, this, [this, message]() {
+        m_connection.send(message);
+    });
+}
@@ -0,0 +1,68 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#ifndef FAKE_ACCOUNTS_SERVICE_H
+#define FAKE_ACCOUNTS_SERVICE_H
+
+#include <QDBusConnection>
+#include <QDBusVirtualObject>
+#include <QHash>
+#include <QMap>
+#include <QVariantMap>
+
+/**
+ * Stands in for accountsservice on the session bus. Replies can be held back for
+ * a while, or forever, the way a service whose main loop is stuck behaves: the
+ * bus library still answers Peer.Ping, but no method call or property.
+ */
+class FakeAccountsService : public QDBusVirtualObject
+{
+    Q_OBJECT
+    public:
+        explicit FakeAccountsService(QObject* parent = nullptr);
+        ~FakeAccountsService() override;
+
+        /**
+         * Makes QDBusConnection::systemBus() connect to the session bus. Has to
+         * run before anything in the process touched the system bus.
+         */
+        static bool redirectSystemBus();
+
+        bool start();
+
+        void addUser(uint uid, const QString &userName, const QString &realName);
+        static QString userPath(uint uid);
+
+        void setLatency(int msec);
+        void setHung(bool hung);
+        int callCount(const QString &member) const;
+
+        QString introspect(const QString &path) const override;
+        bool handleMessage(const QDBusMessage &message, const QDBusConnection &connection) override;
+
+    private:
+        void send(const QDBusMessage &message);
+
+        QDBusConnection m_connection;
+        QMap<QString, QVariantMap> m_users;
+        QHash<QString, int> m_calls;
+        int m_latency = 0;
+        bool m_hung = false;
+};
+
+#endif //FAKE_ACCOUNTS_SERVICE_H
@@ -0,0 +1,166 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "lib/fileinstaller.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <sys/stat.h>
+
+class FileInstallerTest : public QObject
+{
+    Q_OBJECT
+    private Q_SLOTS:
+        void init();
+        void cleanup();
+
+        void testInstall();
+        void testUnchanged();
+        void testReplace();
+        void testMissingSource();
+        void testLink();
+
+    private:
+        void write(const QString &path, const QByteArray &data);
+        QByteArray read(const QString &path) const;
+        quint64 inode(const QString &path) const;
+
+        QTemporaryDir* m_dir = nullptr;
+        QString m_source;
+        QString m_destination;
+};
+
+void FileInstallerTest::init()
+{
+    m_dir = new QTemporaryDir;
+    QVERIFY(m_dir->isValid());
+    m_source = m_dir->filePath(QStringLiteral("source"));
+    m_destination = m_dir->filePath(QStringLiteral("destination"));
+}
+
+void FileInstallerTest::cleanup()
+{
+    delete m_dir;
+    m_dir = nullptr;
+}
+
+void FileInstallerTest::write(const QString &path, const QByteArray &data)
+{
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QCOMPARE(file.write(data), qint64(data.size()));
+}
+
+QByteArray FileInstallerTest::read(const QString &path) const
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+quint64 FileInstallerTest::inode(const QString &path) const
+{
+    struct stat st;
+    return stat(QFile::encodeName(path).constData(), &st) == 0 ? st.st_ino : 0;
+}
+
+void FileInstallerTest::testInstall()
+{
+    // More than one chunk of the read and write fallback, and not a multiple of it
+    QByteArray data;
+    for (int i = 0; data.size() < 200 * 1024 + 17; ++i) {
+        data += QByteArray::number(i);
+    }
+    write(m_source, data);
+
+    QCOMPARE(FileInstaller::install(m_source, m_destination, 0600), FileInstaller::Installed);
+    QCOMPARE(read(m_destination), data);
+
+    struct stat st;
+    QCOMPARE(stat(QFile::encodeName(m_destination).constData(), &st), 0);
+    QCOMPARE(int(st.st_mode & 0777), 0600);
+
+    // Nothing left next to it
+    QCOMPARE(QDir(m_dir->path()).entryList(QDir::Files).count(), 2);
+}
+
+void FileInstallerTest::testUnchanged()
+{
+    write(m_source, "face");
+    QCOMPARE(FileInstaller::install(m_source, m_destination), FileInstaller::Installed);
+    const quint64 installed = inode(m_destination);
+    QVERIFY(installed);
+
+    // Same content, the file is left alone
+    QCOMPARE(FileInstaller::install(m_source, m_destination), FileInstaller::Unchanged);
+    QCOMPARE(inode(m_destination), installed);
+
+    // Same size, other content
+    write(m_source, "fact");
+    QCOMPARE(FileInstaller::install(m_source, m_destination), FileInstaller::Installed);
+    QCOMPARE(read(m_destination), QByteArray("fact"));
+}
+
+void FileInstallerTest::testReplace()
+{
+    write(m_destination, "an older and longer face");
+    write(m_source, "face");
+
+    // Renamed over, whoever still has the old file open keeps reading the old content
+    QFile old(m_destination);
+    QVERIFY(old.open(QIODevice::ReadOnly));
+    QCOMPARE(FileInstaller::install(m_source, m_destination), FileInstaller::Installed);
+    QCOMPARE(read(m_destination), QByteArray("face"));
+    QCOMPARE(old.readAll(), QByteArray("an older and longer face"));
+}
+
+void FileInstallerTest::testMissingSource()
+{
+    write(m_destination, "face");
+    QCOMPARE(FileInstaller::install(m_dir->filePath(QStringLiteral("missing")), m_destination), FileInstaller::Failed);
+    QCOMPARE(read(m_destination), QByteArray("face"));
+
+    // Nowhere to write to
+    write(m_source, "face");
+    QCOMPARE(FileInstaller::install(m_source, m_dir->filePath(QStringLiteral("missing/destination"))), FileInstaller::Failed);
+}
+
+void FileInstallerTest::testLink()
+{
+    write(m_source, "face");
+    const QString link = m_dir->filePath(QStringLiteral("link"));
+
+    QCOMPARE(FileInstaller::link(m_source, link), FileInstaller::Installed);
+    QCOMPARE(QFileInfo(link).symLinkTarget(), m_source);
+    QCOMPARE(FileInstaller::link(m_source, link), FileInstaller::Unchanged);
+
+    // Replaces a link elsewhere and a regular file alike
+    QCOMPARE(FileInstaller::link(m_destination, link), FileInstaller::Installed);
+    QCOMPARE(QFileInfo(link).symLinkTarget(), m_destination);
+    write(m_destination, "face");
+    QCOMPARE(FileInstaller::link(m_source, m_destination), FileInstaller::Installed);
+    QVERIFY(QFileInfo(m_destination).isSymLink());
+    QCOMPARE(read(m_destination), QByteArray("face"));
+}
+
+QTEST_GUILESS_MAIN(FileInstallerTest)
+
+#include "fileinstallertest.moc"
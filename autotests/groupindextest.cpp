@@ -0,0 +1,139 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "lib/groupindex.h"
+
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <cstdio>
+#include <pwd.h>
+#include <unistd.h>
+
+class GroupIndexTest : public QObject
+{
+    Q_OBJECT
+    private Q_SLOTS:
+        void initTestCase();
+        void init();
+        void cleanup();
+
+        void testMembership();
+        void testPrimaryGroup();
+        void testReplacedFile();
+
+    private:
+        void write(const QByteArray &data);
+
+        QTemporaryDir* m_dir = nullptr;
+        QString m_path;
+        QByteArray m_user;
+        uint m_gid = 0;
+};
+
+void GroupIndexTest::initTestCase()
+{
+    // The primary group comes from the passwd entry of whoever runs the test
+    const struct passwd *pw = getpwuid(getuid());
+    QVERIFY(pw);
+    m_user = pw->pw_name;
+    m_gid = pw->pw_gid;
+}
+
+void GroupIndexTest::init()
+{
+    m_dir = new QTemporaryDir;
+    QVERIFY(m_dir->isValid());
+    m_path = m_dir->filePath(QStringLiteral("group"));
+}
+
+void GroupIndexTest::cleanup()
+{
+    delete m_dir;
+    m_dir = nullptr;
+}
+
+void GroupIndexTest::write(const QByteArray &data)
+{
+    // Written next to it and renamed over, as groupadd does
+    const QString temporary = m_path + QStringLiteral(".new");
+    QFile file(temporary);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QCOMPARE(file.write(data), qint64(data.size()));
+    file.close();
+    QCOMPARE(::rename(QFile::encodeName(temporary).constData(), QFile::encodeName(m_path).constData()), 0);
+}
+
+void GroupIndexTest::testMembership()
+{
+    write("# comment\n"
+          "wheel:x:10:alice,bob\n"
+          "audio:x:63:bob,alice,bob\n"
+          "video:x:39:\n"
+          "broken line\n");
+
+    GroupIndex index(m_path);
+    QCOMPARE(index.groups(), QStringList({QStringLiteral("audio"), QStringLiteral("video"), QStringLiteral("wheel")}));
+    QCOMPARE(index.groupsOf(QStringLiteral("bob")), QStringList({QStringLiteral("audio"), QStringLiteral("wheel")}));
+    // Listed twice, counted once
+    QCOMPARE(index.membersOf(QStringLiteral("audio")), QStringList({QStringLiteral("bob"), QStringLiteral("alice")}));
+    QVERIFY(index.membersOf(QStringLiteral("video")).isEmpty());
+    QVERIFY(index.contains(QStringLiteral("video")));
+    QVERIFY(!index.contains(QStringLiteral("broken line")));
+    QVERIFY(index.groupsOf(QStringLiteral("nobody-here")).isEmpty());
+}
+
+void GroupIndexTest::testPrimaryGroup()
+{
+    const QString user = QString::fromLocal8Bit(m_user);
+    write("zzz:x:" + QByteArray::number(m_gid) + ":\n"
+          "audio:x:" + QByteArray::number(m_gid + 1) + ":" + m_user + "\n");
+
+    GroupIndex index(m_path);
+    QCOMPARE(index.primaryGroupOf(user), QStringLiteral("zzz"));
+    // First, although it sorts last and the group file does not list the user in it
+    QCOMPARE(index.groupsOf(user), QStringList({QStringLiteral("zzz"), QStringLiteral("audio")}));
+
+    // Listed as a member of its primary group too, still only once
+    write("zzz:x:" + QByteArray::number(m_gid) + ":" + m_user + "\n");
+    QTRY_COMPARE(index.groupsOf(user), QStringList({QStringLiteral("zzz")}));
+}
+
+void GroupIndexTest::testReplacedFile()
+{
+    write("wheel:x:10:alice\n");
+
+    GroupIndex index(m_path);
+    QSignalSpy spy(&index, &GroupIndex::groupsChanged);
+
+    write("wheel:x:10:alice,bob\n");
+    QVERIFY(spy.wait());
+    QCOMPARE(spy.last().at(0).toStringList(), QStringList({QStringLiteral("bob")}));
+    QCOMPARE(index.membersOf(QStringLiteral("wheel")), QStringList({QStringLiteral("alice"), QStringLiteral("bob")}));
+
+    // Still watched after the replacement
+    write("wheel:x:10:bob\n");
+    QVERIFY(spy.wait());
+    QCOMPARE(spy.last().at(0).toStringList(), QStringList({QStringLiteral("alice")}));
+}
+
+QTEST_GUILESS_MAIN(GroupIndexTest)
+
+#include "groupindextest.moc"
@@ -0,0 +1,173 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "lib/homeusagescanner.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QSet>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const uint s_uid = 1000;
+
+class HomeUsageScannerTest : public QObject
+{
+    Q_OBJECT
+    private Q_SLOTS:
+        void init();
+        void cleanup();
+
+        void testHardlinks();
+        void testSubdirectoryChange();
+        void testCancel();
+
+    private:
+        void write(const QString &path, int size);
+        qint64 expectedUsage() const;
+        qint64 scan(HomeUsageScanner *scanner);
+
+        QTemporaryDir* m_dir = nullptr;
+        QString m_home;
+};
+
+void HomeUsageScannerTest::init()
+{
+    m_dir = new QTemporaryDir;
+    QVERIFY(m_dir->isValid());
+    m_home = m_dir->path();
+    QVERIFY(QDir(m_home).mkpath(QStringLiteral("sub/deeper")));
+}
+
+void HomeUsageScannerTest::cleanup()
+{
+    delete m_dir;
+    m_dir = nullptr;
+}
+
+void HomeUsageScannerTest::write(const QString &path, int size)
+{
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QCOMPARE(file.write(QByteArray(size, 'x')), qint64(size));
+}
+
+/*
+ * What du reports for the home: allocated blocks, each inode once.
+ */
+qint64 HomeUsageScannerTest::expectedUsage() const
+{
+    QStringList paths = {m_home};
+    QDirIterator it(m_home, QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        paths.append(it.next());
+    }
+
+    qint64 bytes = 0;
+    QSet<quint64> inodes;
+    for (const QString &path : qAsConst(paths)) {
+        struct stat st;
+        if (lstat(QFile::encodeName(path).constData(), &st) != 0 || inodes.contains(st.st_ino)) {
+            continue;
+        }
+        inodes.insert(st.st_ino);
+        bytes += qint64(st.st_blocks) * 512;
+    }
+    return bytes;
+}
+
+qint64 HomeUsageScannerTest::scan(HomeUsageScanner *scanner)
+{
+    QSignalSpy spy(scanner, &HomeUsageScanner::usageReady);
+    scanner->setWanted({{s_uid, m_home}});
+    if (!spy.wait(10000)) {
+        return -1;
+    }
+    return spy.last().at(1).toLongLong();
+}
+
+void HomeUsageScannerTest::testHardlinks()
+{
+    write(m_home + QStringLiteral("/a"), 100000);
+    write(m_home + QStringLiteral("/sub/b"), 50000);
+    QCOMPARE(link(QFile::encodeName(m_home + QStringLiteral("/a")).constData(),
+                  QFile::encodeName(m_home + QStringLiteral("/sub/deeper/a")).constData()), 0);
+
+    // Two names, one inode, counted once
+    HomeUsageScanner scanner;
+    const qint64 expected = expectedUsage();
+    QCOMPARE(scan(&scanner), expected);
+    QCOMPARE(scanner.usage(s_uid), expected);
+    QCOMPARE(scanner.usage(s_uid + 1), qint64(-1));
+}
+
+void HomeUsageScannerTest::testSubdirectoryChange()
+{
+    write(m_home + QStringLiteral("/a"), 100000);
+    write(m_home + QStringLiteral("/sub/deeper/b"), 50000);
+
+    HomeUsageScanner scanner;
+    scanner.setRescanInterval(0);
+    const qint64 before = scan(&scanner);
+    QCOMPARE(before, expectedUsage());
+
+    // Only the deepest directory changes, its parents come from the cache
+    const QString added = m_home + QStringLiteral("/sub/deeper/c");
+    write(added, 200000);
+    QCOMPARE(scan(&scanner), expectedUsage());
+    QVERIFY(scanner.usage(s_uid) > before);
+
+    QVERIFY(QFile::remove(added));
+    QCOMPARE(scan(&scanner), expectedUsage());
+
+    // Without a rescan interval of 0 the result would be kept for a minute
+    scanner.setRescanInterval(60);
+    write(added, 200000);
+    QSignalSpy spy(&scanner, &HomeUsageScanner::usageReady);
+    scanner.setWanted({{s_uid, m_home}});
+    QVERIFY(!spy.wait(200));
+}
+
+void HomeUsageScannerTest::testCancel()
+{
+    for (int i = 0; i < 200; ++i) {
+        const QString dir = m_home + QStringLiteral("/sub/%1").arg(i);
+        QVERIFY(QDir().mkpath(dir));
+        write(dir + QStringLiteral("/file"), 1000);
+    }
+
+    HomeUsageScanner scanner;
+    QSignalSpy spy(&scanner, &HomeUsageScanner::usageReady);
+    scanner.setWanted({{s_uid, m_home}});
+    scanner.cancelAll();
+
+    // Cancelled walks report nothing, and workers waiting for more directories wake up
+    QVERIFY(!spy.wait(200));
+    QCOMPARE(scanner.usage(s_uid), qint64(-1));
+
+    QCOMPARE(scan(&scanner), expectedUsage());
+}
+
+QTEST_GUILESS_MAIN(HomeUsageScannerTest)
+
+#include "homeusagescannertest.moc"
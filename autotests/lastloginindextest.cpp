@@ -0,0 +1,237 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "lib/lastloginindex.h"
+
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <cstring>
+#include <utmp.h>
+
+// Size of the wtmp benchmarkScan() indexes, USER_MANAGER_WTMP_MB=1024 for a busy server's
+static const int s_defaultBenchmarkSize = 64;
+
+static QByteArray record(const char *user, qint64 time, short type = USER_PROCESS)
+{
+    utmp entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.ut_type = type;
+    strncpy(entry.ut_user, user, sizeof(entry.ut_user));
+    strncpy(entry.ut_line, "pts/0", sizeof(entry.ut_line));
+    entry.ut_tv.tv_sec = time;
+    return QByteArray(reinterpret_cast<const char*>(&entry), sizeof(entry));
+}
+
+class LastLoginIndexTest : public QObject
+{
+    Q_OBJECT
+    private Q_SLOTS:
+        void init();
+        void cleanup();
+
+        void testBackwardScan();
+        void testIncrementalTail();
+        void testRotation();
+        void testMissingForAMoment();
+        void testLastlog();
+
+        void benchmarkScan();
+        void benchmarkTail();
+
+    private:
+        void write(const QString &path, const QByteArray &data, QIODevice::OpenMode mode = QIODevice::WriteOnly);
+        void waitForScan(LastLoginIndex *index, int timeout = 5000);
+        QByteArray syntheticWtmp(qint64 size) const;
+
+        QTemporaryDir* m_dir = nullptr;
+        QString m_wtmp;
+        QString m_lastlog;
+};
+
+void LastLoginIndexTest::init()
+{
+    m_dir = new QTemporaryDir;
+    QVERIFY(m_dir->isValid());
+    m_wtmp = m_dir->filePath(QStringLiteral("wtmp"));
+    m_lastlog = m_dir->filePath(QStringLiteral("lastlog"));
+    write(m_lastlog, QByteArray());
+}
+
+void LastLoginIndexTest::cleanup()
+{
+    delete m_dir;
+    m_dir = nullptr;
+}
+
+void LastLoginIndexTest::write(const QString &path, const QByteArray &data, QIODevice::OpenMode mode)
+{
+    QFile file(path);
+    QVERIFY(file.open(mode));
+    QCOMPARE(file.write(data), qint64(data.size()));
+}
+
+void LastLoginIndexTest::waitForScan(LastLoginIndex *index, int timeout)
+{
+    QSignalSpy spy(index, &LastLoginIndex::changed);
+    QVERIFY(spy.wait(timeout));
+}
+
+/*
+ * Logins and logouts of a thousand users, the latest login of userN at N.
+ */
+QByteArray LastLoginIndexTest::syntheticWtmp(qint64 size) const
+{
+    QByteArray data;
+    data.reserve(size);
+    for (int i = 0; data.size() + qint64(sizeof(utmp)) <= size; ++i) {
+        const QByteArray user = "user" + QByteArray::number(i % 1000);
+        data += record(user.constData(), i % 1000, i % 2 ? DEAD_PROCESS : USER_PROCESS);
+    }
+    return data;
+}
+
+void LastLoginIndexTest::testBackwardScan()
+{
+    write(m_wtmp, record("alice", 100)
+                + record("bob", 200)
+                + record("alice", 300)
+                + record("alice", 400, DEAD_PROCESS)
+                + record("", 500)
+                + record("reboot", 600, BOOT_TIME));
+
+    LastLoginIndex index(m_lastlog, m_wtmp);
+    QVERIFY(!index.isReady());
+    waitForScan(&index);
+    QVERIFY(index.isReady());
+
+    QCOMPARE(index.lastLogin(1001, QStringLiteral("alice")).toSecsSinceEpoch(), qint64(300));
+    QCOMPARE(index.lastLogin(1002, QStringLiteral("bob")).toSecsSinceEpoch(), qint64(200));
+    QVERIFY(!index.lastLogin(1003, QStringLiteral("carol")).isValid());
+    QVERIFY(!index.lastLogin(0, QStringLiteral("reboot")).isValid());
+}
+
+void LastLoginIndexTest::testIncrementalTail()
+{
+    write(m_wtmp, record("alice", 100) + record("bob", 200));
+
+    LastLoginIndex index(m_lastlog, m_wtmp);
+    waitForScan(&index);
+
+    // Half a record is left for the next scan
+    const QByteArray carol = record("carol", 400);
+    write(m_wtmp, record("alice", 300) + carol.left(sizeof(utmp) / 2), QIODevice::Append);
+    waitForScan(&index);
+    QCOMPARE(index.lastLogin(1001, QStringLiteral("alice")).toSecsSinceEpoch(), qint64(300));
+    QCOMPARE(index.lastLogin(1002, QStringLiteral("bob")).toSecsSinceEpoch(), qint64(200));
+    QVERIFY(!index.lastLogin(1003, QStringLiteral("carol")).isValid());
+
+    write(m_wtmp, carol.mid(sizeof(utmp) / 2), QIODevice::Append);
+    waitForScan(&index);
+    QCOMPARE(index.lastLogin(1003, QStringLiteral("carol")).toSecsSinceEpoch(), qint64(400));
+    QCOMPARE(index.lastLogin(1001, QStringLiteral("alice")).toSecsSinceEpoch(), qint64(300));
+}
+
+void LastLoginIndexTest::testRotation()
+{
+    write(m_wtmp, record("alice", 100) + record("bob", 200));
+
+    LastLoginIndex index(m_lastlog, m_wtmp);
+    waitForScan(&index);
+
+    // What logrotate does: the old file is moved away and a new one created
+    QVERIFY(QFile::rename(m_wtmp, m_wtmp + QStringLiteral(".1")));
+    write(m_wtmp, record("carol", 300));
+    QTRY_VERIFY(index.lastLogin(1003, QStringLiteral("carol")).isValid());
+    QVERIFY(!index.lastLogin(1001, QStringLiteral("alice")).isValid());
+}
+
+void LastLoginIndexTest::testMissingForAMoment()
+{
+    write(m_wtmp, record("alice", 100));
+
+    LastLoginIndex index(m_lastlog, m_wtmp);
+    waitForScan(&index);
+
+    // Moved away and only recreated once the watch on it is gone
+    QVERIFY(QFile::rename(m_wtmp, m_wtmp + QStringLiteral(".1")));
+    QTest::qWait(200);
+    write(m_wtmp, record("bob", 200));
+    QTRY_VERIFY(index.lastLogin(1002, QStringLiteral("bob")).isValid());
+
+    // And watched again from then on
+    write(m_wtmp, record("carol", 300), QIODevice::Append);
+    QTRY_VERIFY(index.lastLogin(1003, QStringLiteral("carol")).isValid());
+}
+
+void LastLoginIndexTest::testLastlog()
+{
+    write(m_wtmp, record("alice", 100));
+
+    // Sparse, the entry of uid N at N entries in
+    lastlog entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.ll_time = 500;
+    QFile file(m_lastlog);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QVERIFY(file.seek(qint64(1001) * sizeof(entry)));
+    QCOMPARE(file.write(reinterpret_cast<const char*>(&entry), sizeof(entry)), qint64(sizeof(entry)));
+    file.close();
+
+    LastLoginIndex index(m_lastlog, m_wtmp);
+    waitForScan(&index);
+
+    // The later of both files
+    QCOMPARE(index.lastLogin(1001, QStringLiteral("alice")).toSecsSinceEpoch(), qint64(500));
+    QVERIFY(!index.lastLogin(1002, QStringLiteral("bob")).isValid());
+}
+
+void LastLoginIndexTest::benchmarkScan()
+{
+    const qint64 size = qEnvironmentVariableIntValue("USER_MANAGER_WTMP_MB") > 0
+                      ? qEnvironmentVariableIntValue("USER_MANAGER_WTMP_MB") : s_defaultBenchmarkSize;
+    write(m_wtmp, syntheticWtmp(size * 1024 * 1024));
+
+    QBENCHMARK {
+        LastLoginIndex index(m_lastlog, m_wtmp);
+        waitForScan(&index, 60 * 1000);
+        QCOMPARE(index.lastLogin(1000, QStringLiteral("user998")).toSecsSinceEpoch(), qint64(998));
+    }
+}
+
+void LastLoginIndexTest::benchmarkTail()
+{
+    write(m_wtmp, syntheticWtmp(qint64(s_defaultBenchmarkSize) * 1024 * 1024));
+
+    LastLoginIndex index(m_lastlog, m_wtmp);
+    waitForScan(&index);
+
+    // A login appended to a big file costs what the new record costs
+    qint64 time = 1000;
+    QBENCHMARK {
+        write(m_wtmp, record("user0", ++time), QIODevice::Append);
+        waitForScan(&index);
+    }
+    QCOMPARE(index.lastLogin(1000, QStringLiteral("user0")).toSecsSinceEpoch(), time);
+}
+
+QTEST_GUILESS_MAIN(LastLoginIndexTest)
+
+#include "lastloginindextest.moc"
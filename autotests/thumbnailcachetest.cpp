@@ -0,0 +1,147 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "lib/thumbnailcache.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QUrl>
+
+class ThumbnailCacheTest : public QObject
+{
+    Q_OBJECT
+    private Q_SLOTS:
+        void initTestCase();
+        void init();
+        void cleanup();
+
+        void testNormal();
+        void testLarge();
+        void testTooLarge();
+        void testStale();
+
+    private:
+        QString thumbnail(const QString &flavor) const;
+
+        QTemporaryDir* m_dir = nullptr;
+        QString m_path;
+};
+
+void ThumbnailCacheTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void ThumbnailCacheTest::init()
+{
+    QDir(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/thumbnails")).removeRecursively();
+
+    m_dir = new QTemporaryDir;
+    QVERIFY(m_dir->isValid());
+    m_path = m_dir->filePath(QStringLiteral("face.png"));
+
+    QImage image(400, 300, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::red);
+    QVERIFY(image.save(m_path));
+}
+
+void ThumbnailCacheTest::cleanup()
+{
+    delete m_dir;
+    m_dir = nullptr;
+}
+
+/*
+ * Where the specification puts the thumbnail of m_path.
+ */
+QString ThumbnailCacheTest::thumbnail(const QString &flavor) const
+{
+    const QString uri = QUrl::fromLocalFile(m_path).toString(QUrl::FullyEncoded);
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/thumbnails/") + flavor
+        + QLatin1Char('/') + QString::fromLatin1(QCryptographicHash::hash(uri.toUtf8(), QCryptographicHash::Md5).toHex()) + QStringLiteral(".png");
+}
+
+void ThumbnailCacheTest::testNormal()
+{
+    QVERIFY(ThumbnailCache::find(m_path, 64).isNull());
+
+    ThumbnailCache::store(m_path, QImage(m_path), 64);
+    QTRY_VERIFY(QFileInfo::exists(thumbnail(QStringLiteral("normal"))));
+
+    // Scaled to the flavor, with what tells other readers whether it is still valid
+    const QImage found = ThumbnailCache::find(m_path, 64);
+    QCOMPARE(found.size(), QSize(128, 96));
+    QCOMPARE(found.text(QStringLiteral("Thumb::URI")), QUrl::fromLocalFile(m_path).toString(QUrl::FullyEncoded));
+    QCOMPARE(found.text(QStringLiteral("Thumb::MTime")), QString::number(QFileInfo(m_path).lastModified().toSecsSinceEpoch()));
+    QCOMPARE(found.text(QStringLiteral("Thumb::Size")), QString::number(QFileInfo(m_path).size()));
+    QCOMPARE(ThumbnailCache::find(m_path, 128).size(), QSize(128, 96));
+
+    // Private to the user
+    const QFileInfo info(thumbnail(QStringLiteral("normal")));
+    QCOMPARE(info.permissions() & (QFileDevice::ReadGroup | QFileDevice::ReadOther), QFileDevice::Permissions());
+    const QFileInfo directory(info.absolutePath());
+    QCOMPARE(directory.permissions() & (QFileDevice::ReadGroup | QFileDevice::ReadOther), QFileDevice::Permissions());
+
+    // Too small for a larger request
+    QVERIFY(ThumbnailCache::find(m_path, 200).isNull());
+}
+
+void ThumbnailCacheTest::testLarge()
+{
+    ThumbnailCache::store(m_path, QImage(m_path), 200);
+    QTRY_VERIFY(QFileInfo::exists(thumbnail(QStringLiteral("large"))));
+    QCOMPARE(ThumbnailCache::find(m_path, 200).size(), QSize(256, 192));
+    QVERIFY(!QFileInfo::exists(thumbnail(QStringLiteral("normal"))));
+}
+
+void ThumbnailCacheTest::testTooLarge()
+{
+    // Neither flavor is big enough, nothing is written
+    ThumbnailCache::store(m_path, QImage(m_path), 300);
+    QTest::qWait(200);
+    QVERIFY(!QFileInfo::exists(thumbnail(QStringLiteral("normal"))));
+    QVERIFY(!QFileInfo::exists(thumbnail(QStringLiteral("large"))));
+    QVERIFY(ThumbnailCache::find(m_path, 300).isNull());
+}
+
+void ThumbnailCacheTest::testStale()
+{
+    ThumbnailCache::store(m_path, QImage(m_path), 64);
+    QTRY_VERIFY(!ThumbnailCache::find(m_path, 64).isNull());
+
+    // Rewritten later, the thumbnail no longer applies
+    QFile file(m_path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.setFileTime(QDateTime::currentDateTime().addSecs(10), QFileDevice::FileModificationTime));
+    file.close();
+    QVERIFY(ThumbnailCache::find(m_path, 64).isNull());
+
+    QVERIFY(QFile::remove(m_path));
+    QVERIFY(ThumbnailCache::find(m_path, 64).isNull());
+}
+
+QTEST_GUILESS_MAIN(ThumbnailCacheTest)
+
+#include "thumbnailcachetest.moc"
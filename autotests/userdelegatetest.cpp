@@ -0,0 +1,228 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "userdelegate.h"
+#include "lib/accountmodel.h"
+
+#include <QAbstractListModel>
+#include <QApplication>
+#include <QImage>
+#include <QPainter>
+#include <QPixmap>
+#include <QStyleOptionViewItem>
+#include <QTest>
+
+static const int s_rows = 50000;
+static const int s_faces = 64;
+
+static void setupEnvironment()
+{
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+}
+Q_CONSTRUCTOR_FUNCTION(setupEnvironment)
+
+/*
+ * Answers the roles UserDelegate paints, the way AccountModel does, from
+ * precomputed values so that only the painting is measured.
+ */
+class AccountListModel : public QAbstractListModel
+{
+    public:
+        AccountListModel()
+        {
+            for (int i = 0; i < s_faces; ++i) {
+                QPixmap face(64, 64);
+                face.fill(QColor::fromHsv(i * 360 / s_faces, 160, 200));
+                m_faces.append(face);
+            }
+
+            m_names.reserve(s_rows);
+            m_usernames.reserve(s_rows);
+            for (int i = 0; i < s_rows; ++i) {
+                m_names.append(QStringLiteral("Firstname%1 Lastname%2").arg(i).arg(s_rows - i));
+                m_usernames.append(QStringLiteral("user%1").arg(i));
+            }
+        }
+
+        int rowCount(const QModelIndex &parent = QModelIndex()) const override
+        {
+            return parent.isValid() ? 0 : s_rows;
+        }
+
+        QVariant data(const QModelIndex &index, int role) const override
+        {
+            switch (role) {
+                case Qt::DisplayRole:
+                    return m_names.at(index.row());
+                case Qt::DecorationRole:
+                    return m_faces.at(index.row() % s_faces);
+                case AccountModel::Username:
+                    return m_usernames.at(index.row());
+                case AccountModel::Logged:
+                    return index.row() % 7 == 0;
+            }
+            return QVariant();
+        }
+
+    private:
+        QVector<QVariant> m_names;
+        QVector<QVariant> m_usernames;
+        QVector<QVariant> m_faces;
+};
+
+class UserDelegateTest : public QObject
+{
+    Q_OBJECT
+    private Q_SLOTS:
+        void initTestCase();
+        void cleanupTestCase();
+
+        void testUniformRowSize();
+        void testPaints();
+
+        void benchmarkScroll_data();
+        void benchmarkScroll();
+        void benchmarkRepaint_data();
+        void benchmarkRepaint();
+
+    private:
+        QStyleOptionViewItem option(int row) const;
+        QStyledItemDelegate* createDelegate(const QString &kind);
+
+        AccountListModel* m_model = nullptr;
+        int m_rowHeight = 0;
+};
+
+void UserDelegateTest::initTestCase()
+{
+    m_model = new AccountListModel;
+
+    UserDelegate delegate;
+    m_rowHeight = delegate.sizeHint(option(0), m_model->index(0, 0)).height();
+    QVERIFY(m_rowHeight > 0);
+}
+
+void UserDelegateTest::cleanupTestCase()
+{
+    delete m_model;
+}
+
+QStyleOptionViewItem UserDelegateTest::option(int row) const
+{
+    QStyleOptionViewItem option;
+    option.rect = QRect(0, row * m_rowHeight, 400, m_rowHeight);
+    option.font = QApplication::font();
+    option.fontMetrics = QFontMetrics(option.font);
+    option.palette = QApplication::palette();
+    option.state = QStyle::State_Enabled;
+    option.features = QStyleOptionViewItem::HasDisplay | QStyleOptionViewItem::HasDecoration;
+    option.decorationSize = QSize(32, 32);
+    return option;
+}
+
+QStyledItemDelegate* UserDelegateTest::createDelegate(const QString &kind)
+{
+    if (kind == QLatin1String("default")) {
+        return new QStyledItemDelegate(this);
+    }
+    return new UserDelegate(this);
+}
+
+void UserDelegateTest::testUniformRowSize()
+{
+    UserDelegate delegate;
+    const QStyleOptionViewItem first = option(0);
+    const QSize size = delegate.sizeHint(first, m_model->index(0, 0));
+    for (int row : {1, 7, 4711, s_rows - 1}) {
+        QCOMPARE(delegate.sizeHint(option(row), m_model->index(row, 0)), size);
+    }
+}
+
+void UserDelegateTest::testPaints()
+{
+    UserDelegate delegate;
+    QImage canvas(400, m_rowHeight, QImage::Format_ARGB32_Premultiplied);
+    canvas.fill(Qt::white);
+
+    QPainter painter(&canvas);
+    delegate.paint(&painter, option(0), m_model->index(0, 0));
+    painter.end();
+
+    // The middle of the face
+    QVERIFY(canvas.pixel(4 + 16, m_rowHeight / 2) != qRgb(255, 255, 255));
+}
+
+void UserDelegateTest::benchmarkScroll_data()
+{
+    QTest::addColumn<QString>("kind");
+
+    QTest::newRow("UserDelegate") << QStringLiteral("user");
+    QTest::newRow("QStyledItemDelegate") << QStringLiteral("default");
+}
+
+void UserDelegateTest::benchmarkScroll()
+{
+    QFETCH(QString, kind);
+
+    // A 30 row viewport scrolled through all rows, 10 rows per frame
+    const int viewportRows = 30;
+    const int step = 10;
+    QStyledItemDelegate *delegate = createDelegate(kind);
+    QImage canvas(400, viewportRows * m_rowHeight, QImage::Format_ARGB32_Premultiplied);
+
+    QBENCHMARK_ONCE {
+        for (int top = 0; top + viewportRows <= s_rows; top += step) {
+            QPainter painter(&canvas);
+            painter.fillRect(canvas.rect(), Qt::white);
+            for (int row = 0; row < viewportRows; ++row) {
+                delegate->paint(&painter, option(row), m_model->index(top + row, 0));
+            }
+        }
+    }
+
+    delete delegate;
+}
+
+void UserDelegateTest::benchmarkRepaint_data()
+{
+    benchmarkScroll_data();
+}
+
+void UserDelegateTest::benchmarkRepaint()
+{
+    QFETCH(QString, kind);
+
+    // What the caches are for: the same viewport painted again and again
+    const int viewportRows = 30;
+    QStyledItemDelegate *delegate = createDelegate(kind);
+    QImage canvas(400, viewportRows * m_rowHeight, QImage::Format_ARGB32_Premultiplied);
+
+    QBENCHMARK {
+        QPainter painter(&canvas);
+        painter.fillRect(canvas.rect(), Qt::white);
+        for (int row = 0; row < viewportRows; ++row) {
+            delegate->paint(&painter, option(row), m_model->index(1000 + row, 0));
+        }
+    }
+
+    delete delegate;
+}
+
+QTEST_MAIN(UserDelegateTest)
+
+#include "userdelegatetest.moc"
@@ -0,0 +1,163 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "lib/userresourcemonitor.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+
+// Short enough to keep the test fast, long enough for the timer to be meaningful
+static const int s_interval = 200;
+
+static const uint s_alice = 2001;
+static const uint s_bob = 2002;
+
+class UserResourceMonitorTest : public QObject
+{
+    Q_OBJECT
+    private Q_SLOTS:
+        void init();
+        void cleanup();
+
+        void testPrimesOnlyNewSlices();
+        void testCpuInvalidUntilFullInterval();
+        void testSliceGone();
+
+    private:
+        void writeSlice(uint uid, qint64 cpuUsec, qint64 memory);
+
+        QTemporaryDir* m_root = nullptr;
+        UserResourceMonitor* m_monitor = nullptr;
+};
+
+/*
+ * Lays out what the kernel shows in user-<uid>.slice, rewriting the files in
+ * place so the monitor's open descriptors see the new values.
+ */
+void UserResourceMonitorTest::writeSlice(uint uid, qint64 cpuUsec, qint64 memory)
+{
+    const QString dir = QStringLiteral("user-%1.slice").arg(uid);
+    QVERIFY(QDir(m_root->path()).mkpath(dir));
+
+    QFile cpu(m_root->filePath(dir + QStringLiteral("/cpu.stat")));
+    QVERIFY(cpu.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    cpu.write("usage_usec " + QByteArray::number(cpuUsec) + "\n"
+              "user_usec " + QByteArray::number(cpuUsec / 2) + "\n"
+              "system_usec " + QByteArray::number(cpuUsec / 2) + "\n");
+
+    QFile current(m_root->filePath(dir + QStringLiteral("/memory.current")));
+    QVERIFY(current.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    current.write(QByteArray::number(memory) + "\n");
+}
+
+void UserResourceMonitorTest::init()
+{
+    m_root = new QTemporaryDir;
+    QVERIFY(m_root->isValid());
+
+    m_monitor = new UserResourceMonitor(this);
+    m_monitor->setRootPath(m_root->path());
+    m_monitor->setInterval(s_interval);
+}
+
+void UserResourceMonitorTest::cleanup()
+{
+    delete m_monitor;
+    m_monitor = nullptr;
+    delete m_root;
+    m_root = nullptr;
+}
+
+void UserResourceMonitorTest::testPrimesOnlyNewSlices()
+{
+    writeSlice(s_alice, 1000000, 100 * 1024 * 1024);
+    writeSlice(s_bob, 2000000, 200 * 1024 * 1024);
+
+    QSignalSpy spy(m_monitor, &UserResourceMonitor::usageChanged);
+    m_monitor->setWatched({s_alice});
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.takeFirst().at(0).value<QList<uint>>(), QList<uint>({s_alice}));
+    QCOMPARE(m_monitor->memoryUsage(s_alice), qint64(100 * 1024 * 1024));
+    QCOMPARE(m_monitor->cpuUsage(s_alice), qreal(-1));
+
+    // Alice changes, but only Bob is new and only Bob may be read
+    writeSlice(s_alice, 1500000, 150 * 1024 * 1024);
+    m_monitor->setWatched({s_alice, s_bob});
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.takeFirst().at(0).value<QList<uint>>(), QList<uint>({s_bob}));
+    QCOMPARE(m_monitor->memoryUsage(s_alice), qint64(100 * 1024 * 1024));
+    QCOMPARE(m_monitor->memoryUsage(s_bob), qint64(200 * 1024 * 1024));
+
+    // Watching the same users again reads nothing
+    m_monitor->setWatched({s_bob, s_alice});
+    QCOMPARE(spy.count(), 0);
+    QCOMPARE(m_monitor->memoryUsage(s_alice), qint64(100 * 1024 * 1024));
+
+    // The timer picks Alice's change up
+    QTRY_COMPARE(m_monitor->memoryUsage(s_alice), qint64(150 * 1024 * 1024));
+}
+
+void UserResourceMonitorTest::testCpuInvalidUntilFullInterval()
+{
+    writeSlice(s_alice, 1000000, 100 * 1024 * 1024);
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    m_monitor->setWatched({s_alice});
+    QCOMPARE(m_monitor->cpuUsage(s_alice), qreal(-1));
+
+    // Used up 50ms of CPU right after the baseline, a sample now would
+    // average it over a few microseconds and claim thousands of percent
+    writeSlice(s_alice, 1050000, 100 * 1024 * 1024);
+    m_monitor->sample();
+    QCOMPARE(m_monitor->cpuUsage(s_alice), qreal(-1));
+
+    QTRY_VERIFY(m_monitor->cpuUsage(s_alice) >= 0);
+    QVERIFY(elapsed.elapsed() >= s_interval * 9 / 10);
+
+    // 50ms over at least 90% of the interval
+    const qreal cpu = m_monitor->cpuUsage(s_alice);
+    QVERIFY(cpu > 0);
+    QVERIFY(cpu <= 100.0 * 50 / (s_interval * 9 / 10));
+}
+
+void UserResourceMonitorTest::testSliceGone()
+{
+    writeSlice(s_alice, 1000000, 100 * 1024 * 1024);
+    m_monitor->setWatched({s_alice});
+    QCOMPARE(m_monitor->memoryUsage(s_alice), qint64(100 * 1024 * 1024));
+
+    // Once the slice is removed the descriptors still open read nothing
+    const QString dir = QStringLiteral("user-%1.slice/").arg(s_alice);
+    QVERIFY(QFile::resize(m_root->filePath(dir + QStringLiteral("cpu.stat")), 0));
+    QVERIFY(QFile::resize(m_root->filePath(dir + QStringLiteral("memory.current")), 0));
+
+    QSignalSpy spy(m_monitor, &UserResourceMonitor::usageChanged);
+    m_monitor->sample();
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(m_monitor->memoryUsage(s_alice), qint64(-1));
+    QCOMPARE(m_monitor->cpuUsage(s_alice), qreal(-1));
+}
+
+QTEST_GUILESS_MAIN(UserResourceMonitorTest)
+
+#include "userresourcemonitortest.moc"
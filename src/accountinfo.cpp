@@ -21,20 +21,26 @@
 #include "createavatarjob.h"
 #include "passworddialog.h"
 #include "avatargallery.h"
+#include "lib/fileinstaller.h"
 
 #include <pwd.h>
 #include <unistd.h>
 
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QListWidget>
 #include <QMenu>
+#include <QVBoxLayout>
 #include <QToolButton>
 #include <QStandardPaths>
+#include <QDir>
 #include <QImageReader>
 #include <QFontDatabase>
 #include <QFileDialog>
+#include <QLocale>
 
 #include "user_manager_debug.h"
 #include <KJob>
-#include <KIO/CopyJob>
 #include <KUser>
 #include <KI18n/klocalizedstring.h>
 #include <KMessageBox>
@@ -56,6 +62,7 @@ AccountInfo::AccountInfo(AccountModel* model, QWidget* parent, Qt::WindowFlags f
     connect(m_info->administrator, &QAbstractButton::clicked, this, &AccountInfo::hasChanged);
     connect(m_info->automaticLogin, &QAbstractButton::clicked, this, &AccountInfo::hasChanged);
     connect(m_info->changePasswordButton, &QPushButton::clicked, this, &AccountInfo::changePassword);
+    connect(m_info->editGroupsButton, &QPushButton::clicked, this, &AccountInfo::editGroups);
 
     connect(m_model, &QAbstractItemModel::dataChanged, this, &AccountInfo::dataChanged);
     m_info->face->setPopupMode(QToolButton::InstantPopup);
@@ -127,8 +134,11 @@ QModelIndex AccountInfo::modelIndex() const
 
 void AccountInfo::loadFromModel()
 {
+    m_model->requestDetails(m_index);
+
+    //Existing accounts may still have their details in flight, so do not go by the username
     const QString username = m_model->data(m_index, AccountModel::Username).toString();
-    if (!username.isEmpty()) {
+    if (m_model->data(m_index, AccountModel::Created).toBool()) {
         m_info->username->setDisabled(true);//Do not allow to change the username
         m_info->changePasswordButton->setText(i18nc("@label:button", "Change Password"));
     } else {
@@ -142,6 +152,28 @@ void AccountInfo::loadFromModel()
     m_info->email->setText(m_model->data(m_index, AccountModel::Email).toString());
     m_info->administrator->setChecked(m_model->data(m_index, AccountModel::Administrator).toBool());
     m_info->automaticLogin->setChecked(m_model->data(m_index, AccountModel::AutomaticLogin).toBool());
+
+    // Memberships of an account still being created are left to the defaults of useradd
+    const bool created = m_model->data(m_index, AccountModel::Created).toBool();
+    m_info->editGroupsButton->setVisible(created && !m_model->availableGroups().isEmpty());
+    showGroups(m_model->data(m_index, AccountModel::Groups).toStringList());
+
+    // Only known once the password status was asked for, see AccountModel::fetchPrivilegedDetails()
+    QString passwordStatus;
+    if (m_model->data(m_index, AccountModel::PasswordLocked).toBool()) {
+        passwordStatus = i18n("The password is locked.");
+    } else {
+        const QDate changed = m_model->data(m_index, AccountModel::PasswordChanged).toDate();
+        const QDate expires = m_model->data(m_index, AccountModel::PasswordExpires).toDate();
+        if (expires.isValid()) {
+            passwordStatus = i18n("Password last changed on %1, it expires on %2.",
+                                  QLocale().toString(changed, QLocale::ShortFormat), QLocale().toString(expires, QLocale::ShortFormat));
+        } else if (changed.isValid()) {
+            passwordStatus = i18n("Password last changed on %1.", QLocale().toString(changed, QLocale::ShortFormat));
+        }
+    }
+    m_info->passwordStatus->setText(passwordStatus);
+    m_info->passwordStatus->setVisible(!passwordStatus.isEmpty());
 }
 
 bool AccountInfo::save()
@@ -177,6 +209,10 @@ bool AccountInfo::save()
             failed.append(AccountModel::Password);
         }
     }
+    if (m_infoToSave.contains(AccountModel::Groups) &&
+            !m_model->setData(m_index, m_infoToSave[AccountModel::Groups], AccountModel::Groups)) {
+        failed.append(AccountModel::Groups);
+    }
     if (m_infoToSave.contains(AccountModel::Face)) {
         const QString path = m_infoToSave[AccountModel::Face].toString();
 
@@ -188,20 +224,28 @@ bool AccountInfo::save()
         if (username != KUser().loginName()) {
             m_model->setData(m_index, QVariant(path), AccountModel::Face);
         } else {
-            QString faceFile = QStandardPaths::writableLocation(QStandardPaths::HomeLocation);
-            faceFile.append(QLatin1String("/.face"));
-            QFile::remove(faceFile);
-
-            KIO::CopyJob* copyJob = KIO::copy(QUrl::fromLocalFile(path), QUrl::fromLocalFile(faceFile), KIO::HideProgressInfo);
-            connect(copyJob, &KJob::finished, this, &AccountInfo::avatarModelChanged);
-            copyJob->setUiDelegate(nullptr);
-            copyJob->setUiDelegateExtension(nullptr);
-            copyJob->start();
-
-            QString faceFile2 = QStandardPaths::writableLocation(QStandardPaths::HomeLocation);
-            faceFile2.append(QLatin1String("/.face.icon"));
-            QFile::remove(faceFile2);
-            QFile::link(faceFile, faceFile2);
+            const QString home = QStandardPaths::writableLocation(QStandardPaths::HomeLocation);
+            const QString faceFile = home + QLatin1String("/.face");
+            const QString faceIconFile = home + QLatin1String("/.face.icon");
+
+            // Reflinked or copied in the kernel and renamed into place, so the display
+            // manager never sees a half written face
+            if (path.isEmpty()) {
+                QFile::remove(faceIconFile);
+                QFile::remove(faceFile);
+                m_model->setData(m_index, QVariant(path), AccountModel::Face);
+            } else if (FileInstaller::install(path, faceFile) != FileInstaller::Failed) {
+                FileInstaller::link(faceFile, faceIconFile);
+                m_model->setData(m_index, QVariant(faceFile), AccountModel::Face);
+
+                // If there is a leftover temp file, remove it
+                if (path.startsWith(QDir::tempPath() + QLatin1Char('/'))) {
+                    QFile::remove(path);
+                }
+            } else {
+                failed.append(AccountModel::Face);
+            }
+            m_info->face->setIcon(QIcon(m_model->data(m_index, AccountModel::Face).value<QPixmap>()));
         }
     }
 
@@ -214,6 +258,18 @@ bool AccountInfo::save()
     return true;
 }
 
+void AccountInfo::setReadOnly(bool readOnly)
+{
+    m_info->realName->setReadOnly(readOnly);
+    m_info->email->setReadOnly(readOnly);
+    m_info->username->setReadOnly(readOnly);
+    m_info->administrator->setEnabled(!readOnly);
+    m_info->automaticLogin->setEnabled(!readOnly);
+    m_info->changePasswordButton->setEnabled(!readOnly);
+    m_info->editGroupsButton->setEnabled(!readOnly);
+    m_info->face->setEnabled(!readOnly);
+}
+
 void AccountInfo::hasChanged()
 {
     m_info->nameValidation->setPixmap(m_positive);
@@ -258,6 +314,10 @@ void AccountInfo::hasChanged()
         infoToSave[AccountModel::Password] = m_infoToSave[AccountModel::Password];
     }
 
+    if (m_infoToSave.contains(AccountModel::Groups)) {
+        infoToSave[AccountModel::Groups] = m_infoToSave[AccountModel::Groups];
+    }
+
 
     m_infoToSave = infoToSave;
     emit changed(!m_infoToSave.isEmpty());
@@ -388,14 +448,17 @@ bool AccountInfo::validateEmail(const QString& email) const
     return true;
 }
 
-void AccountInfo::dataChanged(const QModelIndex& index)
+void AccountInfo::dataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight)
 {
-    if (m_index != index) {
+    //Changes come merged into row ranges, ours may be anywhere in one
+    const int row = m_index.row();
+    if (!m_index.isValid() || row < topLeft.row() || row > bottomRight.row()) {
         return;
     }
 
-    //If we have no username, we assume this was user-new
-    if (m_info->username->text().isEmpty()) {
+    //Nothing edited yet, so just show what the model has now. Details are fetched
+    //asynchronously and may arrive after the form was first filled in.
+    if (m_infoToSave.isEmpty()) {
         loadFromModel();
         return;
     }
@@ -456,17 +519,6 @@ void AccountInfo::avatarCreated(KJob* job)
     }
 }
 
-void AccountInfo::avatarModelChanged(KJob* job)
-{
-    KIO::CopyJob* cJob = qobject_cast<KIO::CopyJob*>(job);
-    m_model->setData(m_index, QVariant(cJob->destUrl().path()), AccountModel::Face);
-    m_info->face->setIcon(QIcon(m_model->data(m_index, AccountModel::Face).value<QPixmap>()));
-    // If there is a leftover temp file, remove it
-    if (cJob->srcUrls().constFirst().path().startsWith(QLatin1String("/tmp/"))) {
-        QFile::remove(cJob->srcUrls().constFirst().path());
-    }
-}
-
 void AccountInfo::clearAvatar()
 {
     m_info->face->setIcon(QIcon::fromTheme(QStringLiteral("user-identity")).pixmap(48, 48));
@@ -486,3 +538,65 @@ void AccountInfo::changePassword()
     m_infoToSave[AccountModel::Password] = dialog->password();
     emit changed(true);
 }
+
+void AccountInfo::editGroups()
+{
+    const QStringList current = m_infoToSave.contains(AccountModel::Groups)
+        ? m_infoToSave[AccountModel::Groups].toStringList()
+        : m_model->data(m_index, AccountModel::Groups).toStringList();
+    const QString primary = m_model->primaryGroup(m_index);
+
+    QDialog dialog(this);
+    dialog.setWindowTitle(i18nc("@title:window", "Groups of %1", m_model->data(m_index, AccountModel::Username).toString()));
+
+    QListWidget *list = new QListWidget(&dialog);
+    const QStringList available = m_model->availableGroups();
+    for (const QString &group : available) {
+        QListWidgetItem *item = new QListWidgetItem(group, list);
+        item->setCheckState(current.contains(group) ? Qt::Checked : Qt::Unchecked);
+        if (group == primary) {
+            // Set in the passwd entry, not through the group file
+            item->setCheckState(Qt::Checked);
+            item->setFlags(item->flags() & ~Qt::ItemIsEnabled);
+            item->setToolTip(i18n("The primary group of this user"));
+        }
+    }
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+    layout->addWidget(list);
+    layout->addWidget(buttons);
+
+    if (dialog.exec() != QDialog::Accepted) {
+        return;
+    }
+
+    QStringList groups;
+    if (!primary.isEmpty()) {
+        groups.append(primary);
+    }
+    for (int row = 0; row < list->count(); ++row) {
+        const QListWidgetItem *item = list->item(row);
+        if (item->checkState() == Qt::Checked && item->text() != primary) {
+            groups.append(item->text());
+        }
+    }
+
+    if (groups == m_model->data(m_index, AccountModel::Groups).toStringList()) {
+        m_infoToSave.remove(AccountModel::Groups);
+    } else {
+        m_infoToSave[AccountModel::Groups] = groups;
+    }
+    showGroups(groups);
+    emit changed(!m_infoToSave.isEmpty());
+}
+
+void AccountInfo::showGroups(const QStringList &groups)
+{
+    m_info->groups->setText(groups.join(i18nc("separator between group names", ", ")));
+    m_info->groupsLabel->setVisible(!groups.isEmpty() || m_info->editGroupsButton->isVisibleTo(this));
+    m_info->groups->setVisible(!groups.isEmpty());
+}
@@ -44,6 +44,7 @@ class AccountInfo : public QWidget
 
         void loadFromModel();
         bool save();
+        void setReadOnly(bool readOnly);
 
     public Q_SLOTS:
         void hasChanged();
@@ -51,9 +52,9 @@ class AccountInfo : public QWidget
         void openAvatarSlot();
         void clearAvatar();
         void avatarCreated(KJob* job);
-        void avatarModelChanged(KJob* job);
         void changePassword();
-        void dataChanged(const QModelIndex &index);
+        void editGroups();
+        void dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
 
     Q_SIGNALS:
         void changed(bool changed);
@@ -66,13 +67,14 @@ class AccountInfo : public QWidget
         QString cleanEmail(QString email);
         bool validateEmail(const QString &email) const;
         QStringList imageFormats() const;
+        void showGroups(const QStringList &groups);
 
         QPixmap m_positive;
         QPixmap m_negative;
         Ui::AccountInfo * const m_info;
         AccountModel* const m_model;
         QPushButton *m_changePasswordButton = nullptr;
-        QModelIndex m_index;
+        QPersistentModelIndex m_index;
         QMap<AccountModel::Role, QVariant> m_infoToSave;
 };
 
@@ -0,0 +1,125 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "avatarcropper.h"
+#include "user_manager_debug.h"
+#include "lib/avatarstore.h"
+
+#include <QCryptographicHash>
+#include <QImageReader>
+#include <QTransform>
+
+/*
+ * Maps the image as stored in the file onto the image as shown, following the
+ * order QImageReader applies its transformations in: mirror, flip, then rotate.
+ */
+static QTransform orientation(QImageIOHandler::Transformations transformation, const QSize &size)
+{
+    QTransform transform;
+    if (transformation & QImageIOHandler::TransformationMirror) {
+        transform *= QTransform(-1, 0, 0, 1, size.width(), 0);
+    }
+    if (transformation & QImageIOHandler::TransformationFlip) {
+        transform *= QTransform(1, 0, 0, -1, 0, size.height());
+    }
+    if (transformation & QImageIOHandler::TransformationRotate90) {
+        transform *= QTransform(0, 1, -1, 0, size.height(), 0);
+    }
+
+    return transform;
+}
+
+AvatarCropper::Proxy AvatarCropper::readProxy(const QString &path)
+{
+    Proxy proxy;
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+    proxy.fileSize = reader.size();
+    proxy.transformation = reader.transformation();
+    if (proxy.fileSize.isValid() && qMax(proxy.fileSize.width(), proxy.fileSize.height()) > ProxySize) {
+        reader.setScaledSize(proxy.fileSize.scaled(ProxySize, ProxySize, Qt::KeepAspectRatio));
+    }
+
+    proxy.image = reader.read();
+    if (proxy.image.isNull()) {
+        proxy.errorString = reader.errorString();
+        return proxy;
+    }
+
+    // Formats that only know their size once decoded were read in full
+    if (!proxy.fileSize.isValid()) {
+        proxy.fileSize = proxy.transformation & QImageIOHandler::TransformationRotate90 ? proxy.image.size().transposed()
+                                                                                          : proxy.image.size();
+    }
+
+    return proxy;
+}
+
+AvatarCropper::Selection AvatarCropper::select(const Proxy &proxy, const QRect &region)
+{
+    // Take the selection from the proxy back to the file as stored on disk
+    const QTransform toShown = orientation(proxy.transformation, proxy.fileSize);
+    const QSizeF shownSize = toShown.mapRect(QRectF(QPointF(0, 0), proxy.fileSize)).size();
+    const QTransform fromProxy = QTransform::fromScale(shownSize.width() / proxy.image.width(),
+                                                       shownSize.height() / proxy.image.height());
+    const QRectF shownRegion = fromProxy.mapRect(QRectF(region));
+
+    Selection selection;
+    selection.clip = toShown.inverted().mapRect(shownRegion).toAlignedRect() & QRect(QPoint(0, 0), proxy.fileSize);
+
+    const qreal scale = qMin<qreal>(1, MaximumWidth / shownRegion.width());
+    selection.size = (QSizeF(selection.clip.size()) * scale).toSize().expandedTo(QSize(1, 1));
+    return selection;
+}
+
+/*
+ * Decodes only the selected part of the file, already scaled down to the avatar
+ * size, so the full resolution image is never held in memory.
+ *
+ * Nothing is decoded at all when the same part of the same picture was made into
+ * an avatar before.
+ */
+AvatarCropper::Crop AvatarCropper::crop(const QString &path, const Selection &selection)
+{
+    const QRect &clip = selection.clip;
+    const QSize &size = selection.size;
+
+    Crop crop;
+    const QByteArray source = AvatarStore::contentHash(path);
+    if (!source.isEmpty()) {
+        const QString choice = QStringLiteral("1 %1 %2 %3 %4 %5 %6 %7").arg(QString::fromLatin1(source))
+            .arg(clip.x()).arg(clip.y()).arg(clip.width()).arg(clip.height()).arg(size.width()).arg(size.height());
+        crop.key = QCryptographicHash::hash(choice.toLatin1(), QCryptographicHash::Sha256).toHex();
+        crop.stored = AvatarStore::find(crop.key);
+        if (!crop.stored.isEmpty()) {
+            return crop;
+        }
+    }
+
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+    reader.setClipRect(clip);
+    reader.setScaledSize(size);
+
+    crop.image = reader.read();
+    if (crop.image.isNull()) {
+        qCDebug(USER_MANAGER_LOG) << "Cropping" << path << "failed:" << reader.errorString();
+    }
+
+    return crop;
+}
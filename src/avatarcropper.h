@@ -0,0 +1,72 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#ifndef AVATAR_CROPPER_H
+#define AVATAR_CROPPER_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QImageIOHandler>
+#include <QRect>
+#include <QString>
+
+/**
+ * Turns a picture of any size into the part of it chosen for an avatar.
+ *
+ * Only a screen sized proxy is decoded to choose from, and only the chosen
+ * part of the file is decoded afterwards, already scaled to the avatar size.
+ * A camera picture is never held in memory at full resolution.
+ */
+class AvatarCropper
+{
+    public:
+        struct Proxy {
+            QImage image;
+            /* The picture as stored in the file, before the orientation is applied */
+            QSize fileSize;
+            QImageIOHandler::Transformations transformation = QImageIOHandler::TransformationNone;
+            QString errorString;
+
+            bool isNull() const { return image.isNull(); }
+        };
+
+        struct Selection {
+            /* In file coordinates, before the orientation is applied */
+            QRect clip;
+            QSize size;
+        };
+
+        struct Crop {
+            QByteArray key;
+            /* An avatar made from the same selection before, nothing was decoded then */
+            QString stored;
+            QImage image;
+        };
+
+        /* Larger than the selection dialog ever shows it, small enough to decode quickly */
+        static const int ProxySize = 1024;
+        /* The largest avatar AvatarEncoder tries */
+        static const int MaximumWidth = 600;
+
+        static Proxy readProxy(const QString &path);
+        /* Maps @p region of the proxy back to the file */
+        static Selection select(const Proxy &proxy, const QRect &region);
+        static Crop crop(const QString &path, const Selection &selection);
+};
+
+#endif //AVATAR_CROPPER_H
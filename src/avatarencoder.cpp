@@ -0,0 +1,101 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "avatarencoder.h"
+#include "user_manager_debug.h"
+#include "lib/areascaler.h"
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QImageWriter>
+
+/* Widths worth trying, largest first. The last one always fits. */
+static const int s_widths[] = { 600, 512, 384, 256, 192 };
+static const int s_jpegQualities[] = { 95, 85 };
+
+QList<AvatarEncoder::Candidate> AvatarEncoder::candidates(const QImage &image)
+{
+    QList<Candidate> candidates;
+    for (int width : s_widths) {
+        if (width > image.width() && width != s_widths[0]) {
+            continue;
+        }
+
+        const int targetWidth = qMin(width, image.width());
+        // For PNG the quality is the zlib level backwards: lossless either way, so
+        // spend the time on the smallest file
+        candidates << Candidate{image, targetWidth, QByteArrayLiteral("png"), 0};
+        if (!image.hasAlphaChannel()) {
+            for (int quality : s_jpegQualities) {
+                candidates << Candidate{image, targetWidth, QByteArrayLiteral("jpeg"), quality};
+            }
+        }
+    }
+
+    return candidates;
+}
+
+AvatarEncoder::Result AvatarEncoder::encode(const Candidate &candidate)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QImage image = candidate.image;
+    if (image.width() > candidate.width) {
+        image = AreaScaler::scaledToWidth(image, candidate.width);
+    }
+
+    Result result;
+    QBuffer buffer(&result.data);
+    buffer.open(QIODevice::WriteOnly);
+
+    QImageWriter writer(&buffer, candidate.format);
+    writer.setQuality(candidate.quality);
+
+    if (!writer.write(image)) {
+        qCDebug(USER_MANAGER_LOG) << "Encoding" << candidate.format << "failed:" << writer.errorString();
+        result.data.clear();
+    }
+
+    result.format = candidate.format;
+    result.width = image.width();
+    result.quality = candidate.quality;
+    result.elapsed = timer.elapsed();
+    return result;
+}
+
+AvatarEncoder::Result AvatarEncoder::best(const QList<Result> &results, qint64 budget)
+{
+    // Results come in the order of candidates(), best first
+    const Result *smallest = nullptr;
+    for (const Result &result : results) {
+        if (result.isNull()) {
+            continue;
+        }
+        if (result.data.size() <= budget) {
+            return result;
+        }
+        if (!smallest || result.data.size() < smallest->data.size()) {
+            smallest = &result;
+        }
+    }
+
+    // Nothing fits, which the last candidate in practice always does. Let
+    // accountsservice have the final word rather than failing here.
+    return smallest ? *smallest : Result();
+}
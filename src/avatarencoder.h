@@ -0,0 +1,61 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#ifndef AVATAR_ENCODER_H
+#define AVATAR_ENCODER_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QList>
+
+/**
+ * Encodes an avatar so that it fits accountsservice's icon size limit.
+ *
+ * Every combination of size and format worth trying is encoded at once, one per
+ * worker, and the best one under the budget wins. Larger sizes beat smaller ones,
+ * and at the same size PNG beats JPEG. JPEG is only tried for opaque images.
+ */
+class AvatarEncoder
+{
+    public:
+        struct Candidate {
+            QImage image;
+            int width;
+            QByteArray format;
+            int quality;
+        };
+
+        struct Result {
+            QByteArray data;
+            QByteArray format;
+            int width = 0;
+            int quality = 0;
+            qint64 elapsed = 0;
+
+            bool isNull() const { return data.isEmpty(); }
+        };
+
+        /* accountsservice refuses icons larger than this */
+        static const qint64 MaximumSize = 1024 * 1024;
+
+        static QList<Candidate> candidates(const QImage &image);
+        static Result encode(const Candidate &candidate);
+        static Result best(const QList<Result> &results, qint64 budget = MaximumSize);
+};
+
+#endif //AVATAR_ENCODER_H
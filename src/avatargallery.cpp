@@ -19,13 +19,14 @@
  */
 
 #include "avatargallery.h"
+#include "lib/avatarindex.h"
 
-#include <QDir>
 #include <QPushButton>
-#include <QStandardPaths>
-
+#include <QSortFilterProxyModel>
 
 AvatarGallery::AvatarGallery(QWidget *parent) : QDialog(parent)
+    , m_index(new AvatarIndex(this))
+    , m_filter(new QSortFilterProxyModel(this))
 {
     setWindowTitle(i18nc("@title:window", "Change your Face"));
 
@@ -36,38 +37,27 @@ AvatarGallery::AvatarGallery(QWidget *parent) : QDialog(parent)
     connect(ui.buttonBox, &QDialogButtonBox::accepted, this, &QDialog::accept);
     connect(ui.buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
 
-    connect(ui.m_FacesWidget, &QListWidget::currentItemChanged, this, [this](QListWidgetItem *current, QListWidgetItem *previous) {
-        Q_UNUSED(previous)
-        ui.buttonBox->button(QDialogButtonBox::Ok)->setEnabled(!current->icon().isNull());
+    // Names and categories are indexed case folded, so is what is typed
+    m_filter->setSourceModel(m_index);
+    m_filter->setFilterRole(AvatarIndex::SearchRole);
+    connect(ui.filter, &QLineEdit::textChanged, this, [this](const QString &text) {
+        m_filter->setFilterFixedString(text.toCaseFolded());
     });
 
-    connect(ui.m_FacesWidget, &QListWidget::doubleClicked, this, &AvatarGallery::accept);
-
-    const QStringList &locations = QStandardPaths::locateAll(QStandardPaths::GenericDataLocation,
-                                                             QStringLiteral("user-manager/avatars"),
-                                                             QStandardPaths::LocateDirectory);
+    // Only the rows in sight are ever asked for their picture
+    m_index->setIconSize(ui.m_FacesView->iconSize().width());
+    ui.m_FacesView->setModel(m_filter);
 
-    if (locations.isEmpty()) {
-        return;
-    }
-
-    const QString &systemFacesPath = locations.last() + QLatin1Char('/');
-    const QDir avatarsDir(systemFacesPath);
+    connect(ui.m_FacesView->selectionModel(), &QItemSelectionModel::currentChanged, this, [this](const QModelIndex &current) {
+        ui.buttonBox->button(QDialogButtonBox::Ok)->setEnabled(current.isValid());
+    });
 
-    for (const QString &avatarStyle : avatarsDir.entryList(QDir::Dirs | QDir::NoDotDot)) {
-        const QDir facesDir = (avatarsDir.filePath(avatarStyle));
-        const QStringList &avatarList = facesDir.entryList(QDir::Files);
-        for (auto it = avatarList.constBegin(), end = avatarList.constEnd(); it != end; ++it) {
-            const QString iconPath = (facesDir.absoluteFilePath(*it));
-            auto *item = new QListWidgetItem(QIcon(iconPath), it->section(QLatin1Char('.'), 0, 0), ui.m_FacesWidget);
-            item->setData(Qt::UserRole, iconPath);
-        }
-    }
+    connect(ui.m_FacesView, &QListView::doubleClicked, this, &AvatarGallery::accept);
 
     resize(420, 400); // FIXME
 }
 
 QUrl AvatarGallery::url() const
 {
-    return QUrl::fromLocalFile(ui.m_FacesWidget->currentItem()->data(Qt::UserRole).toString());
+    return QUrl::fromLocalFile(ui.m_FacesView->currentIndex().data(AvatarIndex::PathRole).toString());
 }
@@ -26,6 +26,9 @@
 
 #include "ui_avatargallery.h"
 
+class AvatarIndex;
+class QSortFilterProxyModel;
+
 class AvatarGallery : public QDialog
 {
     Q_OBJECT
@@ -38,6 +41,8 @@ public:
 
 private:
     Ui::faceDlg ui;
+    AvatarIndex *m_index;
+    QSortFilterProxyModel *m_filter;
 
 };
 
@@ -18,10 +18,12 @@
 
 #include "createavatarjob.h"
 #include "user_manager_debug.h"
+#include "lib/avatarstore.h"
 
-#include <QImage>
+#include <QFutureWatcher>
 #include <QPixmap>
 #include <QTemporaryFile>
+#include <QtConcurrent>
 
 #include <KIO/CopyJob>
 #include <KPixmapRegionSelectorDialog>
@@ -37,7 +39,7 @@ void CreateAvatarJob::setUrl(const QUrl& url)
 
 QString CreateAvatarJob::avatarPath() const
 {
-    return m_tmpFile;
+    return m_avatarPath;
 }
 
 void CreateAvatarJob::start()
@@ -70,25 +72,96 @@ void CreateAvatarJob::copyDone(KJob* job)
         return;
     }
 
-    QImage face = KPixmapRegionSelectorDialog::getSelectedImage(QPixmap(m_tmpFile), 192, 192);
-    if (face.isNull()) {
+    // Only a screen sized proxy is decoded for the selection. A camera picture would
+    // otherwise take hundreds of MB and seconds before the dialog even shows up.
+    const AvatarCropper::Proxy proxy = AvatarCropper::readProxy(m_tmpFile);
+    if (proxy.isNull()) {
+        qCDebug(USER_MANAGER_LOG) << "Error:" << proxy.errorString;
+        setError(UserDefinedError);
+        setErrorText(proxy.errorString);
+        emitResult();
+        return;
+    }
+
+    const QRect region = KPixmapRegionSelectorDialog::getSelectedRegion(QPixmap::fromImage(proxy.image), 192, 192);
+    if (region.isEmpty()) {
         qCDebug(USER_MANAGER_LOG) << "Icon region selection aborted";
         setError(UserDefinedError);
         emitResult();
         return;
     }
 
-    /* Accountmanager doesn't allow icon which are bigger than 1MB */
-    face = face.scaledToWidth(qMin(600, face.width()));
+    const AvatarCropper::Selection selection = AvatarCropper::select(proxy, region);
+    qCDebug(USER_MANAGER_LOG) << "Cropping" << selection.clip << "of" << proxy.fileSize << "to" << selection.size;
+    m_crop = new QFutureWatcher<AvatarCropper::Crop>(this);
+    connect(m_crop, &QFutureWatcherBase::finished, this, &CreateAvatarJob::cropDone);
+    m_crop->setFuture(QtConcurrent::run(AvatarCropper::crop, m_tmpFile, selection));
+}
+
+void CreateAvatarJob::cropDone()
+{
+    const AvatarCropper::Crop crop = m_crop->result();
+    m_crop->deleteLater();
+    m_crop = nullptr;
+
+    if (!crop.stored.isEmpty()) {
+        qCDebug(USER_MANAGER_LOG) << "Reusing" << crop.stored;
+        QFile::remove(m_tmpFile);
+        m_avatarPath = crop.stored;
+        emitResult();
+        return;
+    }
+
+    const QImage face = crop.image;
+    if (face.isNull()) {
+        setError(UserDefinedError);
+        emitResult();
+        return;
+    }
+
+    // Sizes and formats are tried in parallel, the dialog stays responsive meanwhile
+    m_key = crop.key;
+    m_encodeTimer.start();
+    m_encode = new QFutureWatcher<AvatarEncoder::Result>(this);
+    connect(m_encode, &QFutureWatcherBase::finished, this, &CreateAvatarJob::encodeDone);
+    m_encode->setFuture(QtConcurrent::mapped(AvatarEncoder::candidates(face), AvatarEncoder::encode));
+}
+
+void CreateAvatarJob::encodeDone()
+{
+    const AvatarEncoder::Result result = AvatarEncoder::best(m_encode->future().results());
+    m_encode->deleteLater();
+    m_encode = nullptr;
+
+    if (result.isNull()) {
+        qCDebug(USER_MANAGER_LOG) << "Encoding icon failed";
+        setError(UserDefinedError);
+        emitResult();
+        return;
+    }
+
+    qCDebug(USER_MANAGER_LOG) << "Encoded icon as" << result.format << result.width << "px, quality" << result.quality
+                              << "in" << result.data.size() << "bytes," << result.elapsed << "ms of"
+                              << m_encodeTimer.elapsed() << "ms";
+
+    if (!m_key.isEmpty()) {
+        m_avatarPath = AvatarStore::insert(m_key, result.data);
+    }
+    if (!m_avatarPath.isEmpty()) {
+        QFile::remove(m_tmpFile);
+        emitResult();
+        return;
+    }
 
-    /* Delete file, otherwise face.save() will fail */
-    QFile::remove(m_tmpFile);
-    if (! face.save(m_tmpFile, "PNG", 10)) {
-        qCDebug(USER_MANAGER_LOG) << "Saving icon failed";
+    // Without the store, the temporary file is handed over instead
+    QFile file(m_tmpFile);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(result.data) != result.data.size()) {
+        qCDebug(USER_MANAGER_LOG) << "Saving icon failed:" << file.errorString();
         setError(UserDefinedError);
         emitResult();
         return;
     }
 
+    m_avatarPath = m_tmpFile;
     emitResult();
 }
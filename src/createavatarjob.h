@@ -19,9 +19,16 @@
 #ifndef CREATE_AVATAR_JOB_H
 #define CREATE_AVATAR_JOB_H
 
+#include "avatarcropper.h"
+#include "avatarencoder.h"
+
 #include <kjob.h>
+#include <QElapsedTimer>
+#include <QImage>
 #include <QUrl>
 
+template<typename T> class QFutureWatcher;
+
 class CreateAvatarJob : public KJob
 {
      Q_OBJECT
@@ -35,10 +42,17 @@ class CreateAvatarJob : public KJob
     private Q_SLOTS:
         void doStart();
         void copyDone(KJob* job);
+        void cropDone();
+        void encodeDone();
 
     private:
         QUrl m_url;
         QString m_tmpFile;
+        QString m_avatarPath;
+        QByteArray m_key;
+        QFutureWatcher<AvatarCropper::Crop>* m_crop = nullptr;
+        QFutureWatcher<AvatarEncoder::Result>* m_encode = nullptr;
+        QElapsedTimer m_encodeTimer;
 };
 
 #endif //CREATE_AVATAR_JOB_H
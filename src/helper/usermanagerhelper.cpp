@@ -0,0 +1,159 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "usermanagerhelper.h"
+
+#include <QProcess>
+#include <QRegularExpression>
+
+#include <KAuth/KAuthHelperSupport>
+
+#include <cerrno>
+#include <pwd.h>
+#include <shadow.h>
+#include <unistd.h>
+
+// Enough for every account of a large site, anything above is a broken caller
+static const int s_maxUids = 100000;
+
+// Upper bound for the passwd and shadow lookup buffers, which start at sysconf()'s hint
+static const int s_maxBufferSize = 1024 * 1024;
+
+// What shadow-utils accepts by default, gpasswd must never see an option here
+static const QRegularExpression s_validName(QStringLiteral("^[a-zA-Z0-9_.][a-zA-Z0-9_.-]*\\$?$"));
+
+static QVariantMap accountStatus(uint uid, bool aging, bool locked)
+{
+    QVariantMap status;
+
+    long bufferSize = sysconf(_SC_GETPW_R_SIZE_MAX);
+    QByteArray buffer(bufferSize > 0 ? bufferSize : 16384, Qt::Uninitialized);
+    struct passwd pw;
+    struct passwd *pwResult = nullptr;
+    int error;
+    while ((error = getpwuid_r(uid, &pw, buffer.data(), buffer.size(), &pwResult)) == ERANGE && buffer.size() < s_maxBufferSize) {
+        buffer.resize(buffer.size() * 2);
+    }
+    if (error != 0 || !pwResult) {
+        return status;
+    }
+
+    // Both lookups grow their buffer, an entry which does not fit is not a missing one
+    QByteArray shadowBuffer(buffer.size(), Qt::Uninitialized);
+    struct spwd sp;
+    struct spwd *spResult = nullptr;
+    while ((error = getspnam_r(pw.pw_name, &sp, shadowBuffer.data(), shadowBuffer.size(), &spResult)) == ERANGE && shadowBuffer.size() < s_maxBufferSize) {
+        shadowBuffer.resize(shadowBuffer.size() * 2);
+    }
+    if (error != 0 || !spResult) {
+        return status;
+    }
+
+    // Days since the epoch, -1 where the field is empty, as in shadow(5)
+    if (aging) {
+        status[QStringLiteral("lastChange")] = qlonglong(sp.sp_lstchg);
+        status[QStringLiteral("minDays")] = qlonglong(sp.sp_min);
+        status[QStringLiteral("maxDays")] = qlonglong(sp.sp_max);
+        status[QStringLiteral("warnDays")] = qlonglong(sp.sp_warn);
+        status[QStringLiteral("inactiveDays")] = qlonglong(sp.sp_inact);
+        status[QStringLiteral("expire")] = qlonglong(sp.sp_expire);
+    }
+    if (locked) {
+        status[QStringLiteral("locked")] = sp.sp_pwdp && sp.sp_pwdp[0] == '!';
+    }
+
+    return status;
+}
+
+ActionReply UserManagerHelper::query(const QVariantMap& args)
+{
+    const QStringList requests = args.value(QStringLiteral("requests")).toStringList();
+    const QVariantList uids = args.value(QStringLiteral("uids")).toList();
+    if (uids.count() > s_maxUids) {
+        ActionReply reply = ActionReply::HelperErrorReply();
+        reply.setErrorDescription(QStringLiteral("Too many users in one request"));
+        return reply;
+    }
+
+    QVariantMap data;
+
+    const bool aging = requests.contains(QLatin1String("aging"));
+    const bool locked = requests.contains(QLatin1String("locked"));
+    if (aging || locked) {
+        for (const QVariant &uid : uids) {
+            const QVariantMap status = accountStatus(uid.toUInt(), aging, locked);
+            if (!status.isEmpty()) {
+                data[QString::number(uid.toUInt())] = status;
+            }
+        }
+    }
+
+    ActionReply reply = ActionReply::SuccessReply();
+    reply.setData(data);
+    return reply;
+}
+
+ActionReply UserManagerHelper::setgroups(const QVariantMap& args)
+{
+    const QString username = args.value(QStringLiteral("username")).toString();
+    const QStringList add = args.value(QStringLiteral("add")).toStringList();
+    const QStringList remove = args.value(QStringLiteral("remove")).toStringList();
+
+    bool valid = s_validName.match(username).hasMatch();
+    for (const QString &group : add + remove) {
+        valid = valid && s_validName.match(group).hasMatch();
+    }
+    if (!valid) {
+        ActionReply reply = ActionReply::HelperErrorReply();
+        reply.setErrorDescription(QStringLiteral("Invalid user or group name"));
+        return reply;
+    }
+
+    // One gpasswd per group, each rewrites /etc/group and /etc/gshadow under their locks
+    const auto run = [&username](const QString &option, const QString &group) {
+        QProcess gpasswd;
+        gpasswd.start(QStringLiteral("gpasswd"), {option, username, group});
+        if (!gpasswd.waitForFinished() || gpasswd.exitStatus() != QProcess::NormalExit || gpasswd.exitCode() != 0) {
+            return QString::fromLocal8Bit(gpasswd.readAllStandardError()).trimmed();
+        }
+        return QString();
+    };
+
+    QStringList errors;
+    for (const QString &group : add) {
+        const QString error = run(QStringLiteral("-a"), group);
+        if (!error.isEmpty()) {
+            errors.append(error);
+        }
+    }
+    for (const QString &group : remove) {
+        const QString error = run(QStringLiteral("-d"), group);
+        if (!error.isEmpty()) {
+            errors.append(error);
+        }
+    }
+
+    if (!errors.isEmpty()) {
+        ActionReply reply = ActionReply::HelperErrorReply();
+        reply.setErrorDescription(errors.join(QLatin1Char('\n')));
+        return reply;
+    }
+    return ActionReply::SuccessReply();
+}
+
+KAUTH_HELPER_MAIN("org.kde.kcontrol.kcmusermanager", UserManagerHelper)
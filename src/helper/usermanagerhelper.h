@@ -0,0 +1,47 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#ifndef USER_MANAGER_HELPER_H
+#define USER_MANAGER_HELPER_H
+
+#include <KAuth/KAuthActionReply>
+
+#include <QObject>
+
+using namespace KAuth;
+
+/**
+ * Answers a whole batch of privileged questions about user accounts in one
+ * call, so the module needs a single authorisation however many users it shows.
+ *
+ * Arguments: "uids", a list of uids, and "requests", "aging" and/or "locked".
+ * The reply has one map per uid keyed by the uid as string. The autologin user
+ * is readable without privileges, AutomaticLoginSettings keeps track of it.
+ *
+ * setgroups takes "username" and the group names to "add" it to and "remove"
+ * it from, and applies them with gpasswd so the primary group is never touched.
+ */
+class UserManagerHelper : public QObject
+{
+    Q_OBJECT
+    public Q_SLOTS:
+        ActionReply query(const QVariantMap &args);
+        ActionReply setgroups(const QVariantMap &args);
+};
+
+#endif //USER_MANAGER_HELPER_H
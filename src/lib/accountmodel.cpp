@@ -18,31 +18,157 @@
 
 
 #include "accountmodel.h"
+#include "accountrequestscheduler.h"
+#include "accountsnapshot.h"
+#include "areascaler.h"
+#include "avatarstore.h"
+#include "datachangecoalescer.h"
+#include "emailsettingswriter.h"
+#include "groupindex.h"
+#include "homeusagescanner.h"
+#include "lastloginindex.h"
+#include "startuptrace.h"
+#include "thumbnailcache.h"
+#include "userresourcemonitor.h"
 #include "usersessions.h"
 
 #include "accounts_interface.h"
 #include "user_interface.h"
 
 #include <QApplication>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusServiceWatcher>
+#include <QDate>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QtConcurrent>
 #include <QRandomGenerator>
+#include <QSet>
 #include <QIcon>
+#include <QLocale>
 #include <QStyle>
+#include <QTimer>
 
+#include <KFormat>
 #include <KLocalizedString>
 
 #include <KAuth/KAuthActionReply>
 #include <KAuth/KAuthExecuteJob>
+#include <KJob>
+
+#include <algorithm>
 
 #include <sys/types.h>
 #include <unistd.h>
 
 #include <KConfig>
 #include <KConfigGroup>
+#include <KSharedConfig>
+
+static const int s_defaultCallTimeout = 5000;
+
+// Failed detail fetches are retried after 0.5s, 1s, 2s... up to half a minute
+static const int s_retryDelay = 500;
+static const int s_maxRetryDelay = 30000;
+
+// The details data() serves, only changes to these are worth a dataChanged
+static const char* const s_shownDetails[] = {
+    "UserName",
+    "RealName",
+    "Email",
+    "IconFile",
+    "AccountType"
+};
+
+// In the order SDDM reads them, the last file setting the user wins
+static const char* const s_sddmConfigDirs[] = {
+    "/usr/lib/sddm/sddm.conf.d",
+    "/etc/sddm.conf.d"
+};
+static const char s_sddmConfigFile[] = "/etc/sddm.conf";
+
+static QStringList sddmConfigPaths()
+{
+    QStringList paths;
+    for (const char *dir : s_sddmConfigDirs) {
+        const QDir configDir(QString::fromLatin1(dir));
+        const QStringList names = configDir.entryList({QStringLiteral("*.conf")}, QDir::Files, QDir::Name);
+        for (const QString &name : names) {
+            paths.append(configDir.filePath(name));
+        }
+    }
+    paths.append(QString::fromLatin1(s_sddmConfigFile));
+    return paths;
+}
+
+// Runs on a worker thread, files which did not change since @p known are not parsed again
+static AutomaticLoginSettings::ConfigFiles readConfigFiles(const AutomaticLoginSettings::ConfigFiles &known)
+{
+    QHash<QString, AutomaticLoginSettings::ConfigFile> previous;
+    for (const auto &file : known) {
+        previous.insert(file.path, file);
+    }
+
+    AutomaticLoginSettings::ConfigFiles files;
+    const QStringList paths = sddmConfigPaths();
+    for (const QString &path : paths) {
+        const QFileInfo info(path);
+        if (!info.exists()) {
+            continue;
+        }
+
+        const auto cached = previous.constFind(path);
+        if (cached != previous.constEnd() && cached.value().modified == info.lastModified() && cached.value().size == info.size()) {
+            files.append(cached.value());
+            continue;
+        }
+
+        AutomaticLoginSettings::ConfigFile file;
+        file.path = path;
+        file.modified = info.lastModified();
+        file.size = info.size();
+
+        const KConfig config(path, KConfig::SimpleConfig);
+        const KConfigGroup group = config.group("Autologin");
+        file.hasUser = group.hasKey("User");
+        file.user = group.readEntry("User", QString());
+        files.append(file);
+    }
+
+    return files;
+}
+
+AutomaticLoginSettings::AutomaticLoginSettings(QObject* parent)
+ : QObject(parent)
+ , m_watcher(new QFileSystemWatcher(this))
+ , m_reloadTimer(new QTimer(this))
+ , m_readWatcher(new QFutureWatcher<ConfigFiles>(this))
+{
+    // Editors and the SDDM helper touch several files in a row
+    m_reloadTimer->setSingleShot(true);
+    m_reloadTimer->setInterval(100);
+    connect(m_reloadTimer, &QTimer::timeout, this, &AutomaticLoginSettings::reload);
+
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, m_reloadTimer, QOverload<>::of(&QTimer::start));
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, m_reloadTimer, QOverload<>::of(&QTimer::start));
+    connect(m_readWatcher, &QFutureWatcherBase::finished, this, &AutomaticLoginSettings::readFinished);
+
+    for (const char *dir : s_sddmConfigDirs) {
+        if (QFileInfo::exists(QString::fromLatin1(dir))) {
+            m_watcher->addPath(QString::fromLatin1(dir));
+        }
+    }
+
+    reload();
+}
 
-AutomaticLoginSettings::AutomaticLoginSettings()
+AutomaticLoginSettings::~AutomaticLoginSettings()
 {
-    KConfig config(QStringLiteral("/etc/sddm.conf.d/kde_settings.conf"));
-    m_autoLoginUser = config.group("Autologin").readEntry("User", QString());
+    m_readWatcher->waitForFinished();
 }
 
 QString AutomaticLoginSettings::autoLoginUser() const
@@ -50,7 +176,68 @@ QString AutomaticLoginSettings::autoLoginUser() const
     return m_autoLoginUser;
 }
 
-bool AutomaticLoginSettings::setAutoLoginUser(const QString& username)
+bool AutomaticLoginSettings::isLoaded() const
+{
+    return m_loaded;
+}
+
+void AutomaticLoginSettings::setUser(const QString& username)
+{
+    if (m_autoLoginUser == username) {
+        return;
+    }
+
+    const QString previous = m_autoLoginUser;
+    m_autoLoginUser = username;
+    Q_EMIT autoLoginUserChanged(previous, username);
+}
+
+void AutomaticLoginSettings::reload()
+{
+    if (m_readWatcher->isRunning()) {
+        m_reloadAgain = true;
+        return;
+    }
+
+    m_readWatcher->setFuture(QtConcurrent::run(readConfigFiles, m_files));
+}
+
+void AutomaticLoginSettings::readFinished()
+{
+    m_files = m_readWatcher->result();
+
+    // Rotated or newly created files have to be watched again
+    const QStringList watched = m_watcher->files();
+    for (const auto &file : qAsConst(m_files)) {
+        if (!watched.contains(file.path)) {
+            m_watcher->addPath(file.path);
+        }
+    }
+
+    QString username;
+    for (const auto &file : qAsConst(m_files)) {
+        if (file.hasUser) {
+            username = file.user;
+        }
+    }
+
+    // What is being saved right now wins over what is still on disk
+    if (m_pendingSaves == 0) {
+        setUser(username);
+    }
+
+    if (!m_loaded) {
+        m_loaded = true;
+        Q_EMIT loaded();
+    }
+
+    if (m_reloadAgain) {
+        m_reloadAgain = false;
+        reload();
+    }
+}
+
+void AutomaticLoginSettings::setAutoLoginUser(const QString& username)
 {
     KAuth::Action saveAction(QStringLiteral("org.kde.kcontrol.kcmsddm.save"));
     saveAction.setHelperId(QStringLiteral("org.kde.kcontrol.kcmsddm"));
@@ -58,52 +245,101 @@ bool AutomaticLoginSettings::setAutoLoginUser(const QString& username)
 
     args[QStringLiteral("kde_settings.conf/Autologin/User")] = username;
 
-    saveAction.setHelperId(QStringLiteral("org.kde.kcontrol.kcmsddm"));
     saveAction.setArguments(args);
 
-    auto job = saveAction.execute();
-    if (!job->exec()) {
+    if (m_pendingSaves++ == 0) {
+        m_savedAutoLoginUser = m_autoLoginUser;
+    }
+    setUser(username);
+
+    KAuth::ExecuteJob *job = saveAction.execute();
+    connect(job, &KJob::result, this, &AutomaticLoginSettings::saveFinished);
+    job->start();
+}
+
+void AutomaticLoginSettings::saveFinished(KJob* job)
+{
+    --m_pendingSaves;
+
+    if (job->error()) {
         qCWarning(USER_MANAGER_LOG) << "fail" << job->errorText();
-        return false;
+        if (m_pendingSaves == 0) {
+            setUser(m_savedAutoLoginUser);
+        }
+        if (job->error() != KAuth::ActionReply::UserCancelledError) {
+            Q_EMIT saveFailed(job->errorText());
+        }
     }
 
-    m_autoLoginUser = username;
-    return true;
+    // A file later in the merge order may still override what was written
+    if (m_pendingSaves == 0) {
+        reload();
+    }
 }
 
 typedef OrgFreedesktopAccountsInterface AccountsManager;
 typedef OrgFreedesktopAccountsUserInterface Account;
 AccountModel::AccountModel(QObject* parent)
  : QAbstractListModel(parent)
- , m_sessions(new UserSession(this))
+ , m_scheduler(new AccountRequestScheduler(QDBusConnection::systemBus(), this))
+ , m_changes(new DataChangeCoalescer(this))
+ , m_homeUsage(new HomeUsageScanner(this))
+ , m_probeTimer(new QTimer(this))
+ , m_emailSettings(new EmailSettingsWriter(this))
+ , m_serviceWatcher(new QDBusServiceWatcher(QStringLiteral("org.freedesktop.Accounts"), QDBusConnection::systemBus(),
+                                            QDBusServiceWatcher::WatchForOwnerChange, this))
 {
-    m_dbus = new AccountsManager(QStringLiteral("org.freedesktop.Accounts"), QStringLiteral("/org/freedesktop/Accounts"), QDBusConnection::systemBus(), this);
-    QDBusPendingReply <QList <QDBusObjectPath > > reply = m_dbus->ListCachedUsers();
-    reply.waitForFinished();
+    // accountsservice may restart underneath us (upgrades, crashes), see resync()
+    connect(m_serviceWatcher, &QDBusServiceWatcher::serviceOwnerChanged, this, &AccountModel::serviceOwnerChanged);
+    connect(m_changes, &DataChangeCoalescer::dataChanged, this, &AccountModel::dataChanged);
+    connect(m_homeUsage, &HomeUsageScanner::usageReady, this, &AccountModel::homeUsageReady);
 
-    if (reply.isError()) {
-        qCDebug(USER_MANAGER_LOG) << reply.error().message();
-        return;
-    }
+    const KConfigGroup dbusGroup(KSharedConfig::openConfig(QStringLiteral("kcm_usermanagerrc")), "DBus");
+    m_callTimeout = dbusGroup.readEntry("CallTimeout", s_defaultCallTimeout);
 
-    const QList<QDBusObjectPath> users = reply.value();
-    for (const QDBusObjectPath& path : users) {
-        addAccount(path.path());
-    }
+    m_scheduler->setTimeout(m_callTimeout);
+    connect(m_scheduler, &AccountRequestScheduler::detailsReady, this, &AccountModel::detailsReady);
+    connect(m_scheduler, &AccountRequestScheduler::detailsFailed, this, &AccountModel::detailsFailed);
 
-    // Adding fake "new user" directly into cache
-    addAccountToCache(QStringLiteral("new-user"), nullptr);
+    m_probeTimer->setInterval(2 * m_callTimeout);
+    connect(m_probeTimer, &QTimer::timeout, this, &AccountModel::probeService);
 
-    m_kEmailSettings.setProfile(m_kEmailSettings.defaultProfileName());
+    m_dbus = new AccountsManager(QStringLiteral("org.freedesktop.Accounts"), QStringLiteral("/org/freedesktop/Accounts"), QDBusConnection::systemBus(), this);
+    m_dbus->setTimeout(m_callTimeout);
 
     connect(m_dbus, &OrgFreedesktopAccountsInterface::UserAdded, this, &AccountModel::UserAdded);
     connect(m_dbus, &OrgFreedesktopAccountsInterface::UserDeleted, this, &AccountModel::UserDeleted);
 
-    connect(m_sessions, &UserSession::userLogged, this, &AccountModel::userLogged);
+    // Nothing below may block: the module is painted as soon as the constructor returns.
+    // The SDDM configuration is parsed on a worker thread, logind is asked once the
+    // event loop runs and KEMailSettings is only opened, off the main thread, when
+    // something is saved.
+    m_autoLoginSettings = new AutomaticLoginSettings(this);
+    connect(m_autoLoginSettings, &AutomaticLoginSettings::autoLoginUserChanged, this, &AccountModel::autoLoginUserChanged);
+    connect(m_autoLoginSettings, &AutomaticLoginSettings::saveFailed, this, &AccountModel::callFailed);
+    connect(m_autoLoginSettings, &AutomaticLoginSettings::loaded, this, []() {
+        StartupTrace::mark("autologin configuration parsed");
+    });
+
+    QTimer::singleShot(0, this, &AccountModel::createUserSession);
+
+    // Show what we had last time right away, or otherwise the current user ahead of
+    // everybody else. Either way the list is revalidated in the background.
+    if (!loadSnapshot()) {
+        addAccountToCache(QStringLiteral("new-user"), nullptr);
+
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(m_dbus->FindUserById(getuid()), this);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, &AccountModel::currentUserFound);
+    }
+
+    resync();
+    StartupTrace::mark("account model constructed");
 }
 
 AccountModel::~AccountModel()
 {
+    saveSnapshot();
+
     delete m_dbus;
     qDeleteAll(m_users);
 }
@@ -123,51 +359,146 @@ QVariant AccountModel::data(const QModelIndex& index, int role) const
         return QVariant();
     }
 
-    if (index.row() >= m_users.count()) {
+    if (index.row() >= m_rows.count()) {
         return QVariant();
     }
 
-    QString path = m_userPath.at(index.row());
-    Account* acc = m_users.value(path);
-    if (!acc) {
+    // The roles every paint asks for are answered from the row alone
+    const AccountRow &row = accountRow(index.row());
+    if (!row.account) {
         //new user
         return newUserData(role);
     }
 
     switch(role) {
         case Qt::DisplayRole || AccountModel::FriendlyName:
-            if (!acc->realName().isEmpty()) {
-                return acc->realName();
-            }
-            return acc->userName();
+            return row.display;
         case Qt::DecorationRole || AccountModel::Face:
-        {
-            QFile file(acc->iconFile());
-            int size = QApplication::style()->pixelMetric(QStyle::PM_LargeIconSize);
-            if (!file.exists()) {
-                return QIcon::fromTheme(QStringLiteral("user-identity")).pixmap(size, size);
+            return row.face;
+        case AccountModel::Username:
+            return row.username;
+        case AccountModel::Logged:
+            if (!row.hasUid) {
+                return QVariant();
             }
-            auto pixMap = QPixmap(file.fileName()).scaled(static_cast<int>(size * m_dpr), static_cast<int>(size * m_dpr), Qt::KeepAspectRatio, Qt::SmoothTransformation);
-            pixMap.setDevicePixelRatio(m_dpr);
-            return pixMap;
+            return m_sessions && m_sessions->isLogged(row.uid);
+    }
+
+    const QString &path = m_userPath.at(index.row());
+    switch(role) {
+        case Qt::ToolTipRole: {
+            QStringList lines;
+            const QVariant cpu = data(index, AccountModel::CpuUsage);
+            const QVariant memory = data(index, AccountModel::MemoryUsage);
+            if (cpu.isValid() && memory.isValid()) {
+                lines << i18nc("@info:tooltip resource usage of a logged in user", "CPU: %1%\nMemory: %2",
+                               qRound(cpu.toReal()), KFormat().formatByteSize(memory.toLongLong()));
+            }
+            if (data(index, AccountModel::Logged).toBool()) {
+                lines << i18nc("@info:tooltip", "Logged in now");
+            } else {
+                const QDateTime lastLogin = data(index, AccountModel::LastLogin).toDateTime();
+                if (lastLogin.isValid()) {
+                    lines << i18nc("@info:tooltip", "Last login: %1", QLocale().toString(lastLogin, QLocale::ShortFormat));
+                }
+            }
+            if (data(index, AccountModel::PasswordLocked).toBool()) {
+                lines << i18nc("@info:tooltip", "Password locked");
+            } else {
+                const QDate expires = data(index, AccountModel::PasswordExpires).toDate();
+                if (expires.isValid()) {
+                    lines << i18nc("@info:tooltip", "Password expires: %1", QLocale().toString(expires, QLocale::ShortFormat));
+                }
+            }
+            const QVariant home = data(index, AccountModel::HomeUsage);
+            if (home.isValid()) {
+                lines << i18nc("@info:tooltip disk space used by the home folder", "Home folder: %1",
+                               KFormat().formatByteSize(home.toLongLong()));
+            }
+            return lines.isEmpty() ? QVariant() : QVariant(lines.join(QLatin1Char('\n')));
         }
         case AccountModel::RealName:
-            return acc->realName();
-        case AccountModel::Username:
-            return acc->userName();
+            return detail(path, QStringLiteral("RealName"));
         case AccountModel::Email:
-            return acc->email();
+            return detail(path, QStringLiteral("Email"));
         case AccountModel::Administrator:
-            return acc->accountType() == 1;
+            return detail(path, QStringLiteral("AccountType")).toInt() == 1;
         case AccountModel::AutomaticLogin: {
             const QString username = index.data(AccountModel::Username).toString();
-            return m_autoLoginSettings.autoLoginUser() == username;
+            return !username.isEmpty() && m_autoLoginSettings->autoLoginUser() == username;
         }
-        case AccountModel::Logged:
-            if (m_loggedAccounts.contains(path)) {
-                return m_loggedAccounts[path];
+        case AccountModel::SessionCount:
+        case AccountModel::SessionState: {
+            const QVariant uid = detail(path, QStringLiteral("Uid"));
+            if (!uid.isValid()) {
+                return QVariant();
+            }
+            if (role == AccountModel::SessionCount) {
+                return m_sessions ? m_sessions->sessionCount(uid.toUInt()) : 0;
+            }
+            return m_sessions ? m_sessions->state(uid.toUInt()) : QString();
+        }
+        case AccountModel::CpuUsage:
+        case AccountModel::MemoryUsage: {
+            const QVariant uid = detail(path, QStringLiteral("Uid"));
+            if (!uid.isValid() || !m_resources) {
+                return QVariant();
+            }
+            if (role == AccountModel::CpuUsage) {
+                const qreal cpu = m_resources->cpuUsage(uid.toUInt());
+                return cpu < 0 ? QVariant() : QVariant(cpu);
+            }
+            const qint64 memory = m_resources->memoryUsage(uid.toUInt());
+            return memory < 0 ? QVariant() : QVariant(memory);
+        }
+        case AccountModel::HomeUsage: {
+            const QVariant uid = detail(path, QStringLiteral("Uid"));
+            if (!uid.isValid()) {
+                return QVariant();
+            }
+            const qint64 bytes = m_homeUsage->usage(uid.toUInt());
+            return bytes < 0 ? QVariant() : QVariant(bytes);
+        }
+        case AccountModel::LastLogin: {
+            const QVariant uid = detail(path, QStringLiteral("Uid"));
+            if (!uid.isValid() || !m_lastLogin) {
+                return QVariant();
+            }
+            const QDateTime lastLogin = m_lastLogin->lastLogin(uid.toUInt(), detail(path, QStringLiteral("UserName")).toString());
+            return lastLogin.isValid() ? QVariant(lastLogin) : QVariant();
+        }
+        case AccountModel::Groups:
+            if (!m_groups) {
+                return QVariant();
+            }
+            return m_groups->groupsOf(detail(path, QStringLiteral("UserName")).toString());
+        case AccountModel::PasswordLocked:
+        case AccountModel::PasswordChanged:
+        case AccountModel::PasswordExpires: {
+            const QVariant uid = detail(path, QStringLiteral("Uid"));
+            const auto status = uid.isValid() ? m_privileged.constFind(uid.toUInt()) : m_privileged.constEnd();
+            if (status == m_privileged.constEnd()) {
+                return QVariant();
+            }
+            if (role == AccountModel::PasswordLocked) {
+                return status.value().value(QStringLiteral("locked"));
+            }
+
+            // shadow(5) counts days since the epoch, 0 means the password has to be changed
+            const qlonglong lastChange = status.value().value(QStringLiteral("lastChange"), -1).toLongLong();
+            if (lastChange <= 0) {
+                return QVariant();
+            }
+            const QDate changed = QDate(1970, 1, 1).addDays(lastChange);
+            if (role == AccountModel::PasswordChanged) {
+                return changed;
             }
-            return QVariant();
+            const qlonglong maxDays = status.value().value(QStringLiteral("maxDays"), -1).toLongLong();
+            if (maxDays < 0 || maxDays >= 99999) {
+                return QVariant();
+            }
+            return changed.addDays(maxDays);
+        }
         case AccountModel::Created:
             return true;
     }
@@ -191,79 +522,115 @@ bool AccountModel::setData(const QModelIndex& index, const QVariant& value, int
         return newUserSetData(index, value, role);
     }
 
+    if (m_degraded) {
+        // Do not queue up more writes behind a service which stopped answering
+        return false;
+    }
+
+    // Writes are optimistic: the cached details are updated right away and
+    // refetched from accountsservice should the call fail, see callFinished()
     switch(role) {
         //The modification of the face file should be done outside
         case AccountModel::Face:
-            if (checkForErrors(acc->SetIconFile(value.toString()))) {
-                return false;
+            // accountsservice would copy the very same picture over its own copy
+            if (!value.toString().isEmpty()
+                && AvatarStore::sameContent(value.toString(), detail(path, QStringLiteral("IconFile")).toString())) {
+                qCDebug(USER_MANAGER_LOG) << "Face of" << path << "is unchanged";
+                return true;
             }
-            emit dataChanged(index, index);
+            callAsync(path, acc->SetIconFile(value.toString()));
+            setDetail(path, QStringLiteral("IconFile"), value.toString());
+            m_faces.remove(path);
+            m_changes->add(index.row());
             return true;
         case AccountModel::RealName:
-            if (checkForErrors(acc->SetRealName(value.toString()))) {
-                return false;
-            }
-            m_kEmailSettings.setSetting(KEMailSettings::RealName, value.toString());
+            callAsync(path, acc->SetRealName(value.toString()));
+            setDetail(path, QStringLiteral("RealName"), value.toString());
+            queueEmailSetting(path, KEMailSettings::RealName, value.toString());
 
-            emit dataChanged(index, index);
+            m_changes->add(index.row());
             return true;
         case AccountModel::Username:
-            if (checkForErrors(acc->SetUserName(value.toString()))) {
-                return false;
-            }
+            callAsync(path, acc->SetUserName(value.toString()));
+            setDetail(path, QStringLiteral("UserName"), value.toString());
 
-            emit dataChanged(index, index);
+            m_changes->add(index.row());
             return true;
         case AccountModel::Password:
-            if (checkForErrors(acc->SetPassword(cryptPassword(value.toString()), QString()))) {
-                return false;
-            }
+            callAsync(path, acc->SetPassword(cryptPassword(value.toString()), QString()));
 
-            emit dataChanged(index, index);
+            m_changes->add(index.row());
             return true;
         case AccountModel::Email:
-            if (checkForErrors(acc->SetEmail(value.toString()))) {
-                return false;
-            }
-            m_kEmailSettings.setSetting(KEMailSettings::EmailAddress, value.toString());
+            callAsync(path, acc->SetEmail(value.toString()));
+            setDetail(path, QStringLiteral("Email"), value.toString());
+            queueEmailSetting(path, KEMailSettings::EmailAddress, value.toString());
 
-            emit dataChanged(index, index);
+            m_changes->add(index.row());
             return true;
         case AccountModel::Administrator:
-            if (checkForErrors(acc->SetAccountType(value.toBool() ? 1 : 0))) {
-                return false;
-            }
+            callAsync(path, acc->SetAccountType(value.toBool() ? 1 : 0));
+            setDetail(path, QStringLiteral("AccountType"), value.toBool() ? 1 : 0);
 
-            emit dataChanged(index, index);
+            m_changes->add(index.row());
             return true;
         case AccountModel::AutomaticLogin:
         {
             const bool autoLoginSet = value.toBool();
             const QString username = index.data(AccountModel::Username).toString();
 
-            //if the checkbox is set and the SDDM config is not already us, set it to us
-            //all rows need updating as we may have unset it from someone else.
-            if (autoLoginSet && m_autoLoginSettings.autoLoginUser() != username) {
-                if (m_autoLoginSettings.setAutoLoginUser(username)) {
-                    emit dataChanged(createIndex(0, 0), createIndex(rowCount(), 0));
-                    return true;
-                }
-                return false;
+            //if the checkbox is set and the SDDM config is not already us, set it to us.
+            //Whoever had it before loses it, autoLoginUserChanged() updates both rows.
+            if (autoLoginSet && m_autoLoginSettings->autoLoginUser() != username) {
+                m_autoLoginSettings->setAutoLoginUser(username);
             }
             //if the checkbox is not set and the SDDM config is set to us, then clear it
-            else if (!autoLoginSet && m_autoLoginSettings.autoLoginUser() == username) {
-                if (m_autoLoginSettings.setAutoLoginUser(QString())) {
-                    emit dataChanged(index, index);
-                    return true;
-                }
-                return false;
+            else if (!autoLoginSet && m_autoLoginSettings->autoLoginUser() == username) {
+                m_autoLoginSettings->setAutoLoginUser(QString());
             }
             return true;
         }
-        case AccountModel::Logged:
-            m_loggedAccounts[path] = value.toBool();
-            emit dataChanged(index, index);
+        case AccountModel::Groups:
+        {
+            if (!m_groups) {
+                return false;
+            }
+
+            const QString username = detail(path, QStringLiteral("UserName")).toString();
+            const QString primary = m_groups->primaryGroupOf(username);
+            const QStringList current = m_groups->groupsOf(username);
+            const QStringList wanted = value.toStringList();
+
+            QStringList add;
+            QStringList remove;
+            for (const QString &group : wanted) {
+                if (group != primary && !current.contains(group)) {
+                    add.append(group);
+                }
+            }
+            for (const QString &group : current) {
+                if (group != primary && !wanted.contains(group)) {
+                    remove.append(group);
+                }
+            }
+            if (add.isEmpty() && remove.isEmpty()) {
+                return true;
+            }
+
+            // The group file watcher reports the result, nothing to update here
+            KAuth::Action action(QStringLiteral("org.kde.kcontrol.kcmusermanager.setgroups"));
+            action.setHelperId(QStringLiteral("org.kde.kcontrol.kcmusermanager"));
+            action.setArguments({
+                {QStringLiteral("username"), username},
+                {QStringLiteral("add"), add},
+                {QStringLiteral("remove"), remove}
+            });
+
+            KAuth::ExecuteJob *job = action.execute();
+            connect(job, &KJob::result, this, &AccountModel::groupsSaved);
+            job->start();
             return true;
+        }
         case AccountModel::Created:
             qFatal("AccountModel NewAccount should never be set");
             return false;
@@ -282,11 +649,68 @@ bool AccountModel::removeRows(int row, int count, const QModelIndex& parent)
 
 bool AccountModel::removeAccountKeepingFiles(int row, bool keepFile)
 {
-    Account* acc = m_users.value(m_userPath.at(row));
-    QDBusPendingReply <void > rep = m_dbus->DeleteUser(acc->uid(), keepFile);
-    rep.waitForFinished();
+    if (m_degraded) {
+        return false;
+    }
+
+    const QString path = m_userPath.at(row);
+    const QVariant uid = detail(path, QStringLiteral("Uid"));
+    const qlonglong id = uid.isValid() ? uid.toLongLong() : m_users.value(path)->uid();
+
+    // The row goes away once accountsservice announces it through UserDeleted
+    callAsync(path, m_dbus->DeleteUser(id, keepFile));
+    return true;
+}
+
+bool AccountModel::removeAccounts(const QModelIndexList& indexes, bool deleteFiles, bool endSessionsFirst)
+{
+    if (m_degraded) {
+        return false;
+    }
+
+    QList<uint> logged;
+    for (const QModelIndex &index : indexes) {
+        if (!index.isValid() || index.row() >= m_userPath.count() || !m_users.value(m_userPath.at(index.row()))) {
+            continue;
+        }
+
+        const QVariant uid = detail(m_userPath.at(index.row()), QStringLiteral("Uid"));
+        if (endSessionsFirst && m_sessions && uid.isValid() && m_sessions->isLogged(uid.toUInt())) {
+            m_removeAfterLogout.insert(uid.toUInt(), deleteFiles);
+            logged.append(uid.toUInt());
+            continue;
+        }
+
+        removeAccountKeepingFiles(index.row(), deleteFiles);
+    }
+
+    // All of them are logged out concurrently, see sessionsEnded()
+    if (!logged.isEmpty()) {
+        m_sessions->endSessions(logged);
+    }
+    return true;
+}
+
+void AccountModel::endSessions(const QModelIndexList& indexes, bool force)
+{
+    if (!m_sessions) {
+        return;
+    }
+
+    QList<uint> uids;
+    for (const QModelIndex &index : indexes) {
+        if (!index.isValid() || index.row() >= m_userPath.count()) {
+            continue;
+        }
+
+        const QString path = m_userPath.at(index.row());
+        const QVariant uid = detail(path, QStringLiteral("Uid"));
+        if (path != m_currentUserPath && uid.isValid() && m_sessions->isLogged(uid.toUInt())) {
+            uids.append(uid.toUInt());
+        }
+    }
 
-    return !rep.isError();
+    m_sessions->endSessions(uids, force);
 }
 
 QVariant AccountModel::newUserData(int role) const
@@ -304,8 +728,19 @@ QVariant AccountModel::newUserData(int role) const
 
 bool AccountModel::newUserSetData(const QModelIndex &index, const QVariant& value, int roleInt)
 {
+    Q_UNUSED(index)
+    if (m_degraded) {
+        return false;
+    }
+
     AccountModel::Role role = static_cast<AccountModel::Role>(roleInt);
     m_newUserData[role] = value;
+
+    //Everything set while CreateUser is in flight is applied by userCreated()
+    if (m_creatingUser) {
+        return true;
+    }
+
     QList<AccountModel::Role> roles = m_newUserData.keys();
     if (!roles.contains(Username) || !roles.contains(RealName)) {
         return true;
@@ -317,65 +752,108 @@ bool AccountModel::newUserSetData(const QModelIndex &index, const QVariant& valu
         userType = m_newUserData[Administrator].toBool();
     }
 
+    m_creatingUser = true;
     QDBusPendingReply <QDBusObjectPath > reply = m_dbus->CreateUser(m_newUserData[Username].toString(), m_newUserData[RealName].toString(), userType);
-    reply.waitForFinished();
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(reply, this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, &AccountModel::userCreated);
 
-    if (reply.isError()) {
-        qCDebug(USER_MANAGER_LOG) << reply.error().name();
-        qCDebug(USER_MANAGER_LOG) << reply.error().message();
+    return true;
+}
+
+void AccountModel::userCreated(QDBusPendingCallWatcher* watcher)
+{
+    watcher->deleteLater();
+    m_creatingUser = false;
+
+    QDBusPendingReply <QDBusObjectPath > reply = *watcher;
+    if (checkForErrors(reply)) {
         m_newUserData.clear();
-        return false;
+        return;
+    }
+
+    const QString path = reply.value().path();
+    UserAdded(reply.value());
+
+    // Seed the details we already know, the extra roles below depend on them
+    if (!m_details.contains(path)) {
+        QVariantMap details;
+        details.insert(QStringLiteral("UserName"), m_newUserData.value(Username));
+        details.insert(QStringLiteral("RealName"), m_newUserData.value(RealName));
+        details.insert(QStringLiteral("AccountType"), m_newUserData.value(Administrator).toBool() ? 1 : 0);
+        m_details.insert(path, details);
+        invalidateRow(rowOf(path));
     }
 
     m_newUserData.remove(Username);
     m_newUserData.remove(RealName);
 
-    UserAdded(reply.value());
-
     //If we don't have anything else to set just return
-    if (m_newUserData.isEmpty()) {
-        return true;
+    const int row = rowOf(path);
+    if (m_newUserData.isEmpty() || row < 0) {
+        m_newUserData.clear();
+        return;
     }
 
-    QHash<AccountModel::Role, QVariant>::const_iterator i = m_newUserData.constBegin();
-    while (i != m_newUserData.constEnd()) {
+    const QModelIndex index = this->index(row);
+    const QHash<AccountModel::Role, QVariant> extra = m_newUserData;
+    m_newUserData.clear();
+
+    QHash<AccountModel::Role, QVariant>::const_iterator i = extra.constBegin();
+    while (i != extra.constEnd()) {
         qCDebug(USER_MANAGER_LOG) << "Setting extra:" << i.key() << "with value:" << i.value();
         setData(index, i.value(), i.key());
         ++i;
     }
-
-    m_newUserData.clear();
-
-    return true;
 }
 
-void AccountModel::addAccount(const QString& path)
+Account* AccountModel::createAccount(const QString& path)
 {
     Account *acc = new Account(QStringLiteral("org.freedesktop.Accounts"), path, QDBusConnection::systemBus(), this);
-    qulonglong uid = acc->uid();
-    if (!acc->isValid() || acc->lastError().isValid() || acc->systemAccount()) {
-        return;
+    if (!acc->isValid() || acc->lastError().isValid()) {
+        delete acc;
+        return nullptr;
     }
 
+    // System accounts are dropped once their details arrive, see detailsReady()
+    acc->setTimeout(m_callTimeout);
     connect(acc, &OrgFreedesktopAccountsUserInterface::Changed, this, &AccountModel::Changed);
-    if (uid == getuid()) {
-        addAccountToCache(path, acc, 0);
-        return;
-    }
-
-    addAccountToCache(path, acc);
+    return acc;
 }
 
 void AccountModel::addAccountToCache(const QString& path, Account* acc, int pos)
 {
+    AccountRow row;
+    row.account = acc;
     if (pos > -1) {
         m_userPath.insert(pos, path);
+        m_rows.insert(pos, row);
+        updatePathRows(pos);
     } else {
         m_userPath.append(path);
+        m_rows.append(row);
+        m_pathRows.insert(path, m_userPath.count() - 1);
     }
 
     m_users.insert(path, acc);
-    m_loggedAccounts[path] = false;
+
+    if (acc) {
+        m_scheduler->request(path);
+    }
+}
+
+int AccountModel::rowOf(const QString &path) const
+{
+    return m_pathRows.value(path, -1);
+}
+
+void AccountModel::updatePathRows(int first, int last)
+{
+    if (last < 0 || last >= m_userPath.count()) {
+        last = m_userPath.count() - 1;
+    }
+    for (int row = first; row <= last; ++row) {
+        m_pathRows.insert(m_userPath.at(row), row);
+    }
 }
 
 void AccountModel::replaceAccount(const QString &path, OrgFreedesktopAccountsUserInterface *acc, int pos)
@@ -383,64 +861,468 @@ void AccountModel::replaceAccount(const QString &path, OrgFreedesktopAccountsUse
     if (pos >= m_userPath.size() || pos < 0) {
         return;
     }
+    m_pathRows.remove(m_userPath.at(pos));
     m_userPath.replace(pos, path);
+    m_pathRows.insert(path, pos);
+    m_rows[pos] = AccountRow();
+    m_rows[pos].account = acc;
 
     m_users.insert(path, acc);
-    m_loggedAccounts[path] = false;
+
+    m_scheduler->request(path);
 }
 
 void AccountModel::removeAccount(const QString& path)
 {
-    m_userPath.removeAll(path);
+    const int row = rowOf(path);
+    if (row >= 0) {
+        m_userPath.removeAt(row);
+        m_rows.remove(row);
+        m_pathRows.remove(path);
+        updatePathRows(row);
+    }
     delete m_users.take(path);
-    m_loggedAccounts.remove(path);
+    m_faces.remove(path);
+    m_detailRetries.remove(path);
+    m_scheduler->cancel(path);
+
+    const QVariantMap details = m_details.take(path);
+    if (!details.isEmpty()) {
+        m_uidPaths.remove(details.value(QStringLiteral("Uid")).toUInt());
+        m_privileged.remove(details.value(QStringLiteral("Uid")).toUInt());
+    }
 }
 
-bool AccountModel::checkForErrors(QDBusPendingReply<void> reply) const
+void AccountModel::callAsync(const QString& path, const QDBusPendingCall& call)
 {
-    reply.waitForFinished();
-    if (reply.isError()) {
-        qCDebug(USER_MANAGER_LOG) << reply.error().name();
-        qCDebug(USER_MANAGER_LOG) << reply.error().message();
-        return true;
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, this);
+    m_pendingCalls.insert(watcher, path);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, &AccountModel::callFinished);
+}
+
+void AccountModel::callFinished(QDBusPendingCallWatcher* watcher)
+{
+    const QString path = m_pendingCalls.take(watcher);
+    watcher->deleteLater();
+
+    if (!checkForErrors(*watcher)) {
+        setDegraded(false);
+        return;
     }
 
-    return false;
+    // Our optimistic copy of the details is wrong now, ask what the service really has
+    if (m_users.value(path)) {
+        m_scheduler->request(path);
+    }
 }
 
-QVariant AccountModel::headerData(int section, Qt::Orientation orientation, int role) const
+void AccountModel::cancelPendingCalls()
 {
-    Q_UNUSED(section);
-    if (role != Qt::DisplayRole) {
-        return QVariant();
+    const QHash<QDBusPendingCallWatcher*, QString> pending = m_pendingCalls;
+    m_pendingCalls.clear();
+
+    for (auto it = pending.constBegin(); it != pending.constEnd(); ++it) {
+        delete it.key();
+        if (m_users.value(it.value())) {
+            m_scheduler->request(it.value());
+        }
     }
 
-    if (orientation == Qt::Vertical) {
-        return QVariant();
+    m_scheduler->abort();
+    if (m_degraded) {
+        probeService();
+    }
+}
+
+bool AccountModel::checkForErrors(const QDBusPendingCall &call)
+{
+    if (!call.isError()) {
+        return false;
     }
 
-    return i18n("Users");
+    const QDBusError error = call.error();
+    qCDebug(USER_MANAGER_LOG) << error.name();
+    qCDebug(USER_MANAGER_LOG) << error.message();
+
+    Q_EMIT callFailed(error.message());
+    if (error.type() == QDBusError::NoReply || error.type() == QDBusError::Timeout) {
+        setDegraded(true);
+    }
+
+    return true;
 }
 
-void AccountModel::UserAdded(const QDBusObjectPath& dbusPath)
+void AccountModel::detailsFailed(const QString& path, const QDBusError& error)
 {
-    QString path = dbusPath.path();
-    if (m_userPath.contains(path)) {
-        qCDebug(USER_MANAGER_LOG) << "We already have:" << path;
-        return;
+    if (error.type() == QDBusError::NoReply || error.type() == QDBusError::Timeout) {
+        setDegraded(true);
     }
 
-    Account* acc = new Account(QStringLiteral("org.freedesktop.Accounts"), path, QDBusConnection::systemBus(), this);
-    if (acc->systemAccount()) {
+    if (!m_users.value(path)) {
         return;
     }
-    connect(acc, &OrgFreedesktopAccountsUserInterface::Changed, this, &AccountModel::Changed);
 
-    // First, we modify "new-user" to become the new created user
-    int row = rowCount();
+    // Nothing else asks again before the next resync and the row would stay "Loading…"
+    const int attempt = m_detailRetries.value(path);
+    m_detailRetries.insert(path, attempt + 1);
+    const int delay = qMin(s_maxRetryDelay, s_retryDelay << qMin(attempt, 6));
+    QTimer::singleShot(delay, this, [this, path]() {
+        if (m_users.value(path)) {
+            m_scheduler->request(path);
+        }
+    });
+}
+
+void AccountModel::setDegraded(bool degraded)
+{
+    if (m_degraded == degraded) {
+        return;
+    }
+
+    qCWarning(USER_MANAGER_LOG) << "accountsservice" << (degraded ? "missed its deadline" : "is answering again");
+    m_degraded = degraded;
+    if (degraded) {
+        m_probeTimer->start();
+    } else {
+        m_probeTimer->stop();
+    }
+
+    Q_EMIT degradedChanged(degraded);
+}
+
+void AccountModel::probeService()
+{
+    // Not Peer.Ping: GDBus answers that from its worker thread even while the
+    // service's main loop is stuck, a property has to come from the service itself
+    QDBusMessage probe = QDBusMessage::createMethodCall(QStringLiteral("org.freedesktop.Accounts"),
+                                                        QStringLiteral("/org/freedesktop/Accounts"),
+                                                        QStringLiteral("org.freedesktop.DBus.Properties"),
+                                                        QStringLiteral("Get"));
+    probe << QStringLiteral("org.freedesktop.Accounts") << QStringLiteral("DaemonVersion");
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(QDBusConnection::systemBus().asyncCall(probe, m_callTimeout), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this](QDBusPendingCallWatcher *watcher) {
+        watcher->deleteLater();
+        if (watcher->isError()) {
+            return;
+        }
+
+        // Signals may have been lost while the service was stuck
+        if (m_degraded) {
+            resync();
+        }
+        setDegraded(false);
+    });
+}
+
+void AccountModel::currentUserFound(QDBusPendingCallWatcher* watcher)
+{
+    watcher->deleteLater();
+
+    QDBusPendingReply <QDBusObjectPath> reply = *watcher;
+    if (reply.isError()) {
+        qCDebug(USER_MANAGER_LOG) << "Current user not found:" << reply.error().message();
+        return;
+    }
+
+    m_currentUserPath = reply.value().path();
+    StartupTrace::mark("current user found");
+
+    const int row = rowOf(m_currentUserPath);
+    if (row == 0) {
+        return;
+    }
+
+    // The complete list came back first, move us to the top
+    if (row > 0) {
+        beginMoveRows(QModelIndex(), row, row, QModelIndex(), 0);
+        m_userPath.move(row, 0);
+        m_rows.move(row, 0);
+        updatePathRows(0, row);
+        endMoveRows();
+        return;
+    }
+
+    Account *acc = createAccount(m_currentUserPath);
+    if (!acc) {
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), 0, 0);
+    addAccountToCache(m_currentUserPath, acc, 0);
+    endInsertRows();
+}
+
+void AccountModel::autoLoginUserChanged(const QString &previous, const QString &username)
+{
+    if (previous == username) {
+        return;
+    }
+
+    // Rows still waiting for their details get it right when those arrive
+    for (int row = 0; row < m_userPath.count(); ++row) {
+        const QString rowUser = detail(m_userPath.at(row), QStringLiteral("UserName")).toString();
+        if (!rowUser.isEmpty() && (rowUser == previous || rowUser == username)) {
+            m_changes->add(row, {AutomaticLogin});
+        }
+    }
+}
+
+void AccountModel::fetchPrivilegedDetails()
+{
+    if (m_fetchingPrivileged) {
+        return;
+    }
+
+    QVariantList uids;
+    for (auto it = m_uidPaths.constBegin(); it != m_uidPaths.constEnd(); ++it) {
+        uids.append(it.key());
+    }
+
+    KAuth::Action action(QStringLiteral("org.kde.kcontrol.kcmusermanager.query"));
+    action.setHelperId(QStringLiteral("org.kde.kcontrol.kcmusermanager"));
+    action.setArguments({
+        {QStringLiteral("uids"), uids},
+        {QStringLiteral("requests"), QStringList{QStringLiteral("aging"), QStringLiteral("locked")}}
+    });
+
+    m_fetchingPrivileged = true;
+    KAuth::ExecuteJob *job = action.execute();
+    connect(job, &KJob::result, this, &AccountModel::privilegedDetailsReceived);
+    job->start();
+}
+
+void AccountModel::privilegedDetailsReceived(KJob *job)
+{
+    m_fetchingPrivileged = false;
+
+    if (job->error()) {
+        if (job->error() != KAuth::ActionReply::UserCancelledError && job->error() != KAuth::ActionReply::AuthorizationDeniedError) {
+            Q_EMIT callFailed(job->errorText());
+        }
+        return;
+    }
+
+    const QVariantMap data = static_cast<KAuth::ExecuteJob*>(job)->data();
+
+    for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
+        bool isUid = false;
+        const uint uid = it.key().toUInt(&isUid);
+        if (!isUid) {
+            continue;
+        }
+
+        m_privileged.insert(uid, it.value().toMap());
+        const int row = rowOf(accountPathForUid(uid));
+        if (row >= 0) {
+            m_changes->add(row, {PasswordLocked, PasswordChanged, PasswordExpires, Qt::ToolTipRole});
+        }
+    }
+}
+
+void AccountModel::groupsSaved(KJob *job)
+{
+    if (job->error() && job->error() != KAuth::ActionReply::UserCancelledError) {
+        Q_EMIT callFailed(job->errorText());
+    }
+}
+
+QStringList AccountModel::availableGroups() const
+{
+    return m_groups ? m_groups->groups() : QStringList();
+}
+
+QString AccountModel::primaryGroup(const QModelIndex &index) const
+{
+    if (!m_groups || !index.isValid() || index.row() >= m_userPath.count()) {
+        return QString();
+    }
+    return m_groups->primaryGroupOf(detail(m_userPath.at(index.row()), QStringLiteral("UserName")).toString());
+}
+
+void AccountModel::createUserSession()
+{
+    m_sessions = new UserSession(this);
+    connect(m_sessions, &UserSession::sessionsChanged, this, &AccountModel::sessionsChanged);
+    connect(m_sessions, &UserSession::sessionsEnded, this, &AccountModel::sessionsEnded);
+    connect(m_sessions, &UserSession::endSessionsFailed, this, &AccountModel::endSessionsFailed);
+
+    // The root is configurable so the sampling can be pointed at a fake cgroup tree
+    const KConfigGroup resourcesGroup(KSharedConfig::openConfig(QStringLiteral("kcm_usermanagerrc")), "Resources");
+    m_resources = new UserResourceMonitor(this);
+    m_resources->setRootPath(resourcesGroup.readEntry("CgroupRoot", m_resources->rootPath()));
+    m_resources->setInterval(resourcesGroup.readEntry("SampleInterval", m_resources->interval()));
+    connect(m_resources, &UserResourceMonitor::usageChanged, this, &AccountModel::resourceUsageChanged);
+
+    // wtmp can be huge, it is indexed on a worker thread
+    m_lastLogin = new LastLoginIndex(this);
+    connect(m_lastLogin, &LastLoginIndex::changed, this, &AccountModel::lastLoginChanged);
+
+    m_groups = new GroupIndex(this);
+    connect(m_groups, &GroupIndex::groupsChanged, this, &AccountModel::groupsChanged);
+    m_changes->add(0, rowCount() - 1, {Groups});
+}
+
+void AccountModel::queueEmailSetting(const QString &path, KEMailSettings::Setting setting, const QString &value)
+{
+    // KEMailSettings is per user; editing somebody else's account must not touch ours
+    if (path != m_currentUserPath) {
+        return;
+    }
+
+    m_emailSettings->set(setting, value);
+}
+
+void AccountModel::serviceOwnerChanged(const QString& service, const QString& oldOwner, const QString& newOwner)
+{
+    Q_UNUSED(oldOwner)
+    if (newOwner.isEmpty()) {
+        qCWarning(USER_MANAGER_LOG) << service << "went away";
+        return;
+    }
+
+    qCDebug(USER_MANAGER_LOG) << service << "is now owned by" << newOwner;
+    resync();
+}
+
+void AccountModel::resync()
+{
+    QDBusPendingReply <QList <QDBusObjectPath > > reply = m_dbus->ListCachedUsers();
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(reply, this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this](QDBusPendingCallWatcher *watcher) {
+        watcher->deleteLater();
+
+        QDBusPendingReply <QList <QDBusObjectPath > > reply = *watcher;
+        if (checkForErrors(reply)) {
+            return;
+        }
+
+        applyUserList(reply.value());
+        StartupTrace::mark("user list revalidated");
+    });
+}
+
+void AccountModel::applyUserList(const QList<QDBusObjectPath>& users)
+{
+    QSet<QString> listed;
+    listed.reserve(users.count());
+    for (const QDBusObjectPath &user : users) {
+        listed.insert(user.path());
+    }
+
+    // Drop the accounts which are gone, one beginRemoveRows() per contiguous block.
+    // The "new-user" row has no interface and is never removed.
+    const auto isGone = [this, &listed](int row) {
+        const QString &path = m_userPath.at(row);
+        return m_users.value(path) && !listed.contains(path);
+    };
+    int last = m_userPath.count() - 1;
+    while (last >= 0) {
+        if (!isGone(last)) {
+            --last;
+            continue;
+        }
+
+        int first = last;
+        while (first > 0 && isGone(first - 1)) {
+            --first;
+        }
+
+        beginRemoveRows(QModelIndex(), first, last);
+        for (int row = last; row >= first; --row) {
+            removeAccount(m_userPath.at(row));
+        }
+        endRemoveRows();
+        last = first - 1;
+    }
+
+    // Known accounts are refetched in the background, detailsReady() only
+    // emits dataChanged for the ones which really changed
+    QList<QPair<QString, Account*>> added;
+    for (const QDBusObjectPath &user : users) {
+        const QString path = user.path();
+        if (m_users.contains(path)) {
+            m_scheduler->request(path);
+            continue;
+        }
+
+        Account *acc = createAccount(path);
+        if (acc) {
+            added.append(qMakePair(path, acc));
+        }
+    }
+
+    const bool hasNewUser = m_users.contains(QStringLiteral("new-user"));
+    if (!added.isEmpty()) {
+        const int first = hasNewUser ? rowCount() - 1 : rowCount();
+        beginInsertRows(QModelIndex(), first, first + added.count() - 1);
+        for (int i = 0; i < added.count(); ++i) {
+            addAccountToCache(added.at(i).first, added.at(i).second, first + i);
+        }
+        endInsertRows();
+    }
+
+    if (!hasNewUser) {
+        const int row = rowCount();
+        beginInsertRows(QModelIndex(), row, row);
+        addAccountToCache(QStringLiteral("new-user"), nullptr);
+        endInsertRows();
+    }
+}
+
+void AccountModel::setCallTimeout(int msec)
+{
+    m_callTimeout = msec;
+    m_probeTimer->setInterval(2 * msec);
+    m_scheduler->setTimeout(msec);
+    m_dbus->setTimeout(msec);
+    for (Account *acc : qAsConst(m_users)) {
+        if (acc) {
+            acc->setTimeout(msec);
+        }
+    }
+}
+
+int AccountModel::callTimeout() const
+{
+    return m_callTimeout;
+}
+
+bool AccountModel::isDegraded() const
+{
+    return m_degraded;
+}
+
+QVariant AccountModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    Q_UNUSED(section);
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    if (orientation == Qt::Vertical) {
+        return QVariant();
+    }
+
+    return i18n("Users");
+}
+
+void AccountModel::UserAdded(const QDBusObjectPath& dbusPath)
+{
+    QString path = dbusPath.path();
+    if (m_pathRows.contains(path)) {
+        qCDebug(USER_MANAGER_LOG) << "We already have:" << path;
+        return;
+    }
+
+    Account* acc = createAccount(path);
+    if (!acc) {
+        return;
+    }
+
+    // First, we modify "new-user" to become the new created user
+    int row = rowCount();
     replaceAccount(path, acc, row - 1);
-    QModelIndex changedIndex = index(row - 1, 0);
-    emit dataChanged(changedIndex, changedIndex);
+    m_changes->add(row - 1);
 
     // Then we add new-user again.
     beginInsertRows(QModelIndex(), row, row);
@@ -450,12 +1332,13 @@ void AccountModel::UserAdded(const QDBusObjectPath& dbusPath)
 
 void AccountModel::UserDeleted(const QDBusObjectPath& path)
 {
-    if (!m_userPath.contains(path.path())) {
+    if (!m_pathRows.contains(path.path())) {
         qCDebug(USER_MANAGER_LOG) << "User Deleted but not found: " << path.path();
         return;
     }
 
-    beginRemoveRows(QModelIndex(), m_userPath.indexOf(path.path()), m_userPath.indexOf(path.path()));
+    const int row = rowOf(path.path());
+    beginRemoveRows(QModelIndex(), row, row);
     removeAccount(path.path());
     endRemoveRows();
 }
@@ -463,30 +1346,274 @@ void AccountModel::UserDeleted(const QDBusObjectPath& path)
 void AccountModel::Changed()
 {
     Account* acc = qobject_cast<Account*>(sender());
-    acc->path();
 
-    QModelIndex accountIndex = index(m_userPath.indexOf(acc->path()), 0);
-    Q_EMIT dataChanged(accountIndex, accountIndex);
+    // The old details stay around until the new ones arrive, dataChanged is emitted then.
+    // accountsservice keeps the icon under the same name, so its content may have changed.
+    m_faces.remove(acc->path());
+    invalidateRow(rowOf(acc->path()));
+    m_scheduler->request(acc->path());
 }
 
-void AccountModel::userLogged(uint uid, bool logged)
+void AccountModel::sessionsChanged(const QList<uint> &uids)
 {
-    QString path = accountPathForUid(uid);
-    int row = m_userPath.indexOf(path);
+    for (uint uid : uids) {
+        const int row = rowOf(accountPathForUid(uid));
+        // Not known yet, the details will bring the right state along
+        if (row >= 0) {
+            m_changes->add(row, {Logged, SessionCount, SessionState, Qt::ToolTipRole});
+        }
+    }
 
-    setData(index(row), logged, Logged);
+    updateMonitoredUsers();
 }
 
-const QString AccountModel::accountPathForUid(uint uid) const
+void AccountModel::resourceUsageChanged(const QList<uint> &uids)
 {
-    QHash<QString, Account*>::ConstIterator i;
-    for (i = m_users.constBegin(); i != m_users.constEnd(); ++i) {
-        if (i.value() && i.value()->uid() == uid) {
-            return i.key();
+    for (uint uid : uids) {
+        const int row = rowOf(accountPathForUid(uid));
+        if (row >= 0) {
+            m_changes->add(row, {CpuUsage, MemoryUsage, Qt::ToolTipRole});
         }
     }
+}
+
+void AccountModel::sessionsEnded(uint uid)
+{
+    const auto removal = m_removeAfterLogout.constFind(uid);
+    if (removal == m_removeAfterLogout.constEnd()) {
+        return;
+    }
+
+    const bool deleteFiles = removal.value();
+    m_removeAfterLogout.erase(removal);
 
-    return QString();
+    const int row = rowOf(accountPathForUid(uid));
+    if (row >= 0) {
+        removeAccountKeepingFiles(row, deleteFiles);
+    }
+}
+
+void AccountModel::endSessionsFailed(uint uid, const QString &message)
+{
+    m_removeAfterLogout.remove(uid);
+    Q_EMIT callFailed(message);
+}
+
+void AccountModel::homeUsageReady(uint uid, qint64 bytes)
+{
+    Q_UNUSED(bytes)
+    const int row = rowOf(accountPathForUid(uid));
+    if (row >= 0) {
+        m_changes->add(row, {HomeUsage, Qt::ToolTipRole});
+    }
+}
+
+void AccountModel::lastLoginChanged()
+{
+    // Logins are recorded by user name, matching them to rows costs more than refreshing them all
+    m_changes->add(0, rowCount() - 1, {LastLogin, Qt::ToolTipRole});
+}
+
+void AccountModel::groupsChanged(const QStringList &usernames)
+{
+    const QSet<QString> changed(usernames.constBegin(), usernames.constEnd());
+    for (int row = 0; row < m_userPath.count(); ++row) {
+        if (changed.contains(detail(m_userPath.at(row), QStringLiteral("UserName")).toString())) {
+            m_changes->add(row, {Groups});
+        }
+    }
+}
+
+void AccountModel::updateMonitoredUsers()
+{
+    // Sampling and scanning is only worth it for the visible rows
+    QList<uint> logged;
+    QHash<uint, QString> homes;
+    for (int row : qAsConst(m_visibleRows)) {
+        // Rows may have gone since the view last said what it shows
+        if (row >= m_userPath.count()) {
+            break;
+        }
+        const QString path = m_userPath.at(row);
+        const QVariant uid = detail(path, QStringLiteral("Uid"));
+        if (!uid.isValid()) {
+            continue;
+        }
+
+        homes.insert(uid.toUInt(), detail(path, QStringLiteral("HomeDirectory")).toString());
+        // Only logged in users have a slice
+        if (m_sessions && m_sessions->isLogged(uid.toUInt())) {
+            logged.append(uid.toUInt());
+        }
+    }
+
+    m_homeUsage->setWanted(homes);
+    if (m_resources) {
+        m_resources->setWatched(logged);
+    }
+}
+
+void AccountModel::detailsReady(const QString& path, const QVariantMap& properties)
+{
+    const int row = rowOf(path);
+    if (row < 0) {
+        return;
+    }
+
+    m_detailRetries.remove(path);
+    if (properties.value(QStringLiteral("SystemAccount")).toBool()) {
+        beginRemoveRows(QModelIndex(), row, row);
+        removeAccount(path);
+        endRemoveRows();
+        return;
+    }
+
+    setDegraded(false);
+
+    const uint uid = properties.value(QStringLiteral("Uid")).toUInt();
+    auto details = m_details.find(path);
+    bool changed = details == m_details.end();
+    for (const char *key : s_shownDetails) {
+        if (changed) {
+            break;
+        }
+        changed = details.value().value(QLatin1String(key)) != properties.value(QLatin1String(key));
+    }
+    if (details == m_details.end()) {
+        m_details.insert(path, properties);
+    } else {
+        details.value() = properties;
+    }
+    m_uidPaths.insert(uid, path);
+
+    // Refreshes after Changed() or a resync mostly bring back what we already have
+    if (!changed) {
+        return;
+    }
+
+    m_faces.remove(path);
+    invalidateRow(row);
+
+    m_changes->add(row);
+
+    if (std::binary_search(m_visibleRows.cbegin(), m_visibleRows.cend(), row)) {
+        updateMonitoredUsers();
+    }
+}
+
+void AccountModel::requestDetails(const QModelIndex& index)
+{
+    if (!index.isValid() || index.row() >= m_userPath.count()) {
+        return;
+    }
+
+    const QString path = m_userPath.at(index.row());
+    if (!m_users.value(path)) {
+        return;
+    }
+
+    m_scheduler->setSelected(path);
+}
+
+void AccountModel::setVisibleRows(int first, int last)
+{
+    const int count = m_userPath.count();
+    first = qMax(0, first);
+    last = qMin(last, count - 1);
+
+    QVector<int> visible;
+    for (int row = first; row <= last; ++row) {
+        visible.append(row);
+    }
+
+    // Prefetch one more screen worth of rows below the visible ones
+    QVector<int> lookahead;
+    const int window = last - first + 1;
+    for (int row = last + 1; row <= last + window && row < count; ++row) {
+        lookahead.append(row);
+    }
+
+    setVisibleRows(visible, lookahead);
+}
+
+void AccountModel::setVisibleRows(const QVector<int> &visible, const QVector<int> &lookahead)
+{
+    const int count = m_userPath.count();
+    m_visibleRows.clear();
+    QStringList visiblePaths;
+    for (int row : visible) {
+        if (row >= 0 && row < count) {
+            m_visibleRows.append(row);
+            visiblePaths.append(m_userPath.at(row));
+        }
+    }
+    std::sort(m_visibleRows.begin(), m_visibleRows.end());
+    updateMonitoredUsers();
+
+    QStringList lookaheadPaths;
+    for (int row : lookahead) {
+        if (row >= 0 && row < count) {
+            lookaheadPaths.append(m_userPath.at(row));
+        }
+    }
+
+    m_scheduler->setVisible(visiblePaths, lookaheadPaths);
+}
+
+QVariant AccountModel::detail(const QString& path, const QString& key) const
+{
+    const auto it = m_details.constFind(path);
+    if (it == m_details.constEnd()) {
+        return QVariant();
+    }
+
+    return it.value().value(key);
+}
+
+void AccountModel::setDetail(const QString& path, const QString& key, const QVariant& value)
+{
+    const auto it = m_details.find(path);
+    if (it != m_details.end()) {
+        it.value().insert(key, value);
+        invalidateRow(rowOf(path));
+    }
+}
+
+const AccountRow& AccountModel::accountRow(int row) const
+{
+    AccountRow &accountRow = m_rows[row];
+    if (accountRow.ready || !accountRow.account) {
+        return accountRow;
+    }
+
+    const QString &path = m_userPath.at(row);
+    const auto details = m_details.constFind(path);
+    if (details == m_details.constEnd()) {
+        // Skeleton row until the scheduler gets to it
+        accountRow.display = i18nc("@item:inlistbox placeholder for an account which is still being loaded", "Loading…");
+    } else {
+        const QString realName = details->value(QStringLiteral("RealName")).toString();
+        accountRow.username = details->value(QStringLiteral("UserName"));
+        accountRow.display = realName.isEmpty() ? accountRow.username : realName;
+        const auto uid = details->constFind(QStringLiteral("Uid"));
+        accountRow.hasUid = uid != details->constEnd();
+        accountRow.uid = accountRow.hasUid ? uid->toUInt() : 0;
+    }
+    accountRow.face = face(path);
+    accountRow.ready = true;
+    return accountRow;
+}
+
+void AccountModel::invalidateRow(int row)
+{
+    if (row >= 0 && row < m_rows.count()) {
+        m_rows[row].ready = false;
+    }
+}
+
+const QString AccountModel::accountPathForUid(uint uid) const
+{
+    return m_uidPaths.value(uid);
 }
 
 QString AccountModel::cryptPassword(const QString& password) const
@@ -536,12 +1663,188 @@ QDebug operator<<(QDebug debug, AccountModel::Role role)
         case AccountModel::Created:
             debug << "AccountModel::Created";
             break;
+        case AccountModel::SessionCount:
+            debug << "AccountModel::SessionCount";
+            break;
+        case AccountModel::SessionState:
+            debug << "AccountModel::SessionState";
+            break;
+        case AccountModel::CpuUsage:
+            debug << "AccountModel::CpuUsage";
+            break;
+        case AccountModel::MemoryUsage:
+            debug << "AccountModel::MemoryUsage";
+            break;
+        case AccountModel::HomeUsage:
+            debug << "AccountModel::HomeUsage";
+            break;
+        case AccountModel::LastLogin:
+            debug << "AccountModel::LastLogin";
+            break;
+        case AccountModel::Groups:
+            debug << "AccountModel::Groups";
+            break;
+        case AccountModel::PasswordLocked:
+            debug << "AccountModel::PasswordLocked";
+            break;
+        case AccountModel::PasswordChanged:
+            debug << "AccountModel::PasswordChanged";
+            break;
+        case AccountModel::PasswordExpires:
+            debug << "AccountModel::PasswordExpires";
+            break;
     }
     return debug;
 }
 
 void AccountModel::setDpr(qreal dpr) {
     m_dpr = dpr;
+    m_faces.clear();
+    for (int row = 0; row < m_rows.count(); ++row) {
+        invalidateRow(row);
+    }
+}
+
+QPixmap AccountModel::face(const QString& path) const
+{
+    const auto cached = m_faces.constFind(path);
+    if (cached != m_faces.constEnd()) {
+        return cached.value();
+    }
+
+    QPixmap pixMap = snapshotFace(path);
+    if (pixMap.isNull()) {
+        QFile file(detail(path, QStringLiteral("IconFile")).toString());
+        int size = QApplication::style()->pixelMetric(QStyle::PM_LargeIconSize);
+        if (!file.exists()) {
+            pixMap = QIcon::fromTheme(QStringLiteral("user-identity")).pixmap(size, size);
+        } else {
+            // Faces already seen by anything using the thumbnail cache need not be decoded
+            const int pixelSize = static_cast<int>(size * m_dpr);
+            QImage image = ThumbnailCache::find(file.fileName(), pixelSize);
+            if (image.isNull()) {
+                image = QImage(file.fileName());
+                ThumbnailCache::store(file.fileName(), image, pixelSize);
+            }
+            pixMap = QPixmap::fromImage(AreaScaler::scaledToFit(image, pixelSize));
+            pixMap.setDevicePixelRatio(m_dpr);
+        }
+    }
+
+    m_faces.insert(path, pixMap);
+    return pixMap;
+}
+
+QPixmap AccountModel::snapshotFace(const QString& path) const
+{
+    const int row = m_snapshotRows.value(path, -1);
+    if (!m_snapshot || row < 0) {
+        return QPixmap();
+    }
+
+    // Only usable if it was rendered at the same size from the same, unchanged file
+    const int size = static_cast<int>(QApplication::style()->pixelMetric(QStyle::PM_LargeIconSize) * m_dpr);
+    const QImage image = m_snapshot->face(row);
+    if (image.isNull() || qMax(image.width(), image.height()) != size) {
+        return QPixmap();
+    }
+
+    const QString iconFile = detail(path, QStringLiteral("IconFile")).toString();
+    if (m_snapshot->details(row).value(QStringLiteral("IconFile")).toString() != iconFile
+        || QFileInfo(iconFile).lastModified().toMSecsSinceEpoch() != m_snapshot->iconMTime(row)) {
+        return QPixmap();
+    }
+
+    QPixmap pixMap = QPixmap::fromImage(image);
+    pixMap.setDevicePixelRatio(m_dpr);
+    return pixMap;
+}
+
+bool AccountModel::loadSnapshot()
+{
+    m_snapshot.reset(new AccountSnapshot(AccountSnapshot::defaultFileName()));
+    if (!m_snapshot->load()) {
+        m_snapshot.reset();
+        return false;
+    }
+
+    for (int row = 0; row < m_snapshot->count(); ++row) {
+        const QString path = m_snapshot->path(row);
+        if (path.isEmpty() || m_users.contains(path)) {
+            continue;
+        }
+
+        // No validation round-trip here, the revalidation drops what is gone
+        Account *acc = new Account(QStringLiteral("org.freedesktop.Accounts"), path, QDBusConnection::systemBus(), this);
+        acc->setTimeout(m_callTimeout);
+        connect(acc, &OrgFreedesktopAccountsUserInterface::Changed, this, &AccountModel::Changed);
+
+        const QVariantMap details = m_snapshot->details(row);
+        const uint uid = details.value(QStringLiteral("Uid")).toUInt();
+        m_details.insert(path, details);
+        m_uidPaths.insert(uid, path);
+        m_snapshotRows.insert(path, row);
+        if (uid == getuid()) {
+            m_currentUserPath = path;
+        }
+
+        addAccountToCache(path, acc);
+    }
+
+    // Adding fake "new user" directly into cache
+    addAccountToCache(QStringLiteral("new-user"), nullptr);
+
+    qCDebug(USER_MANAGER_LOG) << "Loaded" << m_snapshotRows.count() << "accounts from the snapshot";
+    m_loadedFromSnapshot = true;
+    return true;
+}
+
+void AccountModel::saveSnapshot() const
+{
+    QVector<AccountSnapshot::Record> records;
+    records.reserve(m_userPath.count());
+
+    for (const QString &path : m_userPath) {
+        const auto details = m_details.constFind(path);
+        if (!m_users.value(path) || details == m_details.constEnd()) {
+            continue;
+        }
+
+        AccountSnapshot::Record record;
+        record.path = path;
+        record.details = details.value();
+
+        const QFileInfo iconFile(details.value().value(QStringLiteral("IconFile")).toString());
+        if (iconFile.exists()) {
+            record.iconMTime = iconFile.lastModified().toMSecsSinceEpoch();
+
+            // Faces which were not shown this time are carried over from the old snapshot
+            const auto face = m_faces.constFind(path);
+            record.face = face != m_faces.constEnd() ? face.value().toImage() : snapshotFace(path).toImage();
+        }
+
+        records.append(record);
+    }
+
+    AccountSnapshot::save(AccountSnapshot::defaultFileName(), records);
+}
+
+bool AccountModel::loadedFromSnapshot() const
+{
+    return m_loadedFromSnapshot;
+}
+
+quint64 AccountModel::dataChangedEmitted() const
+{
+    return m_changes->emittedCount();
+}
+
+quint64 AccountModel::dataChangedCoalesced() const
+{
+    // Ranges split by inserted or moved rows can make more signals than requests
+    const quint64 requested = m_changes->requestedCount();
+    const quint64 emitted = m_changes->emittedCount();
+    return requested > emitted ? requested - emitted : 0;
 }
 
 
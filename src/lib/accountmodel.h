@@ -23,21 +23,103 @@
 #include "user_manager_debug.h"
 #include <QStringList>
 #include <QAbstractListModel>
+#include <QDateTime>
 #include <QDBusObjectPath>
 #include <QDBusPendingReply>
+#include <QPixmap>
+#include <QScopedPointer>
+#include <QVector>
 #include <KEMailSettings>
 
+class QTimer;
+class QFileSystemWatcher;
+template<typename T> class QFutureWatcher;
+class QDBusPendingCallWatcher;
+class QDBusServiceWatcher;
 class UserSession;
+class UserResourceMonitor;
+class HomeUsageScanner;
+class LastLoginIndex;
+class GroupIndex;
+class KJob;
+class AccountSnapshot;
+class AccountRequestScheduler;
+class DataChangeCoalescer;
+class EmailSettingsWriter;
 class OrgFreedesktopAccountsInterface;
 class OrgFreedesktopAccountsUserInterface;
 
-class AutomaticLoginSettings {
-public:
-    AutomaticLoginSettings();
-    QString autoLoginUser() const;
-    bool setAutoLoginUser(const QString &username);
-private:
-    QString m_autoLoginUser;
+/**
+ * The user SDDM logs in automatically. Its configuration is merged the way SDDM
+ * does it: /usr/lib/sddm/sddm.conf.d, then /etc/sddm.conf.d, each in file name
+ * order, and /etc/sddm.conf last, later files overriding earlier ones.
+ *
+ * The files are watched. When one changes, only the files whose size or mtime
+ * changed are parsed again, on a worker thread.
+ */
+class AutomaticLoginSettings : public QObject
+{
+    Q_OBJECT
+    public:
+        struct ConfigFile {
+            QString path;
+            QDateTime modified;
+            qint64 size = -1;
+            bool hasUser = false;
+            QString user;
+        };
+        typedef QList<ConfigFile> ConfigFiles;
+
+        explicit AutomaticLoginSettings(QObject* parent = nullptr);
+        ~AutomaticLoginSettings() override;
+
+        QString autoLoginUser() const;
+        bool isLoaded() const;
+
+        /**
+         * Saves through the SDDM module's helper. The new value applies right away
+         * and is reverted should saving fail.
+         */
+        void setAutoLoginUser(const QString &username);
+
+    Q_SIGNALS:
+        void loaded();
+        void saveFailed(const QString &message);
+        void autoLoginUserChanged(const QString &previous, const QString &username);
+
+    private Q_SLOTS:
+        void reload();
+        void readFinished();
+        void saveFinished(KJob *job);
+
+    private:
+        void setUser(const QString &username);
+
+        QFileSystemWatcher* m_watcher;
+        QTimer* m_reloadTimer;
+        QFutureWatcher<ConfigFiles>* m_readWatcher;
+        ConfigFiles m_files;
+        QString m_autoLoginUser;
+        QString m_savedAutoLoginUser;
+        int m_pendingSaves = 0;
+        bool m_loaded = false;
+        bool m_reloadAgain = false;
+};
+
+/**
+ * What AccountModel::data() returns for the common roles of one row, built on
+ * first use and dropped when the account changes. Handing out copies of these
+ * only touches reference counts.
+ */
+struct AccountRow
+{
+    OrgFreedesktopAccountsUserInterface* account = nullptr;
+    QVariant display;
+    QVariant face;
+    QVariant username;
+    uint uid = 0;
+    bool hasUid = false;
+    bool ready = false;
 };
 
 class AccountModel : public QAbstractListModel
@@ -54,7 +136,17 @@ class AccountModel : public QAbstractListModel
             Administrator,
             AutomaticLogin,
             Logged,
-            Created
+            Created,
+            SessionCount,
+            SessionState,
+            CpuUsage,
+            MemoryUsage,
+            HomeUsage,
+            LastLogin,
+            Groups,
+            PasswordLocked,
+            PasswordChanged,
+            PasswordExpires
         };
 
         explicit AccountModel(QObject* parent);
@@ -65,33 +157,157 @@ class AccountModel : public QAbstractListModel
         bool setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole) override;
         bool removeRows(int row, int count, const QModelIndex& parent = QModelIndex()) override;
         bool removeAccountKeepingFiles(int row, bool keepFile = false);
+
+        /**
+         * Removes several accounts at once. With @p endSessionsFirst the logged in
+         * ones are logged out first and each is deleted as soon as logind dropped it.
+         */
+        bool removeAccounts(const QModelIndexList &indexes, bool deleteFiles, bool endSessionsFirst);
+
+        /**
+         * Logs out the users of @p indexes, except the one running this module.
+         */
+        void endSessions(const QModelIndexList &indexes, bool force = false);
+
+        /**
+         * Reads the password aging and lock state of every known user through a
+         * single call to the KAuth helper. This asks for authorisation, so it is
+         * only done when the user wants to see them.
+         */
+        void fetchPrivilegedDetails();
         void setDpr(qreal dpr);
 
+        /**
+         * Every group a user can be added to, and the one the user of @p index
+         * belongs to through its passwd entry. Setting Groups never changes the latter.
+         */
+        QStringList availableGroups() const;
+        QString primaryGroup(const QModelIndex &index) const;
+
+        /**
+         * Tells the model which rows the user is looking at, so their details are
+         * fetched from accountsservice before the rest.
+         */
+        void requestDetails(const QModelIndex &index);
+        void setVisibleRows(int first, int last);
+        /* For views sorting the rows, see AccountSortModel */
+        void setVisibleRows(const QVector<int> &visible, const QVector<int> &lookahead);
+
+        /**
+         * Every call to accountsservice gives up after @p msec. Once a call misses
+         * its deadline the model turns read-only and keeps showing what it has
+         * cached until the service answers again.
+         */
+        void setCallTimeout(int msec);
+        int callTimeout() const;
+        bool isDegraded() const;
+        void cancelPendingCalls();
+
+        /**
+         * Whether the rows shown at startup came from the on-disk snapshot
+         * rather than from accountsservice.
+         */
+        bool loadedFromSnapshot() const;
+
+        /**
+         * Row changes are reported once per frame, merged into contiguous ranges.
+         * These tell how many dataChanged went out and how many were saved.
+         */
+        quint64 dataChangedEmitted() const;
+        quint64 dataChangedCoalesced() const;
+
         QVariant newUserData(int role) const;
         bool newUserSetData(const QModelIndex& index, const QVariant& value, int roleInt);
 
+    Q_SIGNALS:
+        void callFailed(const QString &message);
+        void degradedChanged(bool degraded);
+
     public Q_SLOTS:
         void UserAdded(const QDBusObjectPath &dbusPah);
         void UserDeleted(const QDBusObjectPath &path);
         void Changed();
-        void userLogged(uint uid, bool logged);
+
+    private Q_SLOTS:
+        void detailsReady(const QString &path, const QVariantMap &properties);
+        void detailsFailed(const QString &path, const QDBusError &error);
+        void callFinished(QDBusPendingCallWatcher *watcher);
+        void userCreated(QDBusPendingCallWatcher *watcher);
+        void probeService();
+        void currentUserFound(QDBusPendingCallWatcher *watcher);
+        void createUserSession();
+        void sessionsChanged(const QList<uint> &uids);
+        void resourceUsageChanged(const QList<uint> &uids);
+        void homeUsageReady(uint uid, qint64 bytes);
+        void lastLoginChanged();
+        void groupsChanged(const QStringList &usernames);
+        void privilegedDetailsReceived(KJob *job);
+        void groupsSaved(KJob *job);
+        void autoLoginUserChanged(const QString &previous, const QString &username);
+        void sessionsEnded(uint uid);
+        void endSessionsFailed(uint uid, const QString &message);
+        void serviceOwnerChanged(const QString &service, const QString &oldOwner, const QString &newOwner);
 
     private:
         const QString accountPathForUid(uint uid) const;
-        void addAccount(const QString &path);
+        OrgFreedesktopAccountsUserInterface* createAccount(const QString &path);
         void addAccountToCache(const QString &path, OrgFreedesktopAccountsUserInterface *acc, int pos = -1);
+        int rowOf(const QString &path) const;
+        /* Renumbers rows @p first to @p last, -1 being the last row, after m_userPath changed */
+        void updatePathRows(int first, int last = -1);
         void replaceAccount(const QString &path, OrgFreedesktopAccountsUserInterface *acc, int pos);
         void removeAccount(const QString &path);
-        bool checkForErrors(QDBusPendingReply <void> reply) const;
+        void resync();
+        void applyUserList(const QList<QDBusObjectPath> &users);
+        void updateMonitoredUsers();
+        void callAsync(const QString &path, const QDBusPendingCall &call);
+        bool checkForErrors(const QDBusPendingCall &call);
+        void setDegraded(bool degraded);
         QString cryptPassword(const QString &password) const;
-        UserSession* m_sessions;
+        void queueEmailSetting(const QString &path, KEMailSettings::Setting setting, const QString &value);
+        QVariant detail(const QString &path, const QString &key) const;
+        QPixmap face(const QString &path) const;
+        const AccountRow& accountRow(int row) const;
+        void invalidateRow(int row);
+        QPixmap snapshotFace(const QString &path) const;
+        bool loadSnapshot();
+        void saveSnapshot() const;
+        void setDetail(const QString &path, const QString &key, const QVariant &value);
+        UserSession* m_sessions = nullptr;
+        UserResourceMonitor* m_resources = nullptr;
+        LastLoginIndex* m_lastLogin = nullptr;
+        GroupIndex* m_groups = nullptr;
+        QHash<uint, QVariantMap> m_privileged;
+        bool m_fetchingPrivileged = false;
+        QVector<int> m_visibleRows;
+        QHash<uint, bool> m_removeAfterLogout;
+        AccountRequestScheduler* m_scheduler;
+        DataChangeCoalescer* m_changes;
+        HomeUsageScanner* m_homeUsage;
         QStringList m_userPath;
+        /* Row of each path of m_userPath, so lookups by uid or path do not scan the list */
+        QHash<QString, int> m_pathRows;
+        /* Parallel to m_userPath, what data() answers for the roles every paint asks for */
+        mutable QVector<AccountRow> m_rows;
+        QString m_currentUserPath;
         OrgFreedesktopAccountsInterface* m_dbus;
         QHash<AccountModel::Role, QVariant> m_newUserData;
+        QHash<QDBusPendingCallWatcher*, QString> m_pendingCalls;
+        QTimer* m_probeTimer;
+        QDBusServiceWatcher* m_serviceWatcher;
+        int m_callTimeout;
+        bool m_degraded = false;
+        bool m_creatingUser = false;
         QHash<QString, OrgFreedesktopAccountsUserInterface*> m_users;
-        QHash<QString, bool> m_loggedAccounts;
-        KEMailSettings m_kEmailSettings;
-        AutomaticLoginSettings m_autoLoginSettings;
+        QHash<QString, QVariantMap> m_details;
+        QHash<QString, int> m_detailRetries;
+        mutable QHash<QString, QPixmap> m_faces;
+        QScopedPointer<AccountSnapshot> m_snapshot;
+        QHash<QString, int> m_snapshotRows;
+        bool m_loadedFromSnapshot = false;
+        QHash<uint, QString> m_uidPaths;
+        EmailSettingsWriter* m_emailSettings;
+        AutomaticLoginSettings* m_autoLoginSettings;
         qreal m_dpr = 1;
 };
 
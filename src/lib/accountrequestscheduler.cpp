@@ -0,0 +1,230 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "accountrequestscheduler.h"
+#include "user_manager_debug.h"
+
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+
+AccountRequestScheduler::AccountRequestScheduler(const QDBusConnection &connection, QObject* parent)
+ : QObject(parent)
+ , m_connection(connection)
+{
+}
+
+AccountRequestScheduler::~AccountRequestScheduler()
+{
+}
+
+void AccountRequestScheduler::setMaxInFlight(int count)
+{
+    m_maxInFlight = qMax(1, count);
+    schedule();
+}
+
+int AccountRequestScheduler::maxInFlight() const
+{
+    return m_maxInFlight;
+}
+
+void AccountRequestScheduler::setTimeout(int msec)
+{
+    m_timeout = msec;
+}
+
+void AccountRequestScheduler::abort()
+{
+    const QHash<QDBusPendingCallWatcher*, QString> inFlight = m_inFlight;
+    m_inFlight.clear();
+    m_backgroundCalls.clear();
+
+    for (auto it = inFlight.constBegin(); it != inFlight.constEnd(); ++it) {
+        delete it.key();
+
+        const QString &path = it.value();
+        if (m_pending.contains(path)) {
+            continue;
+        }
+        if (path == m_selected) {
+            enqueue(path, Selected);
+        } else {
+            enqueue(path, m_visible.contains(path) ? Visible : Background);
+        }
+    }
+}
+
+void AccountRequestScheduler::request(const QString& path, Priority priority)
+{
+    if (path == m_selected) {
+        priority = Selected;
+    } else if (priority > Visible && m_visible.contains(path)) {
+        priority = Visible;
+    }
+
+    enqueue(path, priority);
+    schedule();
+}
+
+void AccountRequestScheduler::cancel(const QString& path)
+{
+    // Queued entries are dropped lazily when their tier is drained
+    m_pending.remove(path);
+}
+
+bool AccountRequestScheduler::isPending(const QString& path) const
+{
+    return m_pending.contains(path);
+}
+
+void AccountRequestScheduler::setSelected(const QString& path)
+{
+    if (m_selected == path) {
+        return;
+    }
+
+    const QString previous = m_selected;
+    m_selected = path;
+
+    if (!previous.isEmpty()) {
+        demote(previous);
+    }
+    if (m_pending.contains(path)) {
+        enqueue(path, Selected);
+    }
+
+    schedule();
+}
+
+void AccountRequestScheduler::setVisible(const QStringList& visible, const QStringList& lookahead)
+{
+    const QSet<QString> previous = m_visible;
+    m_visible.clear();
+    m_visible.reserve(visible.size() + lookahead.size());
+
+    // Rows which scrolled out of view give up their place in the queue
+    for (const QString &path : previous) {
+        if (!visible.contains(path) && !lookahead.contains(path)) {
+            demote(path);
+        }
+    }
+
+    for (const QString &path : visible) {
+        m_visible.insert(path);
+        if (m_pending.contains(path) && m_pending.value(path) > Visible) {
+            enqueue(path, Visible);
+        }
+    }
+
+    for (const QString &path : lookahead) {
+        m_visible.insert(path);
+        if (m_pending.contains(path) && m_pending.value(path) > Lookahead) {
+            enqueue(path, Lookahead);
+        }
+    }
+
+    schedule();
+}
+
+void AccountRequestScheduler::enqueue(const QString& path, Priority priority)
+{
+    const auto it = m_pending.constFind(path);
+    if (it != m_pending.constEnd() && it.value() == priority) {
+        return;
+    }
+
+    // The stale entry left in the old tier is skipped when that tier is drained
+    m_pending.insert(path, priority);
+    if (priority == Selected) {
+        m_queues[priority].prepend(path);
+    } else {
+        m_queues[priority].append(path);
+    }
+}
+
+void AccountRequestScheduler::demote(const QString& path)
+{
+    if (path == m_selected) {
+        return;
+    }
+
+    const auto it = m_pending.constFind(path);
+    if (it != m_pending.constEnd() && it.value() != Background) {
+        enqueue(path, Background);
+    }
+}
+
+void AccountRequestScheduler::schedule()
+{
+    // Background requests may only take half of the slots so that a row
+    // scrolling into view can always be served straight away.
+    const int backgroundLimit = qMax(1, m_maxInFlight / 2);
+
+    for (int tier = Selected; tier <= Background; ++tier) {
+        QList<QString> &queue = m_queues[tier];
+        while (!queue.isEmpty() && m_inFlight.count() < m_maxInFlight) {
+            if (tier == Background && m_backgroundCalls.count() >= backgroundLimit) {
+                return;
+            }
+
+            const QString path = queue.takeFirst();
+            const auto it = m_pending.constFind(path);
+            if (it == m_pending.constEnd() || it.value() != tier) {
+                continue;
+            }
+
+            m_pending.erase(it);
+            QDBusPendingCallWatcher *watcher = dispatch(path);
+            if (tier == Background) {
+                m_backgroundCalls.insert(watcher);
+            }
+        }
+    }
+}
+
+QDBusPendingCallWatcher* AccountRequestScheduler::dispatch(const QString& path)
+{
+    QDBusMessage message = QDBusMessage::createMethodCall(QStringLiteral("org.freedesktop.Accounts"),
+                                                          path,
+                                                          QStringLiteral("org.freedesktop.DBus.Properties"),
+                                                          QStringLiteral("GetAll"));
+    message << QStringLiteral("org.freedesktop.Accounts.User");
+
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(m_connection.asyncCall(message, m_timeout), this);
+    m_inFlight.insert(watcher, path);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, &AccountRequestScheduler::callFinished);
+    return watcher;
+}
+
+void AccountRequestScheduler::callFinished(QDBusPendingCallWatcher* watcher)
+{
+    const QString path = m_inFlight.take(watcher);
+    m_backgroundCalls.remove(watcher);
+    watcher->deleteLater();
+
+    QDBusPendingReply<QVariantMap> reply = *watcher;
+    if (reply.isError()) {
+        qCDebug(USER_MANAGER_LOG) << "Fetching" << path << "failed:" << reply.error().message();
+        Q_EMIT detailsFailed(path, reply.error());
+    } else {
+        Q_EMIT detailsReady(path, reply.value());
+    }
+
+    schedule();
+}
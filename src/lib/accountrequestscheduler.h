@@ -0,0 +1,100 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#ifndef ACCOUNT_REQUEST_SCHEDULER_H
+#define ACCOUNT_REQUEST_SCHEDULER_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QStringList>
+#include <QVariantMap>
+#include <QDBusConnection>
+#include <QDBusError>
+
+class QDBusPendingCallWatcher;
+
+/**
+ * Fetches the properties of org.freedesktop.Accounts.User objects asynchronously,
+ * ordered by how urgently the UI needs them.
+ *
+ * The selected user goes first, then the rows visible in the view, then a lookahead
+ * window below them and finally everything else. Only a few calls are in flight at
+ * a time so that a newly visible row never queues behind hundreds of background
+ * requests on a slow (e.g. SSSD backed) accountsservice.
+ */
+class AccountRequestScheduler : public QObject
+{
+    Q_OBJECT
+    public:
+        enum Priority {
+            Selected = 0,
+            Visible,
+            Lookahead,
+            Background
+        };
+
+        explicit AccountRequestScheduler(const QDBusConnection &connection, QObject* parent = nullptr);
+        ~AccountRequestScheduler() override;
+
+        void setMaxInFlight(int count);
+        int maxInFlight() const;
+        void setTimeout(int msec);
+
+        /**
+         * Drops the replies of all calls in flight and queues their paths again.
+         */
+        void abort();
+
+        void request(const QString &path, Priority priority = Background);
+        void cancel(const QString &path);
+        bool isPending(const QString &path) const;
+
+        /**
+         * Replaces the current selected/visible/lookahead sets. Pending requests for
+         * paths that dropped out of them fall back to the background tier.
+         */
+        void setSelected(const QString &path);
+        void setVisible(const QStringList &visible, const QStringList &lookahead);
+
+    Q_SIGNALS:
+        void detailsReady(const QString &path, const QVariantMap &properties);
+        void detailsFailed(const QString &path, const QDBusError &error);
+
+    private Q_SLOTS:
+        void callFinished(QDBusPendingCallWatcher *watcher);
+
+    private:
+        void enqueue(const QString &path, Priority priority);
+        void demote(const QString &path);
+        void schedule();
+        QDBusPendingCallWatcher* dispatch(const QString &path);
+
+        QDBusConnection m_connection;
+        int m_maxInFlight = 4;
+        int m_timeout = -1;
+        QString m_selected;
+        QSet<QString> m_visible;
+        QHash<QString, Priority> m_pending;
+        QList<QString> m_queues[Background + 1];
+        QHash<QDBusPendingCallWatcher*, QString> m_inFlight;
+        QSet<QDBusPendingCallWatcher*> m_backgroundCalls;
+};
+
+#endif //ACCOUNT_REQUEST_SCHEDULER_H
@@ -0,0 +1,240 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "accountsnapshot.h"
+#include "user_manager_debug.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <string.h>
+
+// Bump whenever the layout below changes, older files are then ignored
+static const quint32 s_magic = 0x4e534d55; // "UMSN"
+static const quint32 s_version = 1;
+
+// String details, in the order they are stored after the object path
+static const char* const s_stringKeys[] = {
+    "UserName",
+    "RealName",
+    "Email",
+    "IconFile",
+    "HomeDirectory"
+};
+static const int s_stringCount = 1 + sizeof(s_stringKeys) / sizeof(s_stringKeys[0]);
+
+struct SnapshotHeader {
+    quint32 magic;
+    quint32 version;
+    quint32 count;
+    quint32 reserved;
+};
+
+struct SnapshotString {
+    quint32 offset;
+    quint32 length;
+};
+
+struct SnapshotEntry {
+    quint64 uid;
+    qint64 iconMTime;
+    qint32 accountType;
+    quint32 faceOffset;
+    quint16 faceWidth;
+    quint16 faceHeight;
+    quint32 reserved;
+    SnapshotString strings[s_stringCount];
+};
+
+AccountSnapshot::AccountSnapshot(const QString& fileName)
+ : m_file(fileName)
+{
+}
+
+AccountSnapshot::~AccountSnapshot()
+{
+    close();
+}
+
+QString AccountSnapshot::defaultFileName()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/user-manager/accounts.snapshot");
+}
+
+bool AccountSnapshot::load()
+{
+    close();
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    m_size = m_file.size();
+    if (m_size < qint64(sizeof(SnapshotHeader))) {
+        close();
+        return false;
+    }
+
+    m_data = m_file.map(0, m_size);
+    if (!m_data) {
+        close();
+        return false;
+    }
+
+    const SnapshotHeader *header = reinterpret_cast<const SnapshotHeader*>(m_data);
+    if (header->magic != s_magic || header->version != s_version
+        || qint64(sizeof(SnapshotHeader) + header->count * sizeof(SnapshotEntry)) > m_size) {
+        qCDebug(USER_MANAGER_LOG) << "Ignoring unusable snapshot" << m_file.fileName();
+        close();
+        return false;
+    }
+
+    m_count = header->count;
+    return true;
+}
+
+void AccountSnapshot::close()
+{
+    if (m_data) {
+        m_file.unmap(const_cast<uchar*>(m_data));
+        m_data = nullptr;
+    }
+    m_file.close();
+    m_size = 0;
+    m_count = 0;
+}
+
+int AccountSnapshot::count() const
+{
+    return m_count;
+}
+
+static const SnapshotEntry* entryAt(const uchar *data, int i)
+{
+    return reinterpret_cast<const SnapshotEntry*>(data + sizeof(SnapshotHeader)) + i;
+}
+
+QString AccountSnapshot::string(int i, int field) const
+{
+    const SnapshotString &string = entryAt(m_data, i)->strings[field];
+    if (qint64(string.offset) + qint64(string.length) * 2 > m_size || string.offset % 2) {
+        return QString();
+    }
+
+    return QString(reinterpret_cast<const QChar*>(m_data + string.offset), string.length);
+}
+
+QString AccountSnapshot::path(int i) const
+{
+    return string(i, 0);
+}
+
+QVariantMap AccountSnapshot::details(int i) const
+{
+    const SnapshotEntry *entry = entryAt(m_data, i);
+
+    QVariantMap details;
+    details.insert(QStringLiteral("Uid"), entry->uid);
+    details.insert(QStringLiteral("AccountType"), entry->accountType);
+    for (int field = 1; field < s_stringCount; ++field) {
+        details.insert(QLatin1String(s_stringKeys[field - 1]), string(i, field));
+    }
+
+    return details;
+}
+
+qint64 AccountSnapshot::iconMTime(int i) const
+{
+    return entryAt(m_data, i)->iconMTime;
+}
+
+QImage AccountSnapshot::face(int i) const
+{
+    const SnapshotEntry *entry = entryAt(m_data, i);
+    const qint64 bytes = qint64(entry->faceWidth) * entry->faceHeight * 4;
+    if (!entry->faceOffset || entry->faceOffset % 4 || entry->faceOffset + bytes > m_size) {
+        return QImage();
+    }
+
+    return QImage(m_data + entry->faceOffset, entry->faceWidth, entry->faceHeight,
+                  entry->faceWidth * 4, QImage::Format_ARGB32_Premultiplied);
+}
+
+bool AccountSnapshot::save(const QString& fileName, const QVector<Record>& records)
+{
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+
+    SnapshotHeader header = {s_magic, s_version, quint32(records.count()), 0};
+    QVector<SnapshotEntry> entries(records.count());
+    QByteArray strings;
+    QByteArray faces;
+
+    const quint32 stringsOffset = sizeof(SnapshotHeader) + records.count() * sizeof(SnapshotEntry);
+    const auto appendString = [&strings, stringsOffset](const QString &value) {
+        const SnapshotString string = {quint32(stringsOffset + strings.size()), quint32(value.size())};
+        strings.append(reinterpret_cast<const char*>(value.utf16()), value.size() * 2);
+        return string;
+    };
+
+    for (int i = 0; i < records.count(); ++i) {
+        const Record &record = records.at(i);
+        SnapshotEntry &entry = entries[i];
+        memset(&entry, 0, sizeof(SnapshotEntry));
+
+        entry.uid = record.details.value(QStringLiteral("Uid")).toULongLong();
+        entry.accountType = record.details.value(QStringLiteral("AccountType")).toInt();
+        entry.iconMTime = record.iconMTime;
+        entry.strings[0] = appendString(record.path);
+        for (int field = 1; field < s_stringCount; ++field) {
+            entry.strings[field] = appendString(record.details.value(QLatin1String(s_stringKeys[field - 1])).toString());
+        }
+    }
+
+    // Faces go last, 4 byte aligned so they can be used from the mapping as they are
+    const quint32 facesOffset = (stringsOffset + strings.size() + 3) & ~3u;
+    strings.append(QByteArray(facesOffset - stringsOffset - strings.size(), '\0'));
+
+    for (int i = 0; i < records.count(); ++i) {
+        const QImage face = records.at(i).face.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        if (face.isNull() || face.width() > 0xffff || face.height() > 0xffff) {
+            continue;
+        }
+
+        SnapshotEntry &entry = entries[i];
+        entry.faceOffset = facesOffset + faces.size();
+        entry.faceWidth = face.width();
+        entry.faceHeight = face.height();
+        for (int y = 0; y < face.height(); ++y) {
+            faces.append(reinterpret_cast<const char*>(face.constScanLine(y)), face.width() * 4);
+        }
+    }
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCDebug(USER_MANAGER_LOG) << "Could not write snapshot" << fileName << file.errorString();
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.constData()), entries.count() * sizeof(SnapshotEntry));
+    file.write(strings);
+    file.write(faces);
+
+    return file.commit();
+}
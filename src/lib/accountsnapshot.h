@@ -0,0 +1,73 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#ifndef ACCOUNT_SNAPSHOT_H
+#define ACCOUNT_SNAPSHOT_H
+
+#include <QFile>
+#include <QImage>
+#include <QVariantMap>
+#include <QVector>
+
+/**
+ * Compact on-disk copy of the account list, used to show something right away
+ * while the real list is fetched from accountsservice.
+ *
+ * The file is memory mapped: the index is read in place and face thumbnails are
+ * stored already decoded, so loading it costs no parsing and no image decoding.
+ */
+class AccountSnapshot
+{
+    public:
+        struct Record {
+            QString path;
+            QVariantMap details;
+            QImage face;
+            qint64 iconMTime = 0;
+        };
+
+        explicit AccountSnapshot(const QString &fileName = defaultFileName());
+        ~AccountSnapshot();
+
+        static QString defaultFileName();
+        static bool save(const QString &fileName, const QVector<Record> &records);
+
+        bool load();
+        void close();
+
+        int count() const;
+        QString path(int i) const;
+        QVariantMap details(int i) const;
+        qint64 iconMTime(int i) const;
+
+        /**
+         * The returned image points into the mapped file and is only valid as
+         * long as the snapshot is open.
+         */
+        QImage face(int i) const;
+
+    private:
+        QString string(int i, int field) const;
+
+        QFile m_file;
+        const uchar* m_data = nullptr;
+        qint64 m_size = 0;
+        int m_count = 0;
+};
+
+#endif //ACCOUNT_SNAPSHOT_H
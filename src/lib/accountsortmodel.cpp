@@ -0,0 +1,376 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "accountsortmodel.h"
+#include "accountmodel.h"
+
+#include <algorithm>
+#include <numeric>
+
+AccountSortModel::AccountSortModel(QObject* parent)
+ : QAbstractProxyModel(parent)
+{
+    m_collator.setCaseSensitivity(Qt::CaseInsensitive);
+    m_collator.setNumericMode(true);
+}
+
+void AccountSortModel::setGrouped(bool grouped)
+{
+    if (m_grouped == grouped) {
+        return;
+    }
+
+    m_grouped = grouped;
+    sort();
+}
+
+bool AccountSortModel::isGrouped() const
+{
+    return m_grouped;
+}
+
+void AccountSortModel::setSourceModel(QAbstractItemModel* sourceModel)
+{
+    if (this->sourceModel()) {
+        disconnect(this->sourceModel(), nullptr, this, nullptr);
+    }
+
+    QAbstractProxyModel::setSourceModel(sourceModel);
+    if (sourceModel) {
+        connect(sourceModel, &QAbstractItemModel::rowsInserted, this, &AccountSortModel::sourceRowsInserted);
+        connect(sourceModel, &QAbstractItemModel::rowsAboutToBeRemoved, this, &AccountSortModel::sourceRowsAboutToBeRemoved);
+        connect(sourceModel, &QAbstractItemModel::rowsRemoved, this, &AccountSortModel::sourceRowsRemoved);
+        connect(sourceModel, &QAbstractItemModel::rowsMoved, this, &AccountSortModel::sourceRowsMoved);
+        connect(sourceModel, &QAbstractItemModel::dataChanged, this, &AccountSortModel::sourceDataChanged);
+        connect(sourceModel, &QAbstractItemModel::modelReset, this, &AccountSortModel::sourceReset);
+        connect(sourceModel, &QAbstractItemModel::layoutChanged, this, &AccountSortModel::sourceReset);
+    }
+
+    sourceReset();
+}
+
+QModelIndex AccountSortModel::index(int row, int column, const QModelIndex& parent) const
+{
+    if (parent.isValid() || column != 0 || row < 0 || row >= m_proxyToSource.count()) {
+        return QModelIndex();
+    }
+
+    return createIndex(row, column);
+}
+
+QModelIndex AccountSortModel::parent(const QModelIndex& child) const
+{
+    Q_UNUSED(child)
+    return QModelIndex();
+}
+
+int AccountSortModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : m_proxyToSource.count();
+}
+
+int AccountSortModel::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : 1;
+}
+
+QModelIndex AccountSortModel::mapToSource(const QModelIndex& proxyIndex) const
+{
+    if (!proxyIndex.isValid() || !sourceModel() || proxyIndex.row() >= m_proxyToSource.count()) {
+        return QModelIndex();
+    }
+
+    return sourceModel()->index(m_proxyToSource.at(proxyIndex.row()), proxyIndex.column());
+}
+
+QModelIndex AccountSortModel::mapFromSource(const QModelIndex& sourceIndex) const
+{
+    if (!sourceIndex.isValid() || sourceIndex.row() >= m_sourceToProxy.count()) {
+        return QModelIndex();
+    }
+
+    return index(m_sourceToProxy.at(sourceIndex.row()), sourceIndex.column());
+}
+
+QVariant AccountSortModel::data(const QModelIndex& index, int role) const
+{
+    if (role == GroupRole) {
+        if (!index.isValid() || index.row() >= m_proxyToSource.count()) {
+            return QVariant();
+        }
+        return m_keys.at(m_proxyToSource.at(index.row())).group;
+    }
+
+    return QAbstractProxyModel::data(index, role);
+}
+
+AccountSortModel::Key AccountSortModel::makeKey(int sourceRow) const
+{
+    const QModelIndex index = sourceModel()->index(sourceRow, 0);
+    const QString name = index.data(Qt::DisplayRole).toString();
+
+    Group group = Others;
+    if (!index.data(AccountModel::Created).toBool()) {
+        group = NewUser;
+    } else if (index.data(AccountModel::Username).toString().isEmpty()) {
+        group = Loading;
+    } else if (!m_grouped) {
+        group = Others;
+    } else if (index.data(AccountModel::Logged).toBool()) {
+        group = LoggedIn;
+    } else if (index.data(AccountModel::Administrator).toBool()) {
+        group = Administrators;
+    }
+
+    return Key{group, m_collator.sortKey(name)};
+}
+
+bool AccountSortModel::lessThan(int sourceRow, int otherSourceRow) const
+{
+    const Key &key = m_keys.at(sourceRow);
+    const Key &other = m_keys.at(otherSourceRow);
+    if (key.group != other.group) {
+        return key.group < other.group;
+    }
+
+    const int order = key.name.compare(other.name);
+    if (order != 0) {
+        return order < 0;
+    }
+
+    // Keeps equal names in a stable order
+    return sourceRow < otherSourceRow;
+}
+
+int AccountSortModel::insertPosition(int sourceRow) const
+{
+    const auto it = std::lower_bound(m_proxyToSource.cbegin(), m_proxyToSource.cend(), sourceRow, [this](int row, int sourceRow) {
+        return lessThan(row, sourceRow);
+    });
+    return it - m_proxyToSource.cbegin();
+}
+
+void AccountSortModel::updateSourceToProxy(int from)
+{
+    // Sized by the source, rows being inserted or removed may not be placed yet
+    m_sourceToProxy.resize(int(m_keys.size()));
+    for (int row = from; row < m_proxyToSource.count(); ++row) {
+        m_sourceToProxy[m_proxyToSource.at(row)] = row;
+    }
+}
+
+void AccountSortModel::sort()
+{
+    Q_EMIT layoutAboutToBeChanged();
+    const QModelIndexList before = persistentIndexList();
+    QVector<int> sourceRows;
+    sourceRows.reserve(before.count());
+    for (const QModelIndex &index : before) {
+        sourceRows.append(m_proxyToSource.at(index.row()));
+    }
+
+    for (int row = 0; row < int(m_keys.size()); ++row) {
+        m_keys[row] = makeKey(row);
+    }
+    std::sort(m_proxyToSource.begin(), m_proxyToSource.end(), [this](int a, int b) {
+        return lessThan(a, b);
+    });
+    updateSourceToProxy();
+
+    QModelIndexList after;
+    after.reserve(before.count());
+    for (int i = 0; i < before.count(); ++i) {
+        after.append(index(m_sourceToProxy.at(sourceRows.at(i)), before.at(i).column()));
+    }
+    changePersistentIndexList(before, after);
+    Q_EMIT layoutChanged();
+}
+
+void AccountSortModel::sourceReset()
+{
+    beginResetModel();
+    const int count = sourceModel() ? sourceModel()->rowCount() : 0;
+    m_keys.clear();
+    m_keys.reserve(count);
+    for (int row = 0; row < count; ++row) {
+        m_keys.push_back(makeKey(row));
+    }
+
+    m_proxyToSource.resize(count);
+    std::iota(m_proxyToSource.begin(), m_proxyToSource.end(), 0);
+    std::sort(m_proxyToSource.begin(), m_proxyToSource.end(), [this](int a, int b) {
+        return lessThan(a, b);
+    });
+    updateSourceToProxy();
+    endResetModel();
+}
+
+void AccountSortModel::sourceRowsInserted(const QModelIndex& parent, int first, int last)
+{
+    if (parent.isValid()) {
+        return;
+    }
+
+    // Make room in the source numbering first
+    const int count = last - first + 1;
+    for (int &sourceRow : m_proxyToSource) {
+        if (sourceRow >= first) {
+            sourceRow += count;
+        }
+    }
+    std::vector<Key> keys;
+    keys.reserve(count);
+    QVector<int> added;
+    added.reserve(count);
+    for (int row = first; row <= last; ++row) {
+        keys.push_back(makeKey(row));
+        added.append(row);
+    }
+    m_keys.insert(m_keys.begin() + first, keys.cbegin(), keys.cend());
+
+    // Rows shown above the first insertion were renumbered as well
+    updateSourceToProxy();
+
+    // New rows that end up next to each other are inserted together, so filling
+    // the list at startup takes a handful of insertions rather than one per row
+    std::sort(added.begin(), added.end(), [this](int a, int b) {
+        return lessThan(a, b);
+    });
+    for (int i = 0; i < added.count();) {
+        const int position = insertPosition(added.at(i));
+        int j = i + 1;
+        while (j < added.count() && (position == m_proxyToSource.count() || lessThan(added.at(j), m_proxyToSource.at(position)))) {
+            ++j;
+        }
+
+        beginInsertRows(QModelIndex(), position, position + j - i - 1);
+        m_proxyToSource.insert(position, j - i, 0);
+        std::copy(added.cbegin() + i, added.cbegin() + j, m_proxyToSource.begin() + position);
+        updateSourceToProxy(position);
+        endInsertRows();
+        i = j;
+    }
+}
+
+void AccountSortModel::sourceRowsAboutToBeRemoved(const QModelIndex& parent, int first, int last)
+{
+    if (parent.isValid()) {
+        return;
+    }
+
+    // Source rows keep their numbers until sourceRowsRemoved()
+    for (int row = last; row >= first; --row) {
+        const int position = m_sourceToProxy.at(row);
+        beginRemoveRows(QModelIndex(), position, position);
+        m_proxyToSource.remove(position);
+        updateSourceToProxy(position);
+        endRemoveRows();
+    }
+}
+
+void AccountSortModel::sourceRowsRemoved(const QModelIndex& parent, int first, int last)
+{
+    if (parent.isValid()) {
+        return;
+    }
+
+    const int count = last - first + 1;
+    m_keys.erase(m_keys.begin() + first, m_keys.begin() + last + 1);
+    for (int &sourceRow : m_proxyToSource) {
+        if (sourceRow > last) {
+            sourceRow -= count;
+        }
+    }
+    updateSourceToProxy();
+}
+
+void AccountSortModel::sourceRowsMoved(const QModelIndex& parent, int start, int end, const QModelIndex& destination, int row)
+{
+    if (parent.isValid() || destination.isValid()) {
+        return;
+    }
+
+    // The order shown does not depend on the source order, only the numbering changes
+    QVector<int> sourceOrder(m_keys.size());
+    std::iota(sourceOrder.begin(), sourceOrder.end(), 0);
+    const int count = end - start + 1;
+    const QVector<int> moved = sourceOrder.mid(start, count);
+    sourceOrder.remove(start, count);
+    sourceOrder.insert(row > start ? row - count : row, count, 0);
+    std::copy(moved.cbegin(), moved.cend(), sourceOrder.begin() + (row > start ? row - count : row));
+
+    // sourceOrder maps new source rows to old ones, renumber through its inverse
+    QVector<int> newRow(sourceOrder.count());
+    std::vector<Key> keys;
+    keys.reserve(m_keys.size());
+    for (int i = 0; i < sourceOrder.count(); ++i) {
+        newRow[sourceOrder.at(i)] = i;
+        keys.push_back(m_keys.at(sourceOrder.at(i)));
+    }
+    m_keys.swap(keys);
+    for (int &sourceRow : m_proxyToSource) {
+        sourceRow = newRow.at(sourceRow);
+    }
+    updateSourceToProxy();
+}
+
+void AccountSortModel::sourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles)
+{
+    if (topLeft.parent().isValid()) {
+        return;
+    }
+
+    static const QVector<int> s_sortRoles = {Qt::DisplayRole, AccountModel::Username, AccountModel::Logged, AccountModel::Administrator};
+    const bool resort = roles.isEmpty() || std::any_of(roles.cbegin(), roles.cend(), [](int role) {
+        return s_sortRoles.contains(role);
+    });
+
+    for (int row = topLeft.row(); resort && row <= bottomRight.row(); ++row) {
+        const Key key = makeKey(row);
+        if (key.group == m_keys.at(row).group && key.name.compare(m_keys.at(row).name) == 0) {
+            continue;
+        }
+
+        // Take the row out, find where it belongs now and move it there
+        const int from = m_sourceToProxy.at(row);
+        m_proxyToSource.remove(from);
+        m_keys[row] = key;
+        const int to = insertPosition(row);
+        m_proxyToSource.insert(from, row);
+        if (to == from) {
+            continue;
+        }
+
+        beginMoveRows(QModelIndex(), from, from, QModelIndex(), to > from ? to + 1 : to);
+        m_proxyToSource.remove(from);
+        m_proxyToSource.insert(to, row);
+        updateSourceToProxy(qMin(from, to));
+        endMoveRows();
+    }
+
+    // One signal for the span the changed rows cover now, views repaint that anyway
+    int firstRow = m_proxyToSource.count();
+    int lastRow = -1;
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+        firstRow = qMin(firstRow, m_sourceToProxy.at(row));
+        lastRow = qMax(lastRow, m_sourceToProxy.at(row));
+    }
+    if (firstRow <= lastRow) {
+        Q_EMIT dataChanged(index(firstRow, 0), index(lastRow, 0), roles);
+    }
+}
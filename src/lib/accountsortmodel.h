@@ -0,0 +1,95 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#ifndef ACCOUNT_SORT_MODEL_H
+#define ACCOUNT_SORT_MODEL_H
+
+#include <QAbstractProxyModel>
+#include <QCollator>
+#include <QVector>
+
+#include <vector>
+
+/**
+ * AccountModel sorted for display: logged in users first, then administrators,
+ * then everybody else, each group by name in the user's locale. Accounts still
+ * loading come after them and the "new user" row stays last.
+ *
+ * Collation keys are computed once per row when it arrives or its name changes.
+ * A changed row is moved to its new place, found by binary search, instead of
+ * sorting everything again.
+ */
+class AccountSortModel : public QAbstractProxyModel
+{
+    Q_OBJECT
+    public:
+        enum Group {
+            LoggedIn,
+            Administrators,
+            Others,
+            Loading,
+            NewUser
+        };
+
+        enum Role {
+            GroupRole = Qt::UserRole + 0x100
+        };
+
+        explicit AccountSortModel(QObject* parent = nullptr);
+
+        /* When off, only loading accounts and the "new user" row are kept apart */
+        void setGrouped(bool grouped);
+        bool isGrouped() const;
+
+        void setSourceModel(QAbstractItemModel* sourceModel) override;
+        QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const override;
+        QModelIndex parent(const QModelIndex& child) const override;
+        int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+        int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+        QModelIndex mapToSource(const QModelIndex& proxyIndex) const override;
+        QModelIndex mapFromSource(const QModelIndex& sourceIndex) const override;
+        QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    private Q_SLOTS:
+        void sourceRowsInserted(const QModelIndex& parent, int first, int last);
+        void sourceRowsAboutToBeRemoved(const QModelIndex& parent, int first, int last);
+        void sourceRowsRemoved(const QModelIndex& parent, int first, int last);
+        void sourceRowsMoved(const QModelIndex& parent, int start, int end, const QModelIndex& destination, int row);
+        void sourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles);
+        void sourceReset();
+
+    private:
+        struct Key {
+            Group group;
+            QCollatorSortKey name;
+        };
+
+        Key makeKey(int sourceRow) const;
+        bool lessThan(int sourceRow, int otherSourceRow) const;
+        int insertPosition(int sourceRow) const;
+        void updateSourceToProxy(int from = 0);
+        void sort();
+
+        QCollator m_collator;
+        bool m_grouped = true;
+        std::vector<Key> m_keys;
+        QVector<int> m_proxyToSource;
+        QVector<int> m_sourceToProxy;
+};
+
+#endif //ACCOUNT_SORT_MODEL_H
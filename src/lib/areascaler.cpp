@@ -0,0 +1,344 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "areascaler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AREA_SCALER_X86
+#include <immintrin.h>
+#endif
+
+/*
+ * Which source pixels make up each destination pixel along one axis, and by how
+ * much. Destination pixel i covers [i * scale, (i + 1) * scale) of the source.
+ */
+struct AreaFilter
+{
+    AreaFilter(int source, int destination)
+    {
+        const double scale = double(source) / destination;
+        first.resize(destination);
+        count.resize(destination);
+        offset.resize(destination);
+        for (int i = 0; i < destination; ++i) {
+            const double begin = i * scale;
+            const double end = (i + 1) * scale;
+            const int j0 = static_cast<int>(begin);
+            const int j1 = std::min(source, static_cast<int>(std::ceil(end)));
+
+            first[i] = j0;
+            count[i] = j1 - j0;
+            offset[i] = static_cast<int>(weights.size());
+            for (int j = j0; j < j1; ++j) {
+                const double overlap = std::min<double>(j + 1, end) - std::max<double>(j, begin);
+                weights.push_back(static_cast<float>(std::max(0.0, overlap) / scale));
+            }
+        }
+    }
+
+    std::vector<int> first;
+    std::vector<int> count;
+    std::vector<int> offset;
+    std::vector<float> weights;
+};
+
+/*
+ * The three steps of the kernel, all on 4 channel, 8 bit pixels in memory order:
+ * filter a source row horizontally into floats, add a weighted float row to the
+ * destination row being built, and round that back to 8 bits.
+ */
+struct AreaKernel
+{
+    void (*filterRow)(const uchar *source, float *row, const AreaFilter &filter);
+    void (*accumulate)(const float *row, float *sum, float weight, int count);
+    void (*store)(const float *sum, uchar *destination, int count);
+};
+
+static void filterRowScalar(const uchar *source, float *row, const AreaFilter &filter)
+{
+    const int width = static_cast<int>(filter.first.size());
+    for (int i = 0; i < width; ++i) {
+        const uchar *pixel = source + 4 * filter.first[i];
+        const float *weight = filter.weights.data() + filter.offset[i];
+        float sum[4] = { 0, 0, 0, 0 };
+        for (int k = 0; k < filter.count[i]; ++k, pixel += 4) {
+            for (int c = 0; c < 4; ++c) {
+                sum[c] += weight[k] * pixel[c];
+            }
+        }
+        std::memcpy(row + 4 * i, sum, sizeof(sum));
+    }
+}
+
+static void accumulateScalar(const float *row, float *sum, float weight, int count)
+{
+    for (int x = 0; x < count; ++x) {
+        sum[x] += weight * row[x];
+    }
+}
+
+static void storeScalar(const float *sum, uchar *destination, int count)
+{
+    for (int x = 0; x < count; ++x) {
+        destination[x] = static_cast<uchar>(std::min(255.0f, std::max(0.0f, sum[x] + 0.5f)));
+    }
+}
+
+#ifdef AREA_SCALER_X86
+__attribute__((target("sse2")))
+static inline __m128 loadPixelSse2(const uchar *pixel)
+{
+    int value;
+    std::memcpy(&value, pixel, sizeof(value));
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bytes = _mm_cvtsi32_si128(value);
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero));
+}
+
+__attribute__((target("sse2")))
+static void filterRowSse2(const uchar *source, float *row, const AreaFilter &filter)
+{
+    const int width = static_cast<int>(filter.first.size());
+    for (int i = 0; i < width; ++i) {
+        const uchar *pixel = source + 4 * filter.first[i];
+        const float *weight = filter.weights.data() + filter.offset[i];
+        __m128 sum = _mm_setzero_ps();
+        for (int k = 0; k < filter.count[i]; ++k, pixel += 4) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(loadPixelSse2(pixel), _mm_set1_ps(weight[k])));
+        }
+        _mm_storeu_ps(row + 4 * i, sum);
+    }
+}
+
+__attribute__((target("sse2")))
+static void accumulateSse2(const float *row, float *sum, float weight, int count)
+{
+    const __m128 w = _mm_set1_ps(weight);
+    int x = 0;
+    for (; x + 4 <= count; x += 4) {
+        _mm_storeu_ps(sum + x, _mm_add_ps(_mm_loadu_ps(sum + x), _mm_mul_ps(_mm_loadu_ps(row + x), w)));
+    }
+    accumulateScalar(row + x, sum + x, weight, count - x);
+}
+
+__attribute__((target("sse2")))
+static void storeSse2(const float *sum, uchar *destination, int count)
+{
+    // Four pixels at a time; cvtps rounds to nearest and the packs saturate
+    int x = 0;
+    for (; x + 16 <= count; x += 16) {
+        const __m128i a = _mm_cvtps_epi32(_mm_loadu_ps(sum + x));
+        const __m128i b = _mm_cvtps_epi32(_mm_loadu_ps(sum + x + 4));
+        const __m128i c = _mm_cvtps_epi32(_mm_loadu_ps(sum + x + 8));
+        const __m128i d = _mm_cvtps_epi32(_mm_loadu_ps(sum + x + 12));
+        const __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + x), bytes);
+    }
+    storeScalar(sum + x, destination + x, count - x);
+}
+
+__attribute__((target("avx2")))
+static void filterRowAvx2(const uchar *source, float *row, const AreaFilter &filter)
+{
+    // Two source pixels per step, one in each 128 bit lane
+    const int width = static_cast<int>(filter.first.size());
+    for (int i = 0; i < width; ++i) {
+        const uchar *pixel = source + 4 * filter.first[i];
+        const float *weight = filter.weights.data() + filter.offset[i];
+        const int count = filter.count[i];
+        __m256 sum = _mm256_setzero_ps();
+        int k = 0;
+        for (; k + 2 <= count; k += 2, pixel += 8) {
+            const __m256 pixels = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pixel))));
+            const __m256 weights = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(weight[k])), _mm_set1_ps(weight[k + 1]), 1);
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(pixels, weights));
+        }
+
+        __m128 total = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+        if (k < count) {
+            total = _mm_add_ps(total, _mm_mul_ps(loadPixelSse2(pixel), _mm_set1_ps(weight[k])));
+        }
+        _mm_storeu_ps(row + 4 * i, total);
+    }
+}
+
+__attribute__((target("avx2")))
+static void accumulateAvx2(const float *row, float *sum, float weight, int count)
+{
+    const __m256 w = _mm256_set1_ps(weight);
+    int x = 0;
+    for (; x + 8 <= count; x += 8) {
+        _mm256_storeu_ps(sum + x, _mm256_add_ps(_mm256_loadu_ps(sum + x), _mm256_mul_ps(_mm256_loadu_ps(row + x), w)));
+    }
+    accumulateScalar(row + x, sum + x, weight, count - x);
+}
+#endif
+
+// Indexed by AreaScaler::Kernel
+static const AreaKernel s_kernels[] = {
+    { filterRowScalar, accumulateScalar, storeScalar },
+#ifdef AREA_SCALER_X86
+    { filterRowSse2, accumulateSse2, storeSse2 },
+    // Rounding back to bytes happens once per row, SSE2 is plenty for it
+    { filterRowAvx2, accumulateAvx2, storeSse2 },
+#endif
+};
+
+// Scaling runs on worker threads too, -1 until the first use picks the best kernel
+static std::atomic<int> s_kernel(-1);
+
+static AreaScaler::Kernel bestKernel()
+{
+    if (AreaScaler::isSupported(AreaScaler::AVX2)) {
+        return AreaScaler::AVX2;
+    }
+    if (AreaScaler::isSupported(AreaScaler::SSE2)) {
+        return AreaScaler::SSE2;
+    }
+    return AreaScaler::Scalar;
+}
+
+static const AreaKernel& areaKernel()
+{
+    return s_kernels[AreaScaler::kernel()];
+}
+
+static void scaleArea(const uchar *source, int sourceStride, int sourceWidth, int sourceHeight,
+                      uchar *destination, int destinationStride, int width, int height)
+{
+    const AreaKernel &kernel = areaKernel();
+    const AreaFilter horizontal(sourceWidth, width);
+    const AreaFilter vertical(sourceHeight, height);
+
+    std::vector<float> row(4 * width);
+    std::vector<float> sum(4 * width);
+    int filteredRow = -1;
+
+    for (int y = 0; y < height; ++y) {
+        std::fill(sum.begin(), sum.end(), 0.0f);
+        const float *weight = vertical.weights.data() + vertical.offset[y];
+        for (int k = 0; k < vertical.count[y]; ++k) {
+            // A source row straddling two destination rows is only filtered once
+            const int j = vertical.first[y] + k;
+            if (j != filteredRow) {
+                kernel.filterRow(source + j * sourceStride, row.data(), horizontal);
+                filteredRow = j;
+            }
+            kernel.accumulate(row.data(), sum.data(), weight[k], 4 * width);
+        }
+        kernel.store(sum.data(), destination + y * destinationStride, 4 * width);
+    }
+}
+
+QImage AreaScaler::scaled(const QImage &image, const QSize &size)
+{
+    if (image.isNull() || size.isEmpty()) {
+        return QImage();
+    }
+
+    if (size.width() > image.width() || size.height() > image.height()) {
+        return image.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+
+    // Averaging is only correct on premultiplied colors
+    const QImage::Format format = image.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32;
+    const QImage source = image.convertToFormat(format);
+    QImage result(size, format);
+    if (result.isNull()) {
+        return QImage();
+    }
+
+    scaleArea(source.constBits(), source.bytesPerLine(), source.width(), source.height(),
+              result.bits(), result.bytesPerLine(), size.width(), size.height());
+    result.setDevicePixelRatio(image.devicePixelRatio());
+    return result;
+}
+
+QImage AreaScaler::scaledToFit(const QImage &image, int size)
+{
+    return scaled(image, image.size().scaled(size, size, Qt::KeepAspectRatio).expandedTo(QSize(1, 1)));
+}
+
+QImage AreaScaler::scaledToWidth(const QImage &image, int width)
+{
+    if (image.isNull() || width <= 0) {
+        return QImage();
+    }
+
+    const int height = qMax(1, qRound(qreal(image.height()) * width / image.width()));
+    return scaled(image, QSize(width, height));
+}
+
+AreaScaler::Kernel AreaScaler::kernel()
+{
+    int kernel = s_kernel.load(std::memory_order_relaxed);
+    if (kernel < 0) {
+        // Should setKernel() have been quicker, its choice stays
+        int unset = -1;
+        s_kernel.compare_exchange_strong(unset, bestKernel());
+        kernel = s_kernel.load();
+    }
+    return static_cast<Kernel>(kernel);
+}
+
+bool AreaScaler::isSupported(Kernel kernel)
+{
+    switch (kernel) {
+        case Scalar:
+            return true;
+#ifdef AREA_SCALER_X86
+        case SSE2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse2");
+        case AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+bool AreaScaler::setKernel(Kernel kernel)
+{
+    if (!isSupported(kernel)) {
+        return false;
+    }
+
+    s_kernel.store(kernel);
+    return true;
+}
+
+const char* AreaScaler::kernelName(Kernel kernel)
+{
+    switch (kernel) {
+        case Scalar:
+            return "scalar";
+        case SSE2:
+            return "SSE2";
+        case AVX2:
+            return "AVX2";
+    }
+    return "unknown";
+}
@@ -0,0 +1,55 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#ifndef AREA_SCALER_H
+#define AREA_SCALER_H
+
+#include <QImage>
+
+/**
+ * Downscales images by averaging the area of the source each destination pixel
+ * covers, the right filter for shrinking photos into faces. It is quicker than
+ * Qt::SmoothTransformation and does not alias at large ratios.
+ *
+ * The kernel is picked at runtime: AVX2 or SSE2 where the CPU has them, plain
+ * C++ elsewhere. Enlarging is left to QImage::scaled().
+ */
+class AreaScaler
+{
+    public:
+        enum Kernel {
+            Scalar,
+            SSE2,
+            AVX2
+        };
+
+        static QImage scaled(const QImage &image, const QSize &size);
+        static QImage scaledToFit(const QImage &image, int size);
+        static QImage scaledToWidth(const QImage &image, int width);
+
+        /**
+         * The kernel in use, the best one the CPU runs unless setKernel() forced
+         * another. Tests and benchmarks use these to compare the kernels.
+         */
+        static Kernel kernel();
+        static bool isSupported(Kernel kernel);
+        static bool setKernel(Kernel kernel);
+        static const char* kernelName(Kernel kernel);
+};
+
+#endif //AREA_SCALER_H
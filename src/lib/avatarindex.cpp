@@ -0,0 +1,355 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "avatarindex.h"
+#include "areascaler.h"
+#include "thumbnailcache.h"
+
+#include <QDir>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QGuiApplication>
+#include <QImageReader>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+// Decoded pictures kept for scrolling back, in kB
+static const int s_iconCacheSize = 32 * 1024;
+
+static void scanDirectory(const QStringList &roots, const QString &relative, AvatarIndex::Scan &scan,
+                          QHash<QString, int> &seen, QSet<QString> &visited)
+{
+    // Subdirectories of any root count, even if another root lacks them
+    QSet<QString> subdirectories;
+    for (const QString &root : roots) {
+        const QDir dir(relative.isEmpty() ? root : root + QLatin1Char('/') + relative);
+        if (!dir.exists()) {
+            continue;
+        }
+
+        // A symlink back up the tree would otherwise be followed forever
+        const QString canonical = dir.canonicalPath();
+        if (visited.contains(canonical)) {
+            continue;
+        }
+        visited.insert(canonical);
+        scan.directories << dir.absolutePath();
+
+        const QFileInfoList files = dir.entryInfoList(QDir::Files | QDir::Readable);
+        for (const QFileInfo &file : files) {
+            const QString name = relative.isEmpty() ? file.fileName() : relative + QLatin1Char('/') + file.fileName();
+            if (seen.contains(name)) {
+                continue;
+            }
+            seen.insert(name, scan.entries.size());
+
+            AvatarIndex::Entry entry;
+            entry.relative = name;
+            entry.path = file.absoluteFilePath();
+            entry.name = file.fileName().section(QLatin1Char('.'), 0, 0);
+            entry.category = relative;
+            entry.search = (entry.name + QLatin1Char(' ') + entry.category).toCaseFolded();
+            entry.modified = file.lastModified();
+            entry.size = file.size();
+            scan.entries << entry;
+        }
+
+        const QStringList dirs = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+        for (const QString &subdirectory : dirs) {
+            subdirectories.insert(subdirectory);
+        }
+    }
+
+    for (const QString &subdirectory : qAsConst(subdirectories)) {
+        scanDirectory(roots, relative.isEmpty() ? subdirectory : relative + QLatin1Char('/') + subdirectory, scan, seen, visited);
+    }
+}
+
+/*
+ * Scans each of the relative directories, including everything below, in all
+ * roots at once so the first root can shadow the others.
+ */
+static QVector<AvatarIndex::Scan> scanTrees(const QStringList &roots, const QStringList &relatives)
+{
+    QVector<AvatarIndex::Scan> scans;
+    for (const QString &relative : relatives) {
+        AvatarIndex::Scan scan;
+        scan.relative = relative;
+        QHash<QString, int> seen;
+        QSet<QString> visited;
+        scanDirectory(roots, relative, scan, seen, visited);
+        std::sort(scan.entries.begin(), scan.entries.end(), [](const AvatarIndex::Entry &a, const AvatarIndex::Entry &b) {
+            return a.relative < b.relative;
+        });
+        scans << scan;
+    }
+
+    return scans;
+}
+
+static QImage loadPicture(const QString &path, int size)
+{
+    QImage image = ThumbnailCache::find(path, size);
+    if (image.isNull()) {
+        image = QImageReader(path).read();
+        ThumbnailCache::store(path, image, size);
+    }
+
+    return AreaScaler::scaledToFit(image, size);
+}
+
+AvatarIndex::AvatarIndex(QObject* parent)
+ : QAbstractListModel(parent)
+ , m_watcher(new QFileSystemWatcher(this))
+ , m_rescanTimer(new QTimer(this))
+ , m_scan(new QFutureWatcher<QVector<Scan>>(this))
+ , m_icons(s_iconCacheSize)
+{
+    // Most important first, which is the order shadowing goes in
+    m_roots = QStandardPaths::locateAll(QStandardPaths::GenericDataLocation,
+                                        QStringLiteral("user-manager/avatars"),
+                                        QStandardPaths::LocateDirectory);
+
+    // Copying a collection in triggers a burst of changes
+    m_rescanTimer->setSingleShot(true);
+    m_rescanTimer->setInterval(200);
+    connect(m_rescanTimer, &QTimer::timeout, this, &AvatarIndex::rescan);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &AvatarIndex::directoryChanged);
+    connect(m_scan, &QFutureWatcherBase::finished, this, &AvatarIndex::scanFinished);
+
+    m_dirty.insert(QString());
+    rescan();
+}
+
+AvatarIndex::~AvatarIndex()
+{
+    m_scan->waitForFinished();
+}
+
+void AvatarIndex::setIconSize(int size)
+{
+    if (m_iconSize == size) {
+        return;
+    }
+
+    m_iconSize = size;
+    m_icons.clear();
+    if (!m_entries.isEmpty()) {
+        Q_EMIT dataChanged(index(0), index(m_entries.size() - 1), {Qt::DecorationRole});
+    }
+}
+
+int AvatarIndex::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : m_entries.size();
+}
+
+QVariant AvatarIndex::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_entries.size()) {
+        return QVariant();
+    }
+
+    const Entry &entry = m_entries.at(index.row());
+    switch (role) {
+        case Qt::DisplayRole:
+            return entry.name;
+        case Qt::ToolTipRole:
+        case CategoryRole:
+            return entry.category;
+        case PathRole:
+            return entry.path;
+        case SearchRole:
+            return entry.search;
+        case Qt::DecorationRole: {
+            if (const QPixmap *icon = m_icons.object(entry.path)) {
+                return *icon;
+            }
+            if (m_failed.contains(entry.path)) {
+                return QVariant();
+            }
+            loadIcon(entry.path);
+            return QVariant();
+        }
+    }
+
+    return QVariant();
+}
+
+void AvatarIndex::loadIcon(const QString &path) const
+{
+    if (m_loading.contains(path)) {
+        return;
+    }
+    m_loading.insert(path);
+
+    const qreal dpr = qApp->devicePixelRatio();
+    auto *watcher = new QFutureWatcher<QImage>(const_cast<AvatarIndex*>(this));
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, path, dpr]() {
+        watcher->deleteLater();
+        m_loading.remove(path);
+
+        // Not decoded again on every repaint, only once the file changed
+        const QImage image = watcher->result();
+        if (image.isNull()) {
+            m_failed.insert(path);
+            return;
+        }
+
+        auto *icon = new QPixmap(QPixmap::fromImage(image));
+        icon->setDevicePixelRatio(dpr);
+        m_icons.insert(path, icon, qMax(1, static_cast<int>(image.sizeInBytes() / 1024)));
+
+        for (int row = 0; row < m_entries.size(); ++row) {
+            if (m_entries.at(row).path == path) {
+                Q_EMIT const_cast<AvatarIndex*>(this)->dataChanged(index(row), index(row), {Qt::DecorationRole});
+                break;
+            }
+        }
+    });
+    watcher->setFuture(QtConcurrent::run(loadPicture, path, static_cast<int>(m_iconSize * dpr)));
+}
+
+QString AvatarIndex::relativeDirectory(const QString &directory) const
+{
+    for (const QString &root : m_roots) {
+        if (directory == root) {
+            return QString();
+        }
+        if (directory.startsWith(root + QLatin1Char('/'))) {
+            return directory.mid(root.size() + 1);
+        }
+    }
+
+    return QString();
+}
+
+void AvatarIndex::directoryChanged(const QString &directory)
+{
+    m_dirty.insert(relativeDirectory(directory));
+    m_rescanTimer->start();
+}
+
+void AvatarIndex::rescan()
+{
+    if (m_scan->isRunning() || m_dirty.isEmpty()) {
+        return;
+    }
+
+    // A directory is scanned with everything below it, drop what is covered twice
+    QStringList relatives;
+    if (m_dirty.contains(QString())) {
+        relatives << QString();
+    } else {
+        for (const QString &relative : qAsConst(m_dirty)) {
+            const bool covered = std::any_of(m_dirty.cbegin(), m_dirty.cend(), [&relative](const QString &other) {
+                return relative.startsWith(other + QLatin1Char('/'));
+            });
+            if (!covered) {
+                relatives << relative;
+            }
+        }
+    }
+    m_dirty.clear();
+
+    m_scan->setFuture(QtConcurrent::run(scanTrees, m_roots, relatives));
+}
+
+void AvatarIndex::scanFinished()
+{
+    const QVector<Scan> scans = m_scan->result();
+    for (const Scan &scan : scans) {
+        apply(scan);
+
+        const QStringList watched = m_watcher->directories();
+        for (const QString &directory : scan.directories) {
+            if (!watched.contains(directory)) {
+                m_watcher->addPath(directory);
+            }
+        }
+    }
+
+    // Whatever changed while scanning
+    if (!m_dirty.isEmpty()) {
+        m_rescanTimer->start();
+    }
+}
+
+void AvatarIndex::apply(const Scan &scan)
+{
+    // Entries are sorted by relative path, so everything below one directory is a range
+    const QString prefix = scan.relative.isEmpty() ? QString() : scan.relative + QLatin1Char('/');
+    int row = std::lower_bound(m_entries.cbegin(), m_entries.cend(), prefix, [](const Entry &entry, const QString &prefix) {
+        return entry.relative < prefix;
+    }) - m_entries.cbegin();
+    int end = row;
+    while (end < m_entries.size() && m_entries.at(end).relative.startsWith(prefix)) {
+        ++end;
+    }
+
+    // Nothing there yet, as on the first scan: one insertion for all of them
+    const QVector<Entry> &entries = scan.entries;
+    if (row == end) {
+        if (!entries.isEmpty()) {
+            beginInsertRows(QModelIndex(), row, row + entries.size() - 1);
+            m_entries.insert(row, entries.size(), Entry());
+            std::copy(entries.cbegin(), entries.cend(), m_entries.begin() + row);
+            endInsertRows();
+        }
+        return;
+    }
+
+    // Merge the old range with the new entries, so views keep their selection
+    int i = 0;
+    while (row < end || i < entries.size()) {
+        if (row < end && (i == entries.size() || m_entries.at(row).relative < entries.at(i).relative)) {
+            beginRemoveRows(QModelIndex(), row, row);
+            m_icons.remove(m_entries.at(row).path);
+            m_failed.remove(m_entries.at(row).path);
+            m_entries.remove(row);
+            endRemoveRows();
+            --end;
+        } else if (row == end || entries.at(i).relative < m_entries.at(row).relative) {
+            beginInsertRows(QModelIndex(), row, row);
+            m_entries.insert(row, entries.at(i));
+            endInsertRows();
+            ++row;
+            ++end;
+            ++i;
+        } else {
+            // Same name, possibly from another root now
+            if (m_entries.at(row).path != entries.at(i).path) {
+                m_icons.remove(m_entries.at(row).path);
+                m_failed.remove(m_entries.at(row).path);
+                m_entries[row] = entries.at(i);
+                Q_EMIT dataChanged(index(row), index(row));
+            } else if (m_entries.at(row).modified != entries.at(i).modified || m_entries.at(row).size != entries.at(i).size) {
+                // Rewritten in place, the cached picture is outdated and a failed one may decode now
+                m_icons.remove(entries.at(i).path);
+                m_failed.remove(entries.at(i).path);
+                m_entries[row] = entries.at(i);
+                Q_EMIT dataChanged(index(row), index(row), {Qt::DecorationRole});
+            }
+            ++row;
+            ++i;
+        }
+    }
+}
@@ -0,0 +1,103 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#ifndef AVATAR_INDEX_H
+#define AVATAR_INDEX_H
+
+#include <QAbstractListModel>
+#include <QCache>
+#include <QDateTime>
+#include <QPixmap>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+class QFileSystemWatcher;
+class QTimer;
+template<typename T> class QFutureWatcher;
+
+/**
+ * Every avatar in every user-manager/avatars data directory, as a list model.
+ *
+ * The directories are merged the XDG way: a file shadows files with the same
+ * relative path in the directories after it. Subdirectories are categories.
+ *
+ * The index is built on a worker thread and kept up to date by watching the
+ * directories. A change only rescans the directory it happened in. Pictures are
+ * only loaded for the rows a view asks for, on a worker, through the thumbnail
+ * cache.
+ */
+class AvatarIndex : public QAbstractListModel
+{
+    Q_OBJECT
+    public:
+        enum Role {
+            PathRole = Qt::UserRole,
+            CategoryRole,
+            SearchRole
+        };
+
+        struct Entry {
+            QString relative;
+            QString path;
+            QString name;
+            QString category;
+            /* Name and category, case folded, to filter on */
+            QString search;
+            /* Tell a file rewritten in place from the one whose picture is cached */
+            QDateTime modified;
+            qint64 size = -1;
+        };
+
+        struct Scan {
+            QString relative;
+            QVector<Entry> entries;
+            QStringList directories;
+        };
+
+        explicit AvatarIndex(QObject* parent = nullptr);
+        ~AvatarIndex() override;
+
+        void setIconSize(int size);
+
+        int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+        QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    private Q_SLOTS:
+        void directoryChanged(const QString &directory);
+        void rescan();
+        void scanFinished();
+
+    private:
+        void apply(const Scan &scan);
+        void loadIcon(const QString &path) const;
+        QString relativeDirectory(const QString &directory) const;
+
+        QStringList m_roots;
+        QVector<Entry> m_entries;
+        QFileSystemWatcher* m_watcher;
+        QTimer* m_rescanTimer;
+        QSet<QString> m_dirty;
+        QFutureWatcher<QVector<Scan>>* m_scan;
+        int m_iconSize = 64;
+        mutable QCache<QString, QPixmap> m_icons;
+        mutable QSet<QString> m_loading;
+        mutable QSet<QString> m_failed;
+};
+
+#endif //AVATAR_INDEX_H
@@ -0,0 +1,122 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "avatarstore.h"
+#include "fileinstaller.h"
+#include "user_manager_debug.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+struct CachedHash
+{
+    qint64 size;
+    qint64 mtime;
+    QByteArray hash;
+};
+
+// Hashes are asked for from worker threads as well
+static QMutex s_hashesMutex;
+static QHash<QString, CachedHash> s_hashes;
+
+QString AvatarStore::directory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/user-manager/avatars");
+}
+
+QByteArray AvatarStore::contentHash(const QString &path)
+{
+    const QFileInfo info(path);
+    if (!info.isFile()) {
+        return QByteArray();
+    }
+
+    const qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+    {
+        QMutexLocker locker(&s_hashesMutex);
+        const auto cached = s_hashes.constFind(info.absoluteFilePath());
+        if (cached != s_hashes.constEnd() && cached->size == info.size() && cached->mtime == mtime) {
+            return cached->hash;
+        }
+    }
+
+    QFile file(path);
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    if (!file.open(QIODevice::ReadOnly) || !hash.addData(&file)) {
+        return QByteArray();
+    }
+
+    const QByteArray result = hash.result().toHex();
+    QMutexLocker locker(&s_hashesMutex);
+    s_hashes.insert(info.absoluteFilePath(), CachedHash{info.size(), mtime, result});
+    return result;
+}
+
+bool AvatarStore::sameContent(const QString &path, const QString &other)
+{
+    if (QFileInfo(path).size() != QFileInfo(other).size()) {
+        return false;
+    }
+
+    const QByteArray hash = contentHash(path);
+    return !hash.isEmpty() && hash == contentHash(other);
+}
+
+QString AvatarStore::find(const QByteArray &key)
+{
+    // A dangling link means the object was cleaned up with the rest of the cache
+    const QFileInfo info(directory() + QStringLiteral("/keys/") + QString::fromLatin1(key));
+    return info.exists() ? info.canonicalFilePath() : QString();
+}
+
+QString AvatarStore::insert(const QByteArray &key, const QByteArray &data)
+{
+    const QDir store(directory());
+    if (!store.mkpath(QStringLiteral("objects")) || !store.mkpath(QStringLiteral("keys"))) {
+        qCDebug(USER_MANAGER_LOG) << "Cannot create" << store.path();
+        return QString();
+    }
+
+    const QByteArray hash = QCryptographicHash::hash(data, QCryptographicHash::Sha256).toHex();
+    const QString object = store.filePath(QStringLiteral("objects/") + QString::fromLatin1(hash));
+    if (!QFileInfo::exists(object)) {
+        QSaveFile file(object);
+        if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+            qCDebug(USER_MANAGER_LOG) << "Storing avatar failed:" << file.errorString();
+            return QString();
+        }
+    }
+
+    {
+        QMutexLocker locker(&s_hashesMutex);
+        const QFileInfo info(object);
+        s_hashes.insert(info.absoluteFilePath(), CachedHash{info.size(), info.lastModified().toMSecsSinceEpoch(), hash});
+    }
+
+    if (FileInstaller::link(object, store.filePath(QStringLiteral("keys/") + QString::fromLatin1(key))) == FileInstaller::Failed) {
+        return QString();
+    }
+
+    return object;
+}
@@ -0,0 +1,52 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#ifndef AVATAR_STORE_H
+#define AVATAR_STORE_H
+
+#include <QByteArray>
+#include <QString>
+
+/**
+ * Avatars already made, addressed by content.
+ *
+ * Every encoded avatar is kept once, under the SHA-256 of its data, in
+ * ~/.cache/user-manager/avatars/objects. What it was made from is recorded as a
+ * symbolic link in keys/, named after a key the caller derives from the source
+ * and the choices made, so making the same avatar again is a lookup.
+ *
+ * Content hashes of any file are remembered while its size and mtime stay the
+ * same, so comparing gallery images and icons costs one read each.
+ */
+class AvatarStore
+{
+    public:
+        /* Hex SHA-256 of the file's content, empty if it cannot be read */
+        static QByteArray contentHash(const QString &path);
+        static bool sameContent(const QString &path, const QString &other);
+
+        /* The avatar stored for key, or an empty string */
+        static QString find(const QByteArray &key);
+        /* Stores data for key and returns where it lives, or an empty string */
+        static QString insert(const QByteArray &key, const QByteArray &data);
+
+    private:
+        static QString directory();
+};
+
+#endif //AVATAR_STORE_H
@@ -0,0 +1,234 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "datachangecoalescer.h"
+
+#include <QAbstractItemModel>
+#include <QTimer>
+
+#include <algorithm>
+
+// One frame at 60Hz, nobody can tell the difference
+static const int s_flushInterval = 16;
+
+static QVector<int> mergeRoles(const QVector<int> &a, const QVector<int> &b)
+{
+    // No roles means every role
+    if (a.isEmpty() || b.isEmpty()) {
+        return QVector<int>();
+    }
+
+    QVector<int> roles = a;
+    for (int role : b) {
+        if (!roles.contains(role)) {
+            roles.append(role);
+        }
+    }
+    return roles;
+}
+
+DataChangeCoalescer::DataChangeCoalescer(QAbstractItemModel *model)
+ : QObject(model)
+ , m_model(model)
+{
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    m_timer->setInterval(s_flushInterval);
+    connect(m_timer, &QTimer::timeout, this, &DataChangeCoalescer::flush);
+
+    // Whatever is still pending would be lost with the model
+    connect(m_model, &QAbstractItemModel::modelAboutToBeReset, this, [this]() {
+        m_pending.clear();
+        m_timer->stop();
+    });
+
+    // Keep the pending ranges pointing at the same rows
+    connect(m_model, &QAbstractItemModel::rowsInserted, this, &DataChangeCoalescer::rowsInserted);
+    connect(m_model, &QAbstractItemModel::rowsRemoved, this, &DataChangeCoalescer::rowsRemoved);
+    connect(m_model, &QAbstractItemModel::rowsMoved, this, &DataChangeCoalescer::rowsMoved);
+    connect(m_model, &QAbstractItemModel::layoutChanged, this, &DataChangeCoalescer::layoutChanged);
+}
+
+DataChangeCoalescer::~DataChangeCoalescer()
+{
+}
+
+void DataChangeCoalescer::add(int first, int last, const QVector<int> &roles)
+{
+    ++m_requested;
+
+    first = qMax(0, first);
+    last = qMin(last, m_model->rowCount() - 1);
+    if (first > last) {
+        return;
+    }
+
+    m_pending.append({first, last, roles});
+    if (!m_timer->isActive()) {
+        m_timer->start();
+    }
+}
+
+void DataChangeCoalescer::add(int row, const QVector<int> &roles)
+{
+    add(row, row, roles);
+}
+
+void DataChangeCoalescer::rowsInserted(const QModelIndex &parent, int first, int last)
+{
+    if (parent.isValid()) {
+        return;
+    }
+
+    const int count = last - first + 1;
+    const int pending = m_pending.count();
+    for (int i = 0; i < pending; ++i) {
+        Range &range = m_pending[i];
+        if (range.first >= first) {
+            range.first += count;
+            range.last += count;
+        } else if (range.last >= first) {
+            // The new rows land in the middle, the tail moves past them
+            m_pending.append({last + 1, range.last + count, range.roles});
+            m_pending[i].last = first - 1;
+        }
+    }
+}
+
+void DataChangeCoalescer::rowsRemoved(const QModelIndex &parent, int first, int last)
+{
+    if (parent.isValid()) {
+        return;
+    }
+
+    const int count = last - first + 1;
+    auto shifted = [first, last, count](int row, bool isFirst) {
+        if (row < first) {
+            return row;
+        }
+        if (row > last) {
+            return row - count;
+        }
+        return isFirst ? first : first - 1;
+    };
+
+    for (Range &range : m_pending) {
+        range.first = shifted(range.first, true);
+        range.last = shifted(range.last, false);
+    }
+    m_pending.erase(std::remove_if(m_pending.begin(), m_pending.end(), [](const Range &range) {
+        return range.first > range.last;
+    }), m_pending.end());
+}
+
+void DataChangeCoalescer::rowsMoved(const QModelIndex &parent, int start, int end, const QModelIndex &destination, int row)
+{
+    if (parent.isValid() || destination.isValid()) {
+        return;
+    }
+
+    // Between these boundaries every row moves by the same offset
+    const int count = end - start + 1;
+    auto offset = [=](int at) {
+        if (row > end) {
+            if (at >= start && at <= end) {
+                return row - end - 1;
+            }
+            return at > end && at < row ? -count : 0;
+        }
+        if (at >= start && at <= end) {
+            return row - start;
+        }
+        return at >= row && at < start ? count : 0;
+    };
+    const int boundaries[] = {start, end + 1, row};
+
+    QVector<Range> moved;
+    moved.reserve(m_pending.count());
+    for (const Range &range : qAsConst(m_pending)) {
+        int from = range.first;
+        while (from <= range.last) {
+            int to = range.last;
+            for (int boundary : boundaries) {
+                if (boundary > from && boundary <= to) {
+                    to = boundary - 1;
+                }
+            }
+            const int by = offset(from);
+            moved.append({from + by, to + by, range.roles});
+            from = to + 1;
+        }
+    }
+    m_pending = moved;
+}
+
+void DataChangeCoalescer::layoutChanged()
+{
+    if (m_pending.isEmpty()) {
+        return;
+    }
+
+    // Nothing tells where rows went, so everything is reported
+    QVector<int> roles = m_pending.constFirst().roles;
+    for (const Range &range : qAsConst(m_pending)) {
+        roles = mergeRoles(roles, range.roles);
+    }
+    m_pending.clear();
+    if (m_model->rowCount() > 0) {
+        m_pending.append({0, m_model->rowCount() - 1, roles});
+    }
+}
+
+void DataChangeCoalescer::flush()
+{
+    m_timer->stop();
+    if (m_pending.isEmpty()) {
+        return;
+    }
+
+    std::sort(m_pending.begin(), m_pending.end(), [](const Range &a, const Range &b) {
+        return a.first < b.first;
+    });
+
+    // A wider role list is cheaper for the view than another signal
+    int i = 0;
+    const int pending = m_pending.count();
+    while (i < pending) {
+        const int first = m_pending.at(i).first;
+        int last = m_pending.at(i).last;
+        QVector<int> roles = m_pending.at(i).roles;
+        for (++i; i < pending && m_pending.at(i).first <= last + 1; ++i) {
+            last = qMax(last, m_pending.at(i).last);
+            roles = mergeRoles(roles, m_pending.at(i).roles);
+        }
+
+        ++m_emitted;
+        Q_EMIT dataChanged(m_model->index(first, 0), m_model->index(last, 0), roles);
+    }
+    m_pending.clear();
+}
+
+quint64 DataChangeCoalescer::requestedCount() const
+{
+    return m_requested;
+}
+
+quint64 DataChangeCoalescer::emittedCount() const
+{
+    return m_emitted;
+}
@@ -0,0 +1,85 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#ifndef DATA_CHANGE_COALESCER_H
+#define DATA_CHANGE_COALESCER_H
+
+#include <QObject>
+#include <QVector>
+
+class QAbstractItemModel;
+class QModelIndex;
+class QTimer;
+
+/**
+ * Collects the dataChanged notifications of a list model and emits them once per
+ * frame, merged into as few contiguous row ranges as possible.
+ *
+ * Pending rows are kept as plain row ranges, shifted along when rows are inserted,
+ * moved or removed before the flush, so the notification does not land on the
+ * wrong row. Marking the whole model costs a single range however many rows it has.
+ */
+class DataChangeCoalescer : public QObject
+{
+    Q_OBJECT
+    public:
+        explicit DataChangeCoalescer(QAbstractItemModel *model);
+        ~DataChangeCoalescer() override;
+
+        /**
+         * Marks rows @p first to @p last as changed, an empty @p roles means all of them.
+         */
+        void add(int first, int last, const QVector<int> &roles = QVector<int>());
+        void add(int row, const QVector<int> &roles = QVector<int>());
+
+        /**
+         * Emits everything pending right away.
+         */
+        void flush();
+
+        /**
+         * How many times add() was called and how many dataChanged were actually
+         * emitted for them. A pending range split by rows inserted or moved into
+         * it goes out as two signals, so the latter can exceed the former.
+         */
+        quint64 requestedCount() const;
+        quint64 emittedCount() const;
+
+    Q_SIGNALS:
+        void dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles);
+
+    private:
+        struct Range {
+            int first;
+            int last;
+            QVector<int> roles;
+        };
+
+        void rowsInserted(const QModelIndex &parent, int first, int last);
+        void rowsRemoved(const QModelIndex &parent, int first, int last);
+        void rowsMoved(const QModelIndex &parent, int start, int end, const QModelIndex &destination, int row);
+        void layoutChanged();
+
+        QAbstractItemModel *m_model;
+        QTimer *m_timer;
+        QVector<Range> m_pending;
+        quint64 m_requested = 0;
+        quint64 m_emitted = 0;
+};
+
+#endif //DATA_CHANGE_COALESCER_H
@@ -0,0 +1,82 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "emailsettingswriter.h"
+
+#include <QFutureWatcher>
+#include <QTimer>
+#include <QtConcurrent>
+
+static void writeSettings(const QHash<int, QString> &settings)
+{
+    // Opens the default profile, each setSetting() syncs
+    KEMailSettings emailSettings;
+    for (auto it = settings.constBegin(); it != settings.constEnd(); ++it) {
+        emailSettings.setSetting(static_cast<KEMailSettings::Setting>(it.key()), it.value());
+    }
+}
+
+EmailSettingsWriter::EmailSettingsWriter(QObject* parent)
+ : QObject(parent)
+ , m_timer(new QTimer(this))
+ , m_write(new QFutureWatcher<void>(this))
+{
+    // AccountInfo::save() sets RealName and Email one after the other
+    m_timer->setSingleShot(true);
+    m_timer->setInterval(0);
+    connect(m_timer, &QTimer::timeout, this, &EmailSettingsWriter::flush);
+    connect(m_write, &QFutureWatcherBase::finished, this, &EmailSettingsWriter::written);
+}
+
+EmailSettingsWriter::~EmailSettingsWriter()
+{
+    // Whatever is still queued must not be lost when the module is closed
+    m_write->waitForFinished();
+    if (!m_pending.isEmpty()) {
+        writeSettings(m_pending);
+    }
+}
+
+void EmailSettingsWriter::set(KEMailSettings::Setting setting, const QString &value)
+{
+    m_pending.insert(setting, value);
+    m_timer->start();
+}
+
+int EmailSettingsWriter::writeCount() const
+{
+    return m_writeCount;
+}
+
+void EmailSettingsWriter::flush()
+{
+    if (m_pending.isEmpty()) {
+        return;
+    }
+
+    // Two writers on the same file would race; try again once the current one is done
+    if (m_write->isRunning()) {
+        m_timer->start(50);
+        return;
+    }
+
+    m_timer->setInterval(0);
+    ++m_writeCount;
+    m_write->setFuture(QtConcurrent::run(writeSettings, m_pending));
+    m_pending.clear();
+}
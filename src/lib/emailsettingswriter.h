@@ -0,0 +1,65 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#ifndef EMAIL_SETTINGS_WRITER_H
+#define EMAIL_SETTINGS_WRITER_H
+
+#include <QObject>
+#include <QFuture>
+#include <QHash>
+
+#include <KEMailSettings>
+
+class QTimer;
+template<typename T> class QFutureWatcher;
+
+/**
+ * Writes the name and address of the current user to the KDE email settings.
+ *
+ * KEMailSettings syncs emaildefaults to disk after every key, so settings changed
+ * together are collected until control returns to the event loop and written in
+ * one go on a worker thread. Whatever is still queued is written on destruction.
+ */
+class EmailSettingsWriter : public QObject
+{
+    Q_OBJECT
+    public:
+        explicit EmailSettingsWriter(QObject* parent = nullptr);
+        ~EmailSettingsWriter() override;
+
+        void set(KEMailSettings::Setting setting, const QString &value);
+
+        /**
+         * How many batches went to disk so far.
+         */
+        int writeCount() const;
+
+    Q_SIGNALS:
+        void written();
+
+    private Q_SLOTS:
+        void flush();
+
+    private:
+        QHash<int, QString> m_pending;
+        QTimer* m_timer;
+        QFutureWatcher<void>* m_write;
+        int m_writeCount = 0;
+};
+
+#endif //EMAIL_SETTINGS_WRITER_H
@@ -0,0 +1,194 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "fileinstaller.h"
+#include "user_manager_debug.h"
+
+#include <QFile>
+#include <QRandomGenerator>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const size_t s_chunkSize = 64 * 1024;
+
+static bool readFully(int fd, char *buffer, size_t size, off_t offset)
+{
+    while (size > 0) {
+        const ssize_t n = pread(fd, buffer, size, offset);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        buffer += n;
+        size -= n;
+        offset += n;
+    }
+
+    return true;
+}
+
+static bool sameContent(int a, int b)
+{
+    struct stat sa, sb;
+    if (fstat(a, &sa) != 0 || fstat(b, &sb) != 0 || sa.st_size != sb.st_size) {
+        return false;
+    }
+    if (sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino) {
+        return true;
+    }
+
+    QByteArray bufferA(s_chunkSize, Qt::Uninitialized);
+    QByteArray bufferB(s_chunkSize, Qt::Uninitialized);
+    for (off_t offset = 0; offset < sa.st_size; offset += s_chunkSize) {
+        const size_t size = std::min<off_t>(s_chunkSize, sa.st_size - offset);
+        if (!readFully(a, bufferA.data(), size, offset) || !readFully(b, bufferB.data(), size, offset)
+            || memcmp(bufferA.constData(), bufferB.constData(), size) != 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool copyData(int in, int out, off_t size)
+{
+    if (ioctl(out, FICLONE, in) == 0) {
+        return true;
+    }
+
+    // Not on the same filesystem or not one with reflinks, let the kernel copy
+    off_t inOffset = 0;
+    off_t outOffset = 0;
+    while (outOffset < size) {
+        const ssize_t n = copy_file_range(in, &inOffset, out, &outOffset, size - outOffset, 0);
+        if (n > 0) {
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && outOffset == 0 && (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP)) {
+            break;
+        }
+        return false;
+    }
+    if (outOffset == size) {
+        return true;
+    }
+
+    QByteArray buffer(s_chunkSize, Qt::Uninitialized);
+    for (off_t offset = 0; offset < size; offset += s_chunkSize) {
+        const size_t chunk = std::min<off_t>(s_chunkSize, size - offset);
+        if (!readFully(in, buffer.data(), chunk, offset)) {
+            return false;
+        }
+        for (size_t written = 0; written < chunk;) {
+            const ssize_t n = pwrite(out, buffer.constData() + written, chunk - written, offset + written);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            written += n;
+        }
+    }
+
+    return true;
+}
+
+FileInstaller::Result FileInstaller::install(const QString &source, const QString &destination, int mode)
+{
+    const int in = open(QFile::encodeName(source).constData(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        qCDebug(USER_MANAGER_LOG) << "Cannot open" << source << strerror(errno);
+        return Failed;
+    }
+
+    const QByteArray target = QFile::encodeName(destination);
+    const int existing = open(target.constData(), O_RDONLY | O_CLOEXEC);
+    if (existing >= 0) {
+        const bool same = sameContent(in, existing);
+        close(existing);
+        if (same) {
+            close(in);
+            return Unchanged;
+        }
+    }
+
+    struct stat st;
+    QByteArray temporary = target + ".XXXXXX";
+    const int out = fstat(in, &st) == 0 ? mkostemp(temporary.data(), O_CLOEXEC) : -1;
+    if (out < 0) {
+        qCDebug(USER_MANAGER_LOG) << "Cannot create a file next to" << destination << strerror(errno);
+        close(in);
+        return Failed;
+    }
+
+    const bool copied = copyData(in, out, st.st_size) && fchmod(out, mode) == 0 && fsync(out) == 0;
+    close(in);
+    if (close(out) != 0 || !copied || rename(temporary.constData(), target.constData()) != 0) {
+        qCDebug(USER_MANAGER_LOG) << "Installing" << source << "as" << destination << "failed:" << strerror(errno);
+        unlink(temporary.constData());
+        return Failed;
+    }
+
+    return Installed;
+}
+
+FileInstaller::Result FileInstaller::link(const QString &target, const QString &linkPath)
+{
+    const QByteArray linkName = QFile::encodeName(linkPath);
+    const QByteArray targetName = QFile::encodeName(target);
+
+    QByteArray current(PATH_MAX, Qt::Uninitialized);
+    const ssize_t length = readlink(linkName.constData(), current.data(), current.size());
+    if (length >= 0 && QByteArray(current.constData(), length) == targetName) {
+        return Unchanged;
+    }
+
+    // symlink() cannot replace a file; rename() over it can, and atomically
+    for (int attempt = 0; attempt < 8; ++attempt) {
+        const QByteArray temporary = linkName + '.' + QByteArray::number(QRandomGenerator::global()->generate(), 16);
+        if (symlink(targetName.constData(), temporary.constData()) != 0) {
+            if (errno == EEXIST) {
+                continue;
+            }
+            break;
+        }
+        if (rename(temporary.constData(), linkName.constData()) != 0) {
+            unlink(temporary.constData());
+            break;
+        }
+        return Installed;
+    }
+
+    qCDebug(USER_MANAGER_LOG) << "Linking" << linkPath << "to" << target << "failed:" << strerror(errno);
+    return Failed;
+}
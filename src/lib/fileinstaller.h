@@ -0,0 +1,47 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#ifndef FILE_INSTALLER_H
+#define FILE_INSTALLER_H
+
+#include <QString>
+
+/**
+ * Puts local files in place without ever leaving a half written one behind.
+ *
+ * The data is shared with a FICLONE reflink where the filesystem can, copied in
+ * the kernel with copy_file_range() otherwise and only read and written as a last
+ * resort. Everything lands in a temporary file renamed over the destination.
+ */
+class FileInstaller
+{
+    public:
+        enum Result {
+            Failed,
+            Unchanged,
+            Installed
+        };
+
+        /* Unchanged when destination already has the same content */
+        static Result install(const QString &source, const QString &destination, int mode = 0644);
+
+        /* Points the symbolic link at target, replacing whatever is there */
+        static Result link(const QString &target, const QString &linkPath);
+};
+
+#endif //FILE_INSTALLER_H
@@ -0,0 +1,190 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "groupindex.h"
+#include "user_manager_debug.h"
+
+#include <QFile>
+#include <QFileSystemWatcher>
+#include <QSet>
+
+#include <grp.h>
+#include <pwd.h>
+#include <unistd.h>
+
+GroupIndex::GroupIndex(QObject* parent)
+ : GroupIndex(QStringLiteral("/etc/group"), parent)
+{
+}
+
+GroupIndex::GroupIndex(const QString& path, QObject* parent)
+ : QObject(parent)
+ , m_path(path)
+ , m_watcher(new QFileSystemWatcher(this))
+{
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, &GroupIndex::fileChanged);
+    m_watcher->addPath(m_path);
+
+    reload();
+}
+
+GroupIndex::~GroupIndex()
+{
+}
+
+QStringList GroupIndex::groupsOf(const QString& username) const
+{
+    QStringList groups = m_userGroups.value(username);
+    const QString primary = primaryGroupOf(username);
+    if (!primary.isEmpty()) {
+        // Listing the user as a member of their own primary group is allowed too
+        groups.removeOne(primary);
+        groups.prepend(primary);
+    }
+    return groups;
+}
+
+QString GroupIndex::primaryGroupOf(const QString& username) const
+{
+    if (username.isEmpty()) {
+        return QString();
+    }
+
+    auto gid = m_primaryGids.constFind(username);
+    if (gid == m_primaryGids.constEnd()) {
+        long bufferSize = sysconf(_SC_GETPW_R_SIZE_MAX);
+        QByteArray buffer(bufferSize > 0 ? bufferSize : 16384, Qt::Uninitialized);
+        struct passwd pw;
+        struct passwd *result = nullptr;
+        if (getpwnam_r(QFile::encodeName(username).constData(), &pw, buffer.data(), buffer.size(), &result) != 0 || !result) {
+            return QString();
+        }
+        gid = m_primaryGids.insert(username, pw.pw_gid);
+    }
+
+    const auto name = m_gidNames.constFind(gid.value());
+    if (name != m_gidNames.constEnd()) {
+        return name.value();
+    }
+
+    // A primary group from another NSS source, LDAP for instance
+    long bufferSize = sysconf(_SC_GETGR_R_SIZE_MAX);
+    QByteArray buffer(bufferSize > 0 ? bufferSize : 16384, Qt::Uninitialized);
+    struct group gr;
+    struct group *result = nullptr;
+    if (getgrgid_r(gid.value(), &gr, buffer.data(), buffer.size(), &result) != 0 || !result) {
+        return QString::number(gid.value());
+    }
+    return QString::fromLocal8Bit(gr.gr_name);
+}
+
+QStringList GroupIndex::membersOf(const QString& group) const
+{
+    return m_groups.value(group).members;
+}
+
+bool GroupIndex::contains(const QString& group) const
+{
+    return m_groups.contains(group);
+}
+
+QStringList GroupIndex::groups() const
+{
+    QStringList names = m_groups.keys();
+    names.sort();
+    return names;
+}
+
+void GroupIndex::fileChanged(const QString& path)
+{
+    // groupadd, usermod and friends replace the file, so the watch is gone with the old one
+    if (!m_watcher->files().contains(path) && QFile::exists(path)) {
+        m_watcher->addPath(path);
+    }
+
+    reload();
+}
+
+void GroupIndex::reload()
+{
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(USER_MANAGER_LOG) << "Could not read" << m_path << file.errorString();
+        return;
+    }
+
+    // name:password:gid:member,member,...
+    QHash<QString, Group> groups;
+    QHash<uint, QString> gidNames;
+    QHash<QString, QStringList> userGroups;
+    const QByteArray content = file.readAll();
+    for (const QByteArray &line : content.split('\n')) {
+        if (line.isEmpty() || line.startsWith('#') || line.startsWith('+') || line.startsWith('-')) {
+            continue;
+        }
+
+        const QList<QByteArray> fields = line.split(':');
+        if (fields.count() < 4) {
+            continue;
+        }
+
+        const QString name = QString::fromLocal8Bit(fields.at(0));
+        Group &group = groups[name];
+        group.gid = fields.at(2).toUInt();
+        gidNames.insert(group.gid, name);
+
+        // Large LDAP-synced groups can list thousands of members
+        QSet<QString> members;
+        for (const QByteArray &member : fields.at(3).split(',')) {
+            const QString username = QString::fromLocal8Bit(member.trimmed());
+            if (!username.isEmpty() && !members.contains(username)) {
+                members.insert(username);
+                group.members.append(username);
+                userGroups[username].append(name);
+            }
+        }
+    }
+
+    for (QStringList &names : userGroups) {
+        names.sort();
+    }
+
+    // Only who gained or lost a group is worth a notification
+    QStringList changed;
+    QSet<QString> users;
+    for (auto it = m_userGroups.constBegin(); it != m_userGroups.constEnd(); ++it) {
+        users.insert(it.key());
+    }
+    for (auto it = userGroups.constBegin(); it != userGroups.constEnd(); ++it) {
+        users.insert(it.key());
+    }
+    for (const QString &username : qAsConst(users)) {
+        if (m_userGroups.value(username) != userGroups.value(username)) {
+            changed.append(username);
+        }
+    }
+
+    m_groups = groups;
+    m_gidNames = gidNames;
+    m_userGroups = userGroups;
+    m_primaryGids.clear();
+
+    if (!changed.isEmpty()) {
+        Q_EMIT groupsChanged(changed);
+    }
+}
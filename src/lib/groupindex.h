@@ -0,0 +1,91 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#ifndef GROUP_INDEX_H
+#define GROUP_INDEX_H
+
+#include <QObject>
+#include <QHash>
+#include <QStringList>
+
+class QFileSystemWatcher;
+
+/**
+ * In-memory index of /etc/group in both directions, group to members and user
+ * to groups, so looking up the groups of a user is a hash lookup rather than a
+ * walk over the whole group database.
+ *
+ * The file is parsed directly. When it changes it is parsed again, and only
+ * the users whose memberships actually changed are reported. Groups that only
+ * exist in other NSS sources (LDAP, SSSD) are not part of it.
+ */
+class GroupIndex : public QObject
+{
+    Q_OBJECT
+    public:
+        explicit GroupIndex(QObject* parent = nullptr);
+
+        /**
+         * Indexes @p path instead of /etc/group.
+         */
+        explicit GroupIndex(const QString &path, QObject* parent = nullptr);
+        ~GroupIndex() override;
+
+        /**
+         * The primary group of @p username followed by the supplementary ones,
+         * sorted by name.
+         */
+        QStringList groupsOf(const QString &username) const;
+
+        /**
+         * The group of the gid in the user's passwd entry, empty if there is
+         * no such user.
+         */
+        QString primaryGroupOf(const QString &username) const;
+
+        QStringList membersOf(const QString &group) const;
+        bool contains(const QString &group) const;
+
+        /**
+         * Every group in the file, sorted by name.
+         */
+        QStringList groups() const;
+
+    Q_SIGNALS:
+        void groupsChanged(const QStringList &usernames);
+
+    private Q_SLOTS:
+        void fileChanged(const QString &path);
+
+    private:
+        struct Group {
+            uint gid = 0;
+            QStringList members;
+        };
+
+        void reload();
+
+        QString m_path;
+        QFileSystemWatcher* m_watcher;
+        QHash<QString, Group> m_groups;
+        QHash<uint, QString> m_gidNames;
+        QHash<QString, QStringList> m_userGroups;
+        mutable QHash<QString, uint> m_primaryGids;
+};
+
+#endif //GROUP_INDEX_H
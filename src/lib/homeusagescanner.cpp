@@ -0,0 +1,407 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "homeusagescanner.h"
+#include "user_manager_debug.h"
+
+#include <QFile>
+#include <QFutureWatcher>
+#include <QMutex>
+#include <QSet>
+#include <QThread>
+#include <QWaitCondition>
+#include <QtConcurrent>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// A home is not scanned again when asked for more often than this
+static const int s_rescanInterval = 60;
+
+// Directories kept for later scans of all homes together, about 100 bytes each
+static const int s_maxCachedDirectories = 200000;
+
+struct WorkQueue
+{
+    QMutex mutex;
+    std::deque<QByteArray> directories;
+};
+
+struct HomeUsageScanner::Scan
+{
+    uint uid = 0;
+    QByteArray root;
+    quint32 devMajor = 0;
+    quint32 devMinor = 0;
+    bool unreadable = false;
+
+    // Only read during the walk, what is found goes to cache
+    DirectoryCache previous;
+    QMutex cacheMutex;
+    DirectoryCache cache;
+
+    QMutex linkedMutex;
+    QSet<quint64> linked;
+
+    std::atomic<bool> cancelled{false};
+    std::atomic<qint64> bytes{0};
+    std::atomic<int> pending{0};
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+
+    // Workers with empty queues sleep here until a directory is queued or the walk ends
+    QMutex idleMutex;
+    QWaitCondition idle;
+    std::atomic<int> waiting{0};
+
+    void cancel()
+    {
+        QMutexLocker locker(&idleMutex);
+        cancelled = true;
+        idle.wakeAll();
+    }
+};
+
+typedef HomeUsageScanner::Scan Scan;
+
+static void push(Scan &scan, int worker, const QByteArray &path)
+{
+    ++scan.pending;
+    {
+        WorkQueue &queue = *scan.queues[worker];
+        QMutexLocker locker(&queue.mutex);
+        queue.directories.push_back(path);
+    }
+
+    if (scan.waiting > 0) {
+        QMutexLocker locker(&scan.idleMutex);
+        scan.idle.wakeOne();
+    }
+}
+
+static bool take(Scan &scan, int worker, QByteArray &path)
+{
+    // Depth first on the own queue, the top of the tree is left for the others to steal
+    {
+        WorkQueue &queue = *scan.queues[worker];
+        QMutexLocker locker(&queue.mutex);
+        if (!queue.directories.empty()) {
+            path = queue.directories.back();
+            queue.directories.pop_back();
+            return true;
+        }
+    }
+
+    const int count = scan.queues.size();
+    for (int i = 1; i < count; ++i) {
+        WorkQueue &queue = *scan.queues[(worker + i) % count];
+        QMutexLocker locker(&queue.mutex);
+        if (!queue.directories.empty()) {
+            path = queue.directories.front();
+            queue.directories.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void addLinked(Scan &scan, quint64 inode, qint64 bytes)
+{
+    QMutexLocker locker(&scan.linkedMutex);
+    if (!scan.linked.contains(inode)) {
+        scan.linked.insert(inode);
+        scan.bytes += bytes;
+    }
+}
+
+static void scanDirectory(Scan &scan, int worker, const QByteArray &path)
+{
+    struct statx st;
+    if (statx(AT_FDCWD, path.constData(), AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT, STATX_TYPE | STATX_MTIME | STATX_BLOCKS, &st) != 0) {
+        return;
+    }
+
+    // Like du -x, other file systems mounted below the home are not part of it
+    if (st.stx_dev_major != scan.devMajor || st.stx_dev_minor != scan.devMinor || !S_ISDIR(st.stx_mode)) {
+        return;
+    }
+
+    const qint64 mtime = qint64(st.stx_mtime.tv_sec) * 1000000000 + st.stx_mtime.tv_nsec;
+
+    HomeUsageScanner::Directory directory;
+    const auto cached = scan.previous.constFind(path);
+    if (cached != scan.previous.constEnd() && cached.value().mtime == mtime) {
+        directory = cached.value();
+    } else {
+        directory.mtime = mtime;
+        directory.bytes = qint64(st.stx_blocks) * 512;
+
+        const int fd = open(path.constData(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        DIR *dir = fd < 0 ? nullptr : fdopendir(fd);
+        if (!dir) {
+            if (fd >= 0) {
+                close(fd);
+            }
+            if (path == scan.root) {
+                scan.unreadable = true;
+            }
+            scan.bytes += directory.bytes;
+            return;
+        }
+
+        while (const dirent *entry = readdir(dir)) {
+            if (scan.cancelled) {
+                closedir(dir);
+                return;
+            }
+
+            if (qstrcmp(entry->d_name, ".") == 0 || qstrcmp(entry->d_name, "..") == 0) {
+                continue;
+            }
+
+            struct statx entrySt;
+            if (statx(fd, entry->d_name, AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT,
+                      STATX_TYPE | STATX_BLOCKS | STATX_INO | STATX_NLINK, &entrySt) != 0) {
+                continue;
+            }
+
+            if (S_ISDIR(entrySt.stx_mode)) {
+                directory.subdirectories.append(QByteArray(entry->d_name));
+                continue;
+            }
+
+            const qint64 bytes = qint64(entrySt.stx_blocks) * 512;
+            if (entrySt.stx_nlink > 1) {
+                directory.linked.append(qMakePair(quint64(entrySt.stx_ino), bytes));
+            } else {
+                directory.bytes += bytes;
+            }
+        }
+        closedir(dir);
+    }
+
+    scan.bytes += directory.bytes;
+    for (const auto &linked : qAsConst(directory.linked)) {
+        addLinked(scan, linked.first, linked.second);
+    }
+    for (const QByteArray &name : qAsConst(directory.subdirectories)) {
+        push(scan, worker, path + '/' + name);
+    }
+
+    QMutexLocker locker(&scan.cacheMutex);
+    scan.cache.insert(path, directory);
+}
+
+static void work(Scan &scan, int worker)
+{
+    QByteArray path;
+    while (!scan.cancelled) {
+        if (!take(scan, worker, path)) {
+            QMutexLocker locker(&scan.idleMutex);
+            if (scan.pending == 0 || scan.cancelled) {
+                return;
+            }
+
+            // Someone is still reading a directory and may come up with more. Looking
+            // again once counted as waiting, push() cannot miss to wake us.
+            ++scan.waiting;
+            const bool found = take(scan, worker, path);
+            if (!found) {
+                scan.idle.wait(&scan.idleMutex);
+            }
+            --scan.waiting;
+            if (!found) {
+                continue;
+            }
+        }
+
+        scanDirectory(scan, worker, path);
+        if (--scan.pending == 0) {
+            QMutexLocker locker(&scan.idleMutex);
+            scan.idle.wakeAll();
+        }
+    }
+}
+
+static qint64 runScan(QSharedPointer<Scan> scan, QThreadPool *pool)
+{
+    struct statx st;
+    if (statx(AT_FDCWD, scan->root.constData(), AT_NO_AUTOMOUNT, STATX_TYPE, &st) != 0 || !S_ISDIR(st.stx_mode)) {
+        return -1;
+    }
+    scan->devMajor = st.stx_dev_major;
+    scan->devMinor = st.stx_dev_minor;
+
+    push(*scan, 0, scan->root);
+
+    QList<QFuture<void>> helpers;
+    for (int worker = 1; worker < int(scan->queues.size()); ++worker) {
+        helpers.append(QtConcurrent::run(pool, [scan, worker]() {
+            work(*scan, worker);
+        }));
+    }
+    work(*scan, 0);
+    for (QFuture<void> &helper : helpers) {
+        helper.waitForFinished();
+    }
+
+    if (scan->cancelled || scan->unreadable) {
+        return -1;
+    }
+    return scan->bytes;
+}
+
+HomeUsageScanner::HomeUsageScanner(QObject* parent)
+ : QObject(parent)
+ , m_watcher(new QFutureWatcher<qint64>(this))
+ , m_rescanInterval(s_rescanInterval)
+{
+    // The walk mostly waits for the disk, a few more threads than cores keep it busy
+    m_pool.setMaxThreadCount(qMax(2, QThread::idealThreadCount()));
+    connect(m_watcher, &QFutureWatcherBase::finished, this, &HomeUsageScanner::scanFinished);
+}
+
+HomeUsageScanner::~HomeUsageScanner()
+{
+    cancelAll();
+    m_pool.waitForDone();
+}
+
+void HomeUsageScanner::setWanted(const QHash<uint, QString>& homes)
+{
+    m_wanted = homes;
+
+    if (m_scan && !homes.contains(m_scan->uid)) {
+        m_scan->cancel();
+    }
+
+    m_queue.clear();
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    for (auto it = homes.constBegin(); it != homes.constEnd(); ++it) {
+        if (m_scan && m_scan->uid == it.key() && !m_scan->cancelled) {
+            continue;
+        }
+        const auto result = m_results.constFind(it.key());
+        if (result == m_results.constEnd() || result.value().scanned.secsTo(now) >= m_rescanInterval) {
+            m_queue.append(it.key());
+        }
+    }
+
+    startNext();
+}
+
+qint64 HomeUsageScanner::usage(uint uid) const
+{
+    return m_results.value(uid).bytes;
+}
+
+void HomeUsageScanner::setRescanInterval(int seconds)
+{
+    m_rescanInterval = seconds;
+}
+
+int HomeUsageScanner::rescanInterval() const
+{
+    return m_rescanInterval;
+}
+
+void HomeUsageScanner::cancelAll()
+{
+    m_wanted.clear();
+    m_queue.clear();
+    if (m_scan) {
+        m_scan->cancel();
+    }
+}
+
+void HomeUsageScanner::startNext()
+{
+    if (m_scan) {
+        return;
+    }
+
+    while (!m_queue.isEmpty()) {
+        const uint uid = m_queue.takeFirst();
+        const QString home = m_wanted.value(uid);
+        if (home.isEmpty()) {
+            continue;
+        }
+
+        m_scan.reset(new Scan);
+        m_scan->uid = uid;
+        m_scan->root = QFile::encodeName(home);
+        m_scan->previous = m_caches.take(m_scan->root);
+        m_cachedDirectories -= m_scan->previous.count();
+        m_cacheOrder.removeOne(m_scan->root);
+        for (int i = 0; i < m_pool.maxThreadCount(); ++i) {
+            m_scan->queues.emplace_back(new WorkQueue);
+        }
+
+        m_watcher->setFuture(QtConcurrent::run(&m_pool, runScan, m_scan, &m_pool));
+        return;
+    }
+}
+
+void HomeUsageScanner::scanFinished()
+{
+    const QSharedPointer<Scan> scan = m_scan;
+    m_scan.reset();
+
+    const qint64 bytes = m_watcher->result();
+    if (!scan->cancelled && bytes >= 0) {
+        cache(scan->root, scan->cache);
+        Result &result = m_results[scan->uid];
+        result.bytes = bytes;
+        result.scanned = QDateTime::currentDateTimeUtc();
+        qCDebug(USER_MANAGER_LOG) << "Home of" << scan->uid << "uses" << bytes << "bytes";
+        Q_EMIT usageReady(scan->uid, bytes);
+    } else {
+        // What the interrupted walk did not get to is still good for the next one
+        cache(scan->root, scan->previous);
+        if (scan->unreadable) {
+            // Not ours to read, no point in trying again and again
+            m_results[scan->uid].scanned = QDateTime::currentDateTimeUtc();
+        }
+    }
+
+    startNext();
+}
+
+void HomeUsageScanner::cache(const QByteArray &root, const DirectoryCache &directories)
+{
+    if (directories.isEmpty()) {
+        return;
+    }
+
+    m_caches.insert(root, directories);
+    m_cacheOrder.append(root);
+    m_cachedDirectories += directories.count();
+
+    // The homes scanned longest ago go first, the one just scanned is always kept
+    while (m_cachedDirectories > s_maxCachedDirectories && m_cacheOrder.count() > 1) {
+        const QByteArray oldest = m_cacheOrder.takeFirst();
+        m_cachedDirectories -= m_caches.take(oldest).count();
+    }
+}
@@ -0,0 +1,111 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#ifndef HOME_USAGE_SCANNER_H
+#define HOME_USAGE_SCANNER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QVector>
+
+template<typename T> class QFutureWatcher;
+
+/**
+ * Computes the disk usage of home directories, one at a time, each walked by
+ * several threads which steal directories from each other's queues.
+ *
+ * Files with several hard links are only counted once. The walk does not cross
+ * file systems. What each directory contributed is cached with its mtime: a later
+ * scan only reads directories whose entries changed, so files that merely grew in
+ * place are noticed once their directory changes too.
+ */
+class HomeUsageScanner : public QObject
+{
+    Q_OBJECT
+    public:
+        explicit HomeUsageScanner(QObject* parent = nullptr);
+        ~HomeUsageScanner() override;
+
+        /**
+         * The homes worth scanning now, normally the visible rows. Queued or
+         * running scans of users not in @p homes are cancelled.
+         */
+        void setWanted(const QHash<uint, QString> &homes);
+
+        /**
+         * Bytes used by the home of @p uid, -1 until it was scanned.
+         */
+        qint64 usage(uint uid) const;
+
+        /**
+         * A home scanned less than @p seconds ago is not scanned again, 60 by default.
+         */
+        void setRescanInterval(int seconds);
+        int rescanInterval() const;
+
+        void cancelAll();
+
+        /**
+         * What a directory contributed to the last scan, valid as long as its mtime is.
+         * Files with several links are kept apart as (inode, bytes) so they can still be
+         * deduplicated against the rest of the tree.
+         */
+        struct Directory {
+            qint64 mtime = 0;
+            qint64 bytes = 0;
+            QVector<QPair<quint64, qint64>> linked;
+            QList<QByteArray> subdirectories;
+        };
+        typedef QHash<QByteArray, Directory> DirectoryCache;
+
+        struct Scan;
+
+    Q_SIGNALS:
+        void usageReady(uint uid, qint64 bytes);
+
+    private Q_SLOTS:
+        void scanFinished();
+
+    private:
+        void startNext();
+        void cache(const QByteArray &root, const DirectoryCache &directories);
+
+        struct Result {
+            qint64 bytes = -1;
+            QDateTime scanned;
+        };
+
+        QThreadPool m_pool;
+        QList<uint> m_queue;
+        QHash<uint, QString> m_wanted;
+        QHash<uint, Result> m_results;
+        QSharedPointer<Scan> m_scan;
+        QFutureWatcher<qint64>* m_watcher;
+        QHash<QByteArray, DirectoryCache> m_caches;
+        /* Roots of m_caches, least recently scanned first */
+        QList<QByteArray> m_cacheOrder;
+        int m_cachedDirectories = 0;
+        int m_rescanInterval;
+};
+
+#endif //HOME_USAGE_SCANNER_H
@@ -0,0 +1,236 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "lastloginindex.h"
+#include "user_manager_debug.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QtConcurrent>
+
+#include <cstring>
+#include <fcntl.h>
+#include <paths.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utmp.h>
+
+static LastLoginIndex::WtmpScan scanWtmpFile(const QString &path, qint64 from, quint64 inode)
+{
+    LastLoginIndex::WtmpScan scan;
+
+    const int fd = open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return scan;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return scan;
+    }
+
+    // Rotated or truncated, everything we know is gone with the old file
+    if (quint64(st.st_ino) != inode || st.st_size < from) {
+        from = 0;
+        scan.rebuilt = true;
+    }
+    scan.inode = st.st_ino;
+
+    // A record still being written is picked up next time
+    const qint64 size = st.st_size - st.st_size % sizeof(utmp);
+    scan.size = qMax(from, size);
+    if (size <= from) {
+        close(fd);
+        return scan;
+    }
+
+    const qint64 pageSize = sysconf(_SC_PAGESIZE);
+    const qint64 mapStart = from - from % pageSize;
+    const size_t mapSize = size - mapStart;
+    void *map = mmap(nullptr, mapSize, PROT_READ, MAP_PRIVATE, fd, mapStart);
+    close(fd);
+    if (map == MAP_FAILED) {
+        qCWarning(USER_MANAGER_LOG) << "Could not map" << path << strerror(errno);
+        scan.size = from;
+        return scan;
+    }
+
+    // Newest first, so the first login seen of a user is the one we want
+    const char *base = static_cast<const char*>(map) + (from - mapStart);
+    const utmp *first = reinterpret_cast<const utmp*>(base);
+    for (const utmp *record = first + (size - from) / sizeof(utmp); record-- != first;) {
+        if (record->ut_type != USER_PROCESS || record->ut_user[0] == '\0') {
+            continue;
+        }
+
+        const QByteArray user(record->ut_user, strnlen(record->ut_user, sizeof(record->ut_user)));
+        if (!scan.logins.contains(user)) {
+            scan.logins.insert(user, record->ut_tv.tv_sec);
+        }
+    }
+
+    munmap(map, mapSize);
+    return scan;
+}
+
+LastLoginIndex::LastLoginIndex(QObject* parent)
+ : LastLoginIndex(QStringLiteral(_PATH_LASTLOG), QStringLiteral(_PATH_WTMP), parent)
+{
+}
+
+LastLoginIndex::LastLoginIndex(const QString &lastlogPath, const QString &wtmpPath, QObject* parent)
+ : QObject(parent)
+ , m_lastlogPath(lastlogPath)
+ , m_wtmpPath(wtmpPath)
+ , m_scanWatcher(new QFutureWatcher<WtmpScan>(this))
+ , m_fileWatcher(new QFileSystemWatcher(this))
+{
+    connect(m_scanWatcher, &QFutureWatcherBase::finished, this, &LastLoginIndex::wtmpScanned);
+    connect(m_fileWatcher, &QFileSystemWatcher::fileChanged, this, &LastLoginIndex::fileChanged);
+    connect(m_fileWatcher, &QFileSystemWatcher::directoryChanged, this, &LastLoginIndex::directoryChanged);
+
+    // The directories tell when a file missing for a moment, or from the start, shows up
+    for (const QString &path : {m_lastlogPath, m_wtmpPath}) {
+        if (QFile::exists(path)) {
+            m_fileWatcher->addPath(path);
+        }
+        const QString directory = QFileInfo(path).absolutePath();
+        if (!m_fileWatcher->directories().contains(directory)) {
+            m_fileWatcher->addPath(directory);
+        }
+    }
+
+    scanWtmp();
+}
+
+LastLoginIndex::~LastLoginIndex()
+{
+    m_scanWatcher->waitForFinished();
+    if (m_lastlogFd >= 0) {
+        close(m_lastlogFd);
+    }
+}
+
+bool LastLoginIndex::isReady() const
+{
+    return m_ready;
+}
+
+QDateTime LastLoginIndex::lastLogin(uint uid, const QString& username) const
+{
+    const qint64 time = qMax(lastlogTime(uid), m_wtmp.value(username.toLocal8Bit(), 0));
+    if (time <= 0) {
+        return QDateTime();
+    }
+    return QDateTime::fromSecsSinceEpoch(time);
+}
+
+qint64 LastLoginIndex::lastlogTime(uint uid) const
+{
+    const auto cached = m_lastlog.constFind(uid);
+    if (cached != m_lastlog.constEnd()) {
+        return cached.value();
+    }
+
+    if (m_lastlogFd < 0) {
+        m_lastlogFd = open(QFile::encodeName(m_lastlogPath).constData(), O_RDONLY | O_CLOEXEC);
+    }
+
+    // Users who never logged in fall into a hole of the file, which reads as zeroes
+    qint64 time = 0;
+    struct lastlog entry;
+    if (m_lastlogFd >= 0 && pread(m_lastlogFd, &entry, sizeof(entry), off_t(uid) * sizeof(entry)) == sizeof(entry)) {
+        time = entry.ll_time;
+    }
+
+    m_lastlog.insert(uid, time);
+    return time;
+}
+
+void LastLoginIndex::scanWtmp()
+{
+    if (m_scanWatcher->isRunning()) {
+        m_rescan = true;
+        return;
+    }
+
+    m_scanWatcher->setFuture(QtConcurrent::run(scanWtmpFile, m_wtmpPath, m_wtmpSize, m_wtmpInode));
+}
+
+void LastLoginIndex::wtmpScanned()
+{
+    const WtmpScan scan = m_scanWatcher->result();
+    if (scan.rebuilt) {
+        m_wtmp = scan.logins;
+    } else {
+        for (auto it = scan.logins.constBegin(); it != scan.logins.constEnd(); ++it) {
+            qint64 &time = m_wtmp[it.key()];
+            time = qMax(time, it.value());
+        }
+    }
+    m_wtmpSize = scan.size;
+    m_wtmpInode = scan.inode;
+
+    const bool wasReady = m_ready;
+    m_ready = true;
+    if (!wasReady || !scan.logins.isEmpty() || scan.rebuilt) {
+        Q_EMIT changed();
+    }
+
+    if (m_rescan) {
+        m_rescan = false;
+        scanWtmp();
+    }
+}
+
+void LastLoginIndex::directoryChanged(const QString& directory)
+{
+    Q_UNUSED(directory)
+
+    // /var/log changes all the time, only a file of ours which lost its watch matters
+    const QStringList watched = m_fileWatcher->files();
+    for (const QString &path : {m_lastlogPath, m_wtmpPath}) {
+        if (!watched.contains(path) && QFile::exists(path)) {
+            fileChanged(path);
+        }
+    }
+}
+
+void LastLoginIndex::fileChanged(const QString& path)
+{
+    // Rotation replaces the file, the watch has to follow the new one
+    if (!m_fileWatcher->files().contains(path) && QFile::exists(path)) {
+        m_fileWatcher->addPath(path);
+    }
+
+    if (path == m_wtmpPath) {
+        scanWtmp();
+        return;
+    }
+
+    if (m_lastlogFd >= 0) {
+        close(m_lastlogFd);
+        m_lastlogFd = -1;
+    }
+    m_lastlog.clear();
+    Q_EMIT changed();
+}
@@ -0,0 +1,90 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#ifndef LAST_LOGIN_INDEX_H
+#define LAST_LOGIN_INDEX_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+
+class QFileSystemWatcher;
+template<typename T> class QFutureWatcher;
+
+/**
+ * When users last logged in, read straight from lastlog and wtmp.
+ *
+ * lastlog is a sparse file indexed by uid, a lookup is a single pread(). wtmp is
+ * mapped and scanned backwards once on a worker thread, which keeps the latest
+ * login of every user name. Afterwards only what was appended to it is scanned,
+ * unless it was rotated.
+ */
+class LastLoginIndex : public QObject
+{
+    Q_OBJECT
+    public:
+        explicit LastLoginIndex(QObject* parent = nullptr);
+
+        /**
+         * Reads the given files instead of the system's lastlog and wtmp.
+         */
+        LastLoginIndex(const QString &lastlogPath, const QString &wtmpPath, QObject* parent = nullptr);
+        ~LastLoginIndex() override;
+
+        /**
+         * The latest login found in either file, invalid when there is none
+         * or wtmp is still being indexed.
+         */
+        QDateTime lastLogin(uint uid, const QString &username) const;
+        bool isReady() const;
+
+        struct WtmpScan {
+            QHash<QByteArray, qint64> logins;
+            qint64 size = 0;
+            quint64 inode = 0;
+            bool rebuilt = false;
+        };
+
+    Q_SIGNALS:
+        void changed();
+
+    private Q_SLOTS:
+        void fileChanged(const QString &path);
+        void directoryChanged(const QString &directory);
+        void wtmpScanned();
+
+    private:
+        void scanWtmp();
+        qint64 lastlogTime(uint uid) const;
+
+        QString m_lastlogPath;
+        QString m_wtmpPath;
+        mutable int m_lastlogFd = -1;
+        mutable QHash<uint, qint64> m_lastlog;
+
+        bool m_ready = false;
+        bool m_rescan = false;
+        qint64 m_wtmpSize = 0;
+        quint64 m_wtmpInode = 0;
+        QHash<QByteArray, qint64> m_wtmp;
+        QFutureWatcher<WtmpScan>* m_scanWatcher;
+        QFileSystemWatcher* m_fileWatcher;
+};
+
+#endif //LAST_LOGIN_INDEX_H
@@ -0,0 +1,42 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "startuptrace.h"
+#include "user_manager_debug.h"
+
+#include <QElapsedTimer>
+
+static QElapsedTimer s_timer;
+static qint64 s_lastMark = 0;
+
+void StartupTrace::start()
+{
+    s_timer.start();
+    s_lastMark = 0;
+}
+
+void StartupTrace::mark(const char* phase)
+{
+    if (!s_timer.isValid()) {
+        return;
+    }
+
+    const qint64 elapsed = s_timer.elapsed();
+    qCDebug(USER_MANAGER_LOG).nospace() << "startup: " << phase << " at " << elapsed << " ms (+" << elapsed - s_lastMark << " ms)";
+    s_lastMark = elapsed;
+}
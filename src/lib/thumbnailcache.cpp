@@ -0,0 +1,127 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "thumbnailcache.h"
+#include "areascaler.h"
+#include "user_manager_debug.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QUrl>
+#include <QtConcurrent>
+
+static const int s_normalSize = 128;
+static const int s_largeSize = 256;
+
+static QString fileUri(const QString &path)
+{
+    return QUrl::fromLocalFile(QFileInfo(path).absoluteFilePath()).toString(QUrl::FullyEncoded);
+}
+
+static QString fileMTime(const QFileInfo &info)
+{
+    return QString::number(info.lastModified().toSecsSinceEpoch());
+}
+
+int ThumbnailCache::flavorSize(int size)
+{
+    if (size <= s_normalSize) {
+        return s_normalSize;
+    }
+    if (size <= s_largeSize) {
+        return s_largeSize;
+    }
+
+    return 0;
+}
+
+QString ThumbnailCache::thumbnailPath(const QString &uri, int flavorSize)
+{
+    const QByteArray hash = QCryptographicHash::hash(uri.toUtf8(), QCryptographicHash::Md5).toHex();
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+        + (flavorSize == s_normalSize ? QStringLiteral("/thumbnails/normal/") : QStringLiteral("/thumbnails/large/"))
+        + QString::fromLatin1(hash) + QStringLiteral(".png");
+}
+
+QImage ThumbnailCache::find(const QString &path, int size)
+{
+    const int flavor = flavorSize(size);
+    const QFileInfo info(path);
+    if (!flavor || !info.exists()) {
+        return QImage();
+    }
+
+    const QString uri = fileUri(path);
+    QImageReader reader(thumbnailPath(uri, flavor), "png");
+
+    // The text chunks come with the header, a stale thumbnail is never decoded
+    if (reader.text(QStringLiteral("Thumb::URI")) != uri
+        || reader.text(QStringLiteral("Thumb::MTime")) != fileMTime(info)) {
+        return QImage();
+    }
+
+    return reader.read();
+}
+
+void ThumbnailCache::store(const QString &path, const QImage &image, int size)
+{
+    const int flavor = flavorSize(size);
+    if (!flavor || image.isNull()) {
+        return;
+    }
+
+    QtConcurrent::run(&ThumbnailCache::write, path, image, flavor);
+}
+
+void ThumbnailCache::write(const QString &path, const QImage &image, int flavorSize)
+{
+    const QFileInfo info(path);
+    const QString uri = fileUri(path);
+    const QString thumbnail = thumbnailPath(uri, flavorSize);
+
+    // The specification wants the cache private to the user
+    const QString directory = QFileInfo(thumbnail).absolutePath();
+    if (!QDir().mkpath(directory)) {
+        return;
+    }
+    QFile::setPermissions(directory, QFileDevice::ReadOwner | QFileDevice::WriteOwner | QFileDevice::ExeOwner);
+
+    // Thumbnails are never larger than the original
+    QImage scaled = qMax(image.width(), image.height()) > flavorSize ? AreaScaler::scaledToFit(image, flavorSize) : image;
+    scaled.setText(QStringLiteral("Thumb::URI"), uri);
+    scaled.setText(QStringLiteral("Thumb::MTime"), fileMTime(info));
+    scaled.setText(QStringLiteral("Thumb::Size"), QString::number(info.size()));
+    scaled.setText(QStringLiteral("Software"), QStringLiteral("user_manager"));
+
+    // Written aside and renamed, readers never see half a thumbnail
+    QSaveFile file(thumbnail);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+
+    QImageWriter writer(&file, "png");
+    if (!writer.write(scaled) || !file.commit()) {
+        qCDebug(USER_MANAGER_LOG) << "Storing thumbnail of" << path << "failed:" << writer.errorString() << file.errorString();
+    }
+}
@@ -0,0 +1,48 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#ifndef THUMBNAIL_CACHE_H
+#define THUMBNAIL_CACHE_H
+
+#include <QImage>
+#include <QString>
+
+/**
+ * Face thumbnails in the freedesktop.org thumbnail cache, ~/.cache/thumbnails,
+ * shared with file managers and everything else following the specification.
+ *
+ * A thumbnail is only used when its Thumb::URI and Thumb::MTime still match the
+ * file. Sizes up to 128 px come from "normal", up to 256 px from "large"; larger
+ * faces are not cached.
+ */
+class ThumbnailCache
+{
+    public:
+        /* A valid thumbnail of at least size pixels, or a null image */
+        static QImage find(const QString &path, int size);
+
+        /* Scales image, decoded from path, and stores it on a worker thread */
+        static void store(const QString &path, const QImage &image, int size);
+
+    private:
+        static int flavorSize(int size);
+        static QString thumbnailPath(const QString &uri, int flavorSize);
+        static void write(const QString &path, const QImage &image, int flavorSize);
+};
+
+#endif //THUMBNAIL_CACHE_H
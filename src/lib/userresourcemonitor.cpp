@@ -0,0 +1,262 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "userresourcemonitor.h"
+#include "user_manager_debug.h"
+
+#include <QFile>
+#include <QTimer>
+
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+static const int s_defaultInterval = 2000;
+
+// Coarse timers may fire up to 5% early, which still counts as a full interval
+static const int s_minimumIntervalPercent = 90;
+
+// Big enough for cpu.stat, which has a handful of "key value" lines
+static const int s_bufferSize = 512;
+
+static qint64 readValue(int fd, const char *key)
+{
+    char buffer[s_bufferSize];
+    const ssize_t size = pread(fd, buffer, sizeof(buffer) - 1, 0);
+    if (size <= 0) {
+        return -1;
+    }
+    buffer[size] = '\0';
+
+    const char *value = buffer;
+    if (key) {
+        const size_t keyLength = qstrlen(key);
+        const char *line = buffer;
+        value = nullptr;
+        while (line && *line) {
+            if (qstrncmp(line, key, keyLength) == 0 && line[keyLength] == ' ') {
+                value = line + keyLength + 1;
+                break;
+            }
+            line = strchr(line, '\n');
+            if (line) {
+                ++line;
+            }
+        }
+        if (!value) {
+            return -1;
+        }
+    }
+
+    // memory.current says "max" for the root only, anything else is a number
+    char *end = nullptr;
+    const qint64 result = strtoll(value, &end, 10);
+    return end == value ? -1 : result;
+}
+
+UserResourceMonitor::UserResourceMonitor(QObject* parent)
+ : QObject(parent)
+ , m_timer(new QTimer(this))
+{
+    m_timer->setInterval(s_defaultInterval);
+    connect(m_timer, &QTimer::timeout, this, &UserResourceMonitor::sample);
+    m_clock.start();
+
+    setRootPath(QStringLiteral("/sys/fs/cgroup/user.slice"));
+}
+
+UserResourceMonitor::~UserResourceMonitor()
+{
+    closeAll();
+}
+
+void UserResourceMonitor::setRootPath(const QString& path)
+{
+    closeAll();
+    m_rootPath = path;
+
+    m_rootFd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (m_rootFd < 0) {
+        qCDebug(USER_MANAGER_LOG) << "No cgroup user slices in" << path;
+    }
+}
+
+QString UserResourceMonitor::rootPath() const
+{
+    return m_rootPath;
+}
+
+void UserResourceMonitor::setInterval(int msec)
+{
+    m_timer->setInterval(msec);
+}
+
+int UserResourceMonitor::interval() const
+{
+    return m_timer->interval();
+}
+
+void UserResourceMonitor::setWatched(const QList<uint>& uids)
+{
+    // Whoever scrolled out of view is not sampled anymore and gives its descriptors back
+    for (auto it = m_slices.begin(); it != m_slices.end();) {
+        if (!uids.contains(it.key())) {
+            close(it.value());
+            it = m_slices.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    QList<uint> added;
+    for (uint uid : uids) {
+        if (!m_slices.contains(uid)) {
+            m_slices.insert(uid, Slice());
+            added.append(uid);
+        }
+    }
+
+    if (m_slices.isEmpty() || m_rootFd < 0) {
+        m_timer->stop();
+        return;
+    }
+
+    if (!m_timer->isActive()) {
+        m_timer->start();
+    }
+
+    // Newly visible users get their memory and a CPU baseline right away,
+    // the ones already watched keep waiting for the timer
+    const qint64 now = m_clock.nsecsElapsed() / 1000;
+    QList<uint> changed;
+    for (uint uid : qAsConst(added)) {
+        if (sampleSlice(uid, m_slices[uid], now)) {
+            changed.append(uid);
+        }
+    }
+
+    if (!changed.isEmpty()) {
+        Q_EMIT usageChanged(changed);
+    }
+}
+
+qreal UserResourceMonitor::cpuUsage(uint uid) const
+{
+    const auto it = m_slices.constFind(uid);
+    return it == m_slices.constEnd() ? -1 : it.value().cpu;
+}
+
+qint64 UserResourceMonitor::memoryUsage(uint uid) const
+{
+    const auto it = m_slices.constFind(uid);
+    return it == m_slices.constEnd() ? -1 : it.value().memory;
+}
+
+bool UserResourceMonitor::open(uint uid, Slice& slice)
+{
+    const QByteArray dir = "user-" + QByteArray::number(uid) + ".slice/";
+    slice.cpuFd = openat(m_rootFd, QByteArray(dir + "cpu.stat").constData(), O_RDONLY | O_CLOEXEC);
+    slice.memoryFd = openat(m_rootFd, QByteArray(dir + "memory.current").constData(), O_RDONLY | O_CLOEXEC);
+
+    return slice.cpuFd >= 0 || slice.memoryFd >= 0;
+}
+
+void UserResourceMonitor::close(Slice& slice)
+{
+    if (slice.cpuFd >= 0) {
+        ::close(slice.cpuFd);
+        slice.cpuFd = -1;
+    }
+    if (slice.memoryFd >= 0) {
+        ::close(slice.memoryFd);
+        slice.memoryFd = -1;
+    }
+}
+
+void UserResourceMonitor::closeAll()
+{
+    for (Slice &slice : m_slices) {
+        close(slice);
+        slice = Slice();
+    }
+
+    if (m_rootFd >= 0) {
+        ::close(m_rootFd);
+        m_rootFd = -1;
+    }
+}
+
+void UserResourceMonitor::sample()
+{
+    if (m_rootFd < 0) {
+        return;
+    }
+
+    const qint64 now = m_clock.nsecsElapsed() / 1000;
+
+    QList<uint> changed;
+    for (auto it = m_slices.begin(); it != m_slices.end(); ++it) {
+        if (sampleSlice(it.key(), it.value(), now)) {
+            changed.append(it.key());
+        }
+    }
+
+    if (!changed.isEmpty()) {
+        Q_EMIT usageChanged(changed);
+    }
+}
+
+bool UserResourceMonitor::sampleSlice(uint uid, Slice& slice, qint64 now)
+{
+    if (slice.cpuFd < 0 && slice.memoryFd < 0 && !open(uid, slice)) {
+        return false;
+    }
+
+    const qint64 cpuUsec = slice.cpuFd >= 0 ? readValue(slice.cpuFd, "usage_usec") : -1;
+    const qint64 memory = slice.memoryFd >= 0 ? readValue(slice.memoryFd, nullptr) : -1;
+
+    // The slice is gone once the user logged out, open it again should they come back
+    if (cpuUsec < 0 && memory < 0) {
+        const bool wasKnown = slice.cpu >= 0 || slice.memory >= 0;
+        close(slice);
+        slice = Slice();
+        return wasKnown;
+    }
+
+    // A user primed just before a tick would otherwise get a figure averaged
+    // over a few milliseconds, keep the baseline until a full interval passed
+    qreal cpu = slice.cpu;
+    if (cpuUsec < 0) {
+        cpu = -1;
+        slice.cpuUsec = -1;
+    } else if (slice.cpuUsec < 0) {
+        slice.cpuUsec = cpuUsec;
+        slice.sampledUsec = now;
+    } else if (now - slice.sampledUsec >= qint64(m_timer->interval()) * 1000 * s_minimumIntervalPercent / 100) {
+        cpu = 100.0 * (cpuUsec - slice.cpuUsec) / (now - slice.sampledUsec);
+        slice.cpuUsec = cpuUsec;
+        slice.sampledUsec = now;
+    }
+
+    // Rounded to what is shown, anything finer would only make the rows flicker
+    const bool changed = qRound(cpu) != qRound(slice.cpu) || memory / 1024 != slice.memory / 1024;
+    slice.cpu = cpu;
+    slice.memory = memory;
+    return changed;
+}
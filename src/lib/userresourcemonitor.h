@@ -0,0 +1,96 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#ifndef USER_RESOURCE_MONITOR_H
+#define USER_RESOURCE_MONITOR_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+
+class QTimer;
+
+/**
+ * Samples CPU and memory usage of logged in users from their systemd
+ * user-<uid>.slice in the unified cgroup hierarchy.
+ *
+ * Only the users set with setWatched() are sampled, normally the logged in
+ * ones among the visible rows. Their cpu.stat and memory.current stay open
+ * while they are watched and are re-read with pread(), so a sample is two
+ * syscalls per user.
+ */
+class UserResourceMonitor : public QObject
+{
+    Q_OBJECT
+    public:
+        explicit UserResourceMonitor(QObject* parent = nullptr);
+        ~UserResourceMonitor() override;
+
+        /**
+         * The directory holding the user-<uid>.slice directories,
+         * /sys/fs/cgroup/user.slice by default.
+         */
+        void setRootPath(const QString &path);
+        QString rootPath() const;
+
+        void setInterval(int msec);
+        int interval() const;
+
+        void setWatched(const QList<uint> &uids);
+
+        /**
+         * CPU usage in percent of one CPU since the previous sample, -1 until
+         * two samples at least an interval apart were taken.
+         */
+        qreal cpuUsage(uint uid) const;
+
+        /**
+         * Memory charged to the user's slice in bytes, -1 when unknown.
+         */
+        qint64 memoryUsage(uint uid) const;
+
+    public Q_SLOTS:
+        void sample();
+
+    Q_SIGNALS:
+        void usageChanged(const QList<uint> &uids);
+
+    private:
+        struct Slice {
+            int cpuFd = -1;
+            int memoryFd = -1;
+            qint64 cpuUsec = -1;
+            qint64 sampledUsec = -1;
+            qreal cpu = -1;
+            qint64 memory = -1;
+        };
+
+        bool sampleSlice(uint uid, Slice &slice, qint64 now);
+        bool open(uint uid, Slice &slice);
+        void close(Slice &slice);
+        void closeAll();
+
+        QString m_rootPath;
+        int m_rootFd = -1;
+        QTimer* m_timer;
+        QElapsedTimer m_clock;
+        QHash<uint, Slice> m_slices;
+};
+
+#endif //USER_RESOURCE_MONITOR_H
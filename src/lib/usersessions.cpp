@@ -19,10 +19,25 @@
 #include "usersessions.h"
 #include "login1_interface.h"
 
+#include <QDBusMessage>
 #include <QDBusPendingReply>
+#include <QDBusServiceWatcher>
+#include <QTimer>
+
+#include <KLocalizedString>
+
+#include <csignal>
 
 #include "user_manager_debug.h"
 
+// Cheap enough to run regularly, it is a single round-trip for the whole table
+// and the states are only fetched for users whose sessions changed
+static const int s_reconcileInterval = 60 * 1000;
+
+// How long logind gets to tear down the sessions of a user, processes ignoring SIGTERM
+// make it wait for the stop timeout of the user's units
+static const int s_endSessionsTimeout = 30 * 1000;
+
 QDBusArgument &operator<<(QDBusArgument &argument, const UserInfo &userInfo)
 {
     argument.beginStructure();
@@ -39,19 +54,61 @@ const QDBusArgument &operator>>(const QDBusArgument &argument, UserInfo &userInf
     return argument;
 }
 
+QDBusArgument &operator<<(QDBusArgument &argument, const SessionInfo &sessionInfo)
+{
+    argument.beginStructure();
+    argument << sessionInfo.id << sessionInfo.uid << sessionInfo.name << sessionInfo.seat << sessionInfo.path;
+    argument.endStructure();
+    return argument;
+}
+
+const QDBusArgument &operator>>(const QDBusArgument &argument, SessionInfo &sessionInfo)
+{
+    argument.beginStructure();
+    argument >> sessionInfo.id >> sessionInfo.uid >> sessionInfo.name >> sessionInfo.seat >> sessionInfo.path;
+    argument.endStructure();
+    return argument;
+}
+
 typedef OrgFreedesktopLogin1ManagerInterface Manager;
 UserSession::UserSession(QObject* parent): QObject(parent)
 {
     qDBusRegisterMetaType<UserInfo>();
     qDBusRegisterMetaType<UserInfoList>();
+    qDBusRegisterMetaType<SessionInfo>();
+    qDBusRegisterMetaType<SessionInfoList>();
 
     m_manager = new Manager(QStringLiteral("org.freedesktop.login1"), QStringLiteral("/org/freedesktop/login1"), QDBusConnection::systemBus());
     connect(m_manager, &OrgFreedesktopLogin1ManagerInterface::UserNew, this, &UserSession::UserNew);
     connect(m_manager, &OrgFreedesktopLogin1ManagerInterface::UserRemoved, this, &UserSession::UserRemoved);
+    connect(m_manager, &OrgFreedesktopLogin1ManagerInterface::SessionNew, this, &UserSession::SessionNew);
+    connect(m_manager, &OrgFreedesktopLogin1ManagerInterface::SessionRemoved, this, &UserSession::SessionRemoved);
+
+    // A user goes from online to active and back when one of their sessions gets
+    // or loses the seat, which is not a login or logout. Listen for the sessions'
+    // Active property rather than polling every user's State
+    QDBusConnection::systemBus().connect(QStringLiteral("org.freedesktop.login1"), QString(),
+                                         QStringLiteral("org.freedesktop.DBus.Properties"),
+                                         QStringLiteral("PropertiesChanged"),
+                                         {QStringLiteral("org.freedesktop.login1.Session")}, QString(),
+                                         this, SLOT(sessionPropertiesChanged(QString,QVariantMap,QStringList,QDBusMessage)));
+
+    // logind can be restarted, anything that happened meanwhile is picked up by reconciling
+    m_serviceWatcher = new QDBusServiceWatcher(QStringLiteral("org.freedesktop.login1"), QDBusConnection::systemBus(),
+                                               QDBusServiceWatcher::WatchForOwnerChange, this);
+    connect(m_serviceWatcher, &QDBusServiceWatcher::serviceOwnerChanged, this, &UserSession::serviceOwnerChanged);
 
-    QDBusPendingReply <UserInfoList> reply = m_manager->ListUsers();
-    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(reply, this);
-    connect(watcher, &QDBusPendingCallWatcher::finished, this, &UserSession::listUsersSlot);
+    m_periodicTimer = new QTimer(this);
+    m_periodicTimer->setInterval(s_reconcileInterval);
+    connect(m_periodicTimer, &QTimer::timeout, this, &UserSession::scheduleReconcile);
+    m_periodicTimer->start();
+
+    m_endTimer = new QTimer(this);
+    m_endTimer->setSingleShot(true);
+    m_endTimer->setInterval(s_endSessionsTimeout);
+    connect(m_endTimer, &QTimer::timeout, this, &UserSession::endSessionsTimedOut);
+
+    scheduleReconcile();
 }
 
 UserSession::~UserSession()
@@ -59,29 +116,301 @@ UserSession::~UserSession()
     delete m_manager;
 }
 
-void UserSession::listUsersSlot(QDBusPendingCallWatcher *watcher)
+bool UserSession::isLogged(uint uid) const
 {
-    QDBusPendingReply<UserInfoList> reply = *watcher;
-    if (reply.isError()) {
-        qCWarning(USER_MANAGER_LOG) << reply.error().name() << reply.error().message();
-    } else {
-        const UserInfoList userList = reply.value();
-        for (const UserInfo &userInfo : userList) {
-            UserNew(userInfo.id);
-        }
+    return m_users.contains(uid);
+}
+
+int UserSession::sessionCount(uint uid) const
+{
+    return m_users.value(uid).count;
+}
+
+QString UserSession::state(uint uid) const
+{
+    return m_users.value(uid).state;
+}
+
+void UserSession::serviceOwnerChanged(const QString &service, const QString &oldOwner, const QString &newOwner)
+{
+    Q_UNUSED(oldOwner)
+    if (newOwner.isEmpty()) {
+        qCWarning(USER_MANAGER_LOG) << service << "went away";
+        return;
     }
 
-    watcher->deleteLater();
+    fullReconcile();
 }
 
 void UserSession::UserNew(uint id)
 {
     qCDebug(USER_MANAGER_LOG) << id;
-    Q_EMIT userLogged(id, true);
+    scheduleReconcile();
 }
 
 void UserSession::UserRemoved(uint id)
 {
     qCDebug(USER_MANAGER_LOG) << id;
-    Q_EMIT userLogged(id, false);
+    scheduleReconcile();
+
+    if (m_ending.remove(id)) {
+        Q_EMIT sessionsEnded(id);
+    }
+}
+
+void UserSession::sessionPropertiesChanged(const QString &interface, const QVariantMap &changed,
+                                           const QStringList &invalidated, const QDBusMessage &message)
+{
+    Q_UNUSED(interface)
+    if (!changed.contains(QStringLiteral("Active")) && !invalidated.contains(QStringLiteral("Active"))) {
+        return;
+    }
+
+    const auto session = m_sessionUsers.constFind(message.path());
+    if (session != m_sessionUsers.constEnd()) {
+        fetchStates({session.value()});
+    }
+}
+
+void UserSession::SessionNew(const QString &id)
+{
+    qCDebug(USER_MANAGER_LOG) << id;
+    scheduleReconcile();
+}
+
+void UserSession::SessionRemoved(const QString &id)
+{
+    qCDebug(USER_MANAGER_LOG) << id;
+    scheduleReconcile();
+}
+
+void UserSession::scheduleReconcile()
+{
+    if (m_reconcileScheduled) {
+        return;
+    }
+
+    m_reconcileScheduled = true;
+    QTimer::singleShot(0, this, &UserSession::reconcile);
+}
+
+void UserSession::fullReconcile()
+{
+    m_fullReconcile = true;
+    scheduleReconcile();
+}
+
+void UserSession::reconcile()
+{
+    m_reconcileScheduled = false;
+
+    // Only one round-trip at a time, whatever happens meanwhile is picked up right after
+    if (m_usersWatcher || m_sessionsWatcher) {
+        m_reconcileAgain = true;
+        return;
+    }
+
+    m_usersWatcher = new QDBusPendingCallWatcher(m_manager->ListUsers(), this);
+    connect(m_usersWatcher, &QDBusPendingCallWatcher::finished, this, &UserSession::replyReceived);
+    m_sessionsWatcher = new QDBusPendingCallWatcher(m_manager->ListSessions(), this);
+    connect(m_sessionsWatcher, &QDBusPendingCallWatcher::finished, this, &UserSession::replyReceived);
+}
+
+void UserSession::replyReceived(QDBusPendingCallWatcher *watcher)
+{
+    Q_UNUSED(watcher)
+    if (!m_usersWatcher->isFinished() || !m_sessionsWatcher->isFinished()) {
+        return;
+    }
+
+    applyReplies();
+
+    m_usersWatcher->deleteLater();
+    m_usersWatcher = nullptr;
+    m_sessionsWatcher->deleteLater();
+    m_sessionsWatcher = nullptr;
+
+    if (m_reconcileAgain) {
+        m_reconcileAgain = false;
+        scheduleReconcile();
+    }
+}
+
+void UserSession::applyReplies()
+{
+    QDBusPendingReply<UserInfoList> usersReply = *m_usersWatcher;
+    QDBusPendingReply<SessionInfoList> sessionsReply = *m_sessionsWatcher;
+    if (usersReply.isError() || sessionsReply.isError()) {
+        const QDBusError error = usersReply.isError() ? usersReply.error() : sessionsReply.error();
+        qCWarning(USER_MANAGER_LOG) << error.name() << error.message();
+        return;
+    }
+
+    QHash<uint, UserSessions> users;
+    const UserInfoList userList = usersReply.value();
+    for (const UserInfo &userInfo : userList) {
+        UserSessions &user = users[userInfo.id];
+        user.path = userInfo.path;
+        user.state = m_users.value(userInfo.id).state;
+    }
+
+    m_sessionUsers.clear();
+    const SessionInfoList sessionList = sessionsReply.value();
+    for (const SessionInfo &sessionInfo : sessionList) {
+        m_sessionUsers.insert(sessionInfo.path.path(), sessionInfo.uid);
+        const auto user = users.find(sessionInfo.uid);
+        if (user != users.end()) {
+            ++user.value().count;
+        }
+    }
+
+    QList<uint> changed;
+    for (auto it = m_users.constBegin(); it != m_users.constEnd(); ++it) {
+        if (!users.contains(it.key())) {
+            changed.append(it.key());
+        }
+    }
+    for (auto it = users.constBegin(); it != users.constEnd(); ++it) {
+        const auto known = m_users.constFind(it.key());
+        if (known == m_users.constEnd() || known.value().count != it.value().count) {
+            changed.append(it.key());
+        }
+    }
+
+    m_users = users;
+    if (!changed.isEmpty()) {
+        Q_EMIT sessionsChanged(changed);
+    }
+
+    checkEnded();
+
+    // The state is only worth asking for when something happened to the user, seat
+    // changes come through sessionPropertiesChanged(). Everyone is asked on the
+    // first run and after logind restarted, its signals may have been missed
+    if (m_fullReconcile) {
+        m_fullReconcile = false;
+        fetchStates(m_users.keys());
+    } else {
+        fetchStates(changed);
+    }
+}
+
+void UserSession::fetchStates(const QList<uint> &uids)
+{
+    for (uint uid : uids) {
+        const auto user = m_users.constFind(uid);
+        if (user == m_users.constEnd() || m_stateUids.contains(uid)) {
+            continue;
+        }
+
+        QDBusMessage message = QDBusMessage::createMethodCall(QStringLiteral("org.freedesktop.login1"),
+                                                              user.value().path.path(),
+                                                              QStringLiteral("org.freedesktop.DBus.Properties"),
+                                                              QStringLiteral("Get"));
+        message << QStringLiteral("org.freedesktop.login1.User") << QStringLiteral("State");
+
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(QDBusConnection::systemBus().asyncCall(message), this);
+        m_stateCalls.insert(watcher, uid);
+        m_stateUids.insert(uid);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, &UserSession::stateReceived);
+    }
+}
+
+void UserSession::stateReceived(QDBusPendingCallWatcher *watcher)
+{
+    const uint uid = m_stateCalls.take(watcher);
+    m_stateUids.remove(uid);
+    watcher->deleteLater();
+
+    QDBusPendingReply<QDBusVariant> reply = *watcher;
+    const auto user = m_users.find(uid);
+    if (!reply.isError() && user != m_users.end()) {
+        const QString state = reply.value().variant().toString();
+        if (user.value().state != state) {
+            user.value().state = state;
+            m_stateChanged.append(uid);
+        }
+    }
+
+    // Report the whole batch at once
+    if (m_stateCalls.isEmpty() && !m_stateChanged.isEmpty()) {
+        Q_EMIT sessionsChanged(m_stateChanged);
+        m_stateChanged.clear();
+    }
+}
+
+bool UserSession::isEnding(uint uid) const
+{
+    return m_ending.contains(uid);
+}
+
+void UserSession::endSessions(const QList<uint> &uids, bool force)
+{
+    for (uint uid : uids) {
+        if (m_ending.contains(uid)) {
+            continue;
+        }
+
+        m_ending.insert(uid);
+        const QDBusPendingCall call = force ? m_manager->KillUser(uid, SIGKILL) : m_manager->TerminateUser(uid);
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, this);
+        m_endCalls.insert(watcher, uid);
+        m_endUids.insert(uid);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, &UserSession::endSessionsFinished);
+    }
+
+    if (!m_ending.isEmpty()) {
+        m_endTimer->start();
+    }
+}
+
+void UserSession::endSessionsFinished(QDBusPendingCallWatcher *watcher)
+{
+    const uint uid = m_endCalls.take(watcher);
+    m_endUids.remove(uid);
+    watcher->deleteLater();
+
+    QDBusPendingReply<> reply = *watcher;
+    if (reply.isError()) {
+        qCWarning(USER_MANAGER_LOG) << uid << reply.error().name() << reply.error().message();
+        if (m_ending.remove(uid)) {
+            Q_EMIT endSessionsFailed(uid, reply.error().message());
+        }
+        return;
+    }
+
+    // Done once UserRemoved arrives, or the next reconciliation no longer sees any session
+    scheduleReconcile();
+}
+
+void UserSession::checkEnded()
+{
+    const QSet<uint> ending = m_ending;
+    for (uint uid : ending) {
+        // Whatever was listed before the call returned says nothing yet
+        if (m_endUids.contains(uid)) {
+            continue;
+        }
+
+        // Lingering users stay around without sessions, that is as logged out as they get
+        const auto user = m_users.constFind(uid);
+        if (user == m_users.constEnd() || user.value().count == 0) {
+            m_ending.remove(uid);
+            Q_EMIT sessionsEnded(uid);
+        }
+    }
+
+    if (m_ending.isEmpty()) {
+        m_endTimer->stop();
+    }
+}
+
+void UserSession::endSessionsTimedOut()
+{
+    const QSet<uint> ending = m_ending;
+    m_ending.clear();
+
+    for (uint uid : ending) {
+        Q_EMIT endSessionsFailed(uid, i18n("The sessions of user %1 did not end in time.", uid));
+    }
 }
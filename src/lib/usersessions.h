@@ -20,7 +20,10 @@
 #define USER_SESSION_H
 
 #include <QObject>
+#include <QHash>
+#include <QSet>
 #include <QDBusObjectPath>
+#include <QVariantMap>
 
 struct UserInfo
 {
@@ -33,8 +36,35 @@ Q_DECLARE_METATYPE(UserInfo)
 typedef QList<UserInfo> UserInfoList;
 Q_DECLARE_METATYPE(UserInfoList)
 
+struct SessionInfo
+{
+    QString id;
+    uint uid;
+    QString name;
+    QString seat;
+    QDBusObjectPath path;
+};
+Q_DECLARE_METATYPE(SessionInfo)
+
+typedef QList<SessionInfo> SessionInfoList;
+Q_DECLARE_METATYPE(SessionInfoList)
+
+class QTimer;
+class QDBusMessage;
 class QDBusPendingCallWatcher;
+class QDBusServiceWatcher;
 class OrgFreedesktopLogin1ManagerInterface;
+
+/**
+ * Per uid table of the logind sessions.
+ *
+ * Login and logout signals only mark the table dirty, it is then reconciled with
+ * one ListUsers/ListSessions round-trip per event loop iteration, so a storm of
+ * hundreds of logins at shift change ends up as a single sessionsChanged().
+ * A periodic reconciliation catches anything the signals missed. The state of a
+ * user is only fetched when their sessions changed or one of them got or lost
+ * its seat.
+ */
 class UserSession : public QObject
 {
     Q_OBJECT
@@ -42,16 +72,79 @@ class UserSession : public QObject
         explicit UserSession(QObject* parent = nullptr);
         virtual ~UserSession();
 
+        bool isLogged(uint uid) const;
+        int sessionCount(uint uid) const;
+
+        /**
+         * logind's aggregated state of the user: "active", "online",
+         * "lingering" or "closing". Empty when the user is not logged in.
+         */
+        QString state(uint uid) const;
+
+        /**
+         * Ends every session of @p uids, through TerminateUser or, with @p force,
+         * KillUser with SIGKILL. The calls are all sent at once, each user is
+         * reported through sessionsEnded() once logind dropped them, or through
+         * endSessionsFailed().
+         */
+        void endSessions(const QList<uint> &uids, bool force = false);
+        bool isEnding(uint uid) const;
+
     public Q_SLOTS:
         void UserNew(uint id);
         void UserRemoved(uint id);
-        void listUsersSlot(QDBusPendingCallWatcher *watcher);
+        void SessionNew(const QString &id);
+        void SessionRemoved(const QString &id);
+        void serviceOwnerChanged(const QString &service, const QString &oldOwner, const QString &newOwner);
 
     Q_SIGNALS:
-        void userLogged(uint id, bool logged);
+        void sessionsChanged(const QList<uint> &uids);
+        void sessionsEnded(uint uid);
+        void endSessionsFailed(uint uid, const QString &message);
+
+    private Q_SLOTS:
+        void reconcile();
+        void fullReconcile();
+        void replyReceived(QDBusPendingCallWatcher *watcher);
+        void stateReceived(QDBusPendingCallWatcher *watcher);
+        void sessionPropertiesChanged(const QString &interface, const QVariantMap &changed,
+                                      const QStringList &invalidated, const QDBusMessage &message);
+        void endSessionsFinished(QDBusPendingCallWatcher *watcher);
+        void endSessionsTimedOut();
 
     private:
+        struct UserSessions {
+            int count = 0;
+            QString state;
+            QDBusObjectPath path;
+        };
+
+        void scheduleReconcile();
+        void applyReplies();
+        void fetchStates(const QList<uint> &uids);
+        void checkEnded();
+
         OrgFreedesktopLogin1ManagerInterface* m_manager;
+        QDBusServiceWatcher* m_serviceWatcher;
+        QTimer* m_periodicTimer;
+        QHash<uint, UserSessions> m_users;
+        QHash<QString, uint> m_sessionUsers;
+
+        bool m_reconcileScheduled = false;
+        bool m_reconcileAgain = false;
+        bool m_fullReconcile = true;
+        QDBusPendingCallWatcher* m_usersWatcher = nullptr;
+        QDBusPendingCallWatcher* m_sessionsWatcher = nullptr;
+
+        QHash<QDBusPendingCallWatcher*, uint> m_stateCalls;
+        /* The values of m_stateCalls, to tell whether a user is asked for already */
+        QSet<uint> m_stateUids;
+        QList<uint> m_stateChanged;
+
+        QTimer* m_endTimer;
+        QHash<QDBusPendingCallWatcher*, uint> m_endCalls;
+        QSet<uint> m_endUids;
+        QSet<uint> m_ending;
 };
 
 #endif //USER_SESSION_H
@@ -0,0 +1,197 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "userdelegate.h"
+#include "lib/accountmodel.h"
+#include "lib/accountsortmodel.h"
+
+#include <QApplication>
+#include <QFontDatabase>
+#include <QIcon>
+#include <QPainter>
+#include <QPainterPath>
+
+#include <KColorScheme>
+
+static const int s_margin = 4;
+static const int s_spacing = 8;
+
+UserDelegate::UserDelegate(QObject* parent)
+ : QStyledItemDelegate(parent)
+ , m_iconSize(32)
+ , m_secondaryFont(QFontDatabase::systemFont(QFontDatabase::SmallestReadableFont))
+ , m_texts(2048)
+ , m_faces(512)
+{
+}
+
+void UserDelegate::setIconSize(int size)
+{
+    m_iconSize = size;
+    m_faces.clear();
+    m_badge = QPixmap();
+}
+
+QSize UserDelegate::sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+    Q_UNUSED(index)
+
+    // The same for every row, so the view can lay out any number of them at once
+    const int text = option.fontMetrics.height() + QFontMetrics(m_secondaryFont).height();
+    return QSize(option.rect.width(), qMax(m_iconSize, text) + 2 * s_margin);
+}
+
+void UserDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+    const QWidget *widget = option.widget;
+    QStyle *style = widget ? widget->style() : QApplication::style();
+    style->drawPrimitive(QStyle::PE_PanelItemViewItem, &option, painter, widget);
+
+    // A hairline where one group of the sorted list ends and the next begins
+    const QVariant sortGroup = index.data(AccountSortModel::GroupRole);
+    if (sortGroup.isValid() && index.row() > 0 && index.sibling(index.row() - 1, 0).data(AccountSortModel::GroupRole) != sortGroup) {
+        QColor line = option.palette.color(QPalette::Text);
+        line.setAlphaF(0.2);
+        painter->fillRect(QRect(option.rect.left() + s_margin, option.rect.top(), option.rect.width() - 2 * s_margin, 1), line);
+    }
+
+    const qreal dpr = painter->device()->devicePixelRatioF();
+    const QRect faceRect(option.rect.left() + s_margin, option.rect.top() + (option.rect.height() - m_iconSize) / 2,
+                         m_iconSize, m_iconSize);
+
+    const QVariant decoration = index.data(Qt::DecorationRole);
+    if (decoration.type() == QVariant::Pixmap) {
+        painter->drawPixmap(faceRect, circularFace(decoration.value<QPixmap>(), dpr));
+    } else if (decoration.type() == QVariant::Icon) {
+        decoration.value<QIcon>().paint(painter, faceRect);
+    }
+
+    if (index.data(AccountModel::Logged).toBool()) {
+        const QPixmap dot = badge(option.palette.color(QPalette::Base), dpr);
+        const QSize size = dot.size() / dot.devicePixelRatio();
+        painter->drawPixmap(faceRect.right() + 1 - size.width(), faceRect.bottom() + 1 - size.height(), dot);
+    }
+
+    if (m_font != option.font) {
+        m_font = option.font;
+        m_texts.clear();
+    }
+
+    const bool selected = option.state & QStyle::State_Selected;
+    const QPalette::ColorGroup group = option.state & QStyle::State_Enabled ? QPalette::Normal : QPalette::Disabled;
+    const QColor color = option.palette.color(group, selected ? QPalette::HighlightedText : QPalette::Text);
+
+    const int textLeft = faceRect.right() + 1 + s_spacing;
+    const int textWidth = option.rect.right() + 1 - s_margin - textLeft;
+    if (textWidth <= 0) {
+        return;
+    }
+
+    const QString name = index.data(Qt::DisplayRole).toString();
+    const QString username = index.data(AccountModel::Username).toString();
+    const bool twoLines = !username.isEmpty() && username != name;
+
+    const QStaticText first = staticText(name, option.font, textWidth, false);
+    const int firstHeight = option.fontMetrics.height();
+    const int textHeight = twoLines ? firstHeight + QFontMetrics(m_secondaryFont).height() : firstHeight;
+    const int top = option.rect.top() + (option.rect.height() - textHeight) / 2;
+
+    painter->save();
+    painter->setPen(color);
+    painter->setFont(option.font);
+    painter->drawStaticText(textLeft, top, first);
+    if (twoLines) {
+        QColor secondary = color;
+        secondary.setAlphaF(0.7);
+        painter->setPen(secondary);
+        painter->setFont(m_secondaryFont);
+        painter->drawStaticText(textLeft, top + firstHeight, staticText(username, m_secondaryFont, textWidth, true));
+    }
+    painter->restore();
+}
+
+QStaticText UserDelegate::staticText(const QString &text, const QFont &font, int width, bool secondary) const
+{
+    // Eliding and laying out happen once per string and width, not once per paint
+    const QString key = (secondary ? QLatin1Char('2') : QLatin1Char('1')) + QString::number(width) + QLatin1Char('\x1f') + text;
+    if (const QStaticText *cached = m_texts.object(key)) {
+        return *cached;
+    }
+
+    auto *staticText = new QStaticText(QFontMetrics(font).elidedText(text, Qt::ElideRight, width));
+    staticText->setTextFormat(Qt::PlainText);
+    staticText->setPerformanceHint(QStaticText::AggressiveCaching);
+    staticText->prepare(QTransform(), font);
+
+    const QStaticText result = *staticText;
+    m_texts.insert(key, staticText);
+    return result;
+}
+
+QPixmap UserDelegate::circularFace(const QPixmap &face, qreal dpr) const
+{
+    // The model hands out the same pixmap until the face changes
+    if (const QPixmap *cached = m_faces.object(face.cacheKey())) {
+        if (qFuzzyCompare(cached->devicePixelRatio(), dpr)) {
+            return *cached;
+        }
+    }
+
+    const int size = qRound(m_iconSize * dpr);
+    auto *circle = new QPixmap(size, size);
+    circle->fill(Qt::transparent);
+
+    QPainter painter(circle);
+    painter.setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform);
+    QPainterPath path;
+    path.addEllipse(QRectF(0, 0, size, size));
+    painter.setClipPath(path);
+
+    // Fill the circle, cutting off what sticks out of a non square face
+    const QSizeF faceSize = QSizeF(face.size()).scaled(size, size, Qt::KeepAspectRatioByExpanding);
+    painter.drawPixmap(QRectF(QPointF((size - faceSize.width()) / 2, (size - faceSize.height()) / 2), faceSize), face, face.rect());
+    painter.end();
+
+    circle->setDevicePixelRatio(dpr);
+    const QPixmap result = *circle;
+    m_faces.insert(face.cacheKey(), circle);
+    return result;
+}
+
+QPixmap UserDelegate::badge(const QColor &border, qreal dpr) const
+{
+    if (!m_badge.isNull() && m_badgeBorder == border && qFuzzyCompare(m_badge.devicePixelRatio(), dpr)) {
+        return m_badge;
+    }
+
+    const int size = qRound(qMax(8, m_iconSize / 3) * dpr);
+    m_badge = QPixmap(size, size);
+    m_badge.fill(Qt::transparent);
+
+    QPainter painter(&m_badge);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QPen(border, qMax(1.0, dpr)));
+    painter.setBrush(KColorScheme(QPalette::Active, KColorScheme::View).foreground(KColorScheme::PositiveText).color());
+    const qreal inset = qMax(1.0, dpr) / 2;
+    painter.drawEllipse(QRectF(inset, inset, size - 2 * inset, size - 2 * inset));
+    painter.end();
+
+    m_badge.setDevicePixelRatio(dpr);
+    m_badgeBorder = border;
+    return m_badge;
+}
@@ -0,0 +1,61 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by the User Manager developers                                *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#ifndef USER_DELEGATE_H
+#define USER_DELEGATE_H
+
+#include <QCache>
+#include <QColor>
+#include <QPixmap>
+#include <QStaticText>
+#include <QStyledItemDelegate>
+
+/**
+ * Paints a row of the user list: the face in a circle, with a badge when the
+ * user is logged in, the name and below it the login name.
+ *
+ * All rows have the same size and everything costly is cached: the laid out
+ * text per string and width, the circular face per face pixmap and the badge.
+ * Painting a row that was painted before only draws pixmaps and static text.
+ */
+class UserDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+    public:
+        explicit UserDelegate(QObject* parent = nullptr);
+
+        void setIconSize(int size);
+
+        void paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+        QSize sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+
+    private:
+        QStaticText staticText(const QString &text, const QFont &font, int width, bool secondary) const;
+        QPixmap circularFace(const QPixmap &face, qreal dpr) const;
+        QPixmap badge(const QColor &border, qreal dpr) const;
+
+        int m_iconSize;
+        QFont m_secondaryFont;
+        mutable QFont m_font;
+        mutable QCache<QString, QStaticText> m_texts;
+        mutable QCache<qint64, QPixmap> m_faces;
+        mutable QPixmap m_badge;
+        mutable QColor m_badgeBorder;
+};
+
+#endif //USER_DELEGATE_H
@@ -20,51 +20,108 @@
 #include "ui_kcm.h"
 #include "ui_account.h"
 #include "accountinfo.h"
+#include "userdelegate.h"
 
+#include "lib/accountsortmodel.h"
 #include "lib/modeltest.h"
+#include "lib/startuptrace.h"
 
 #include <pwquality.h>
 
+#include <QAction>
+#include <QScrollBar>
+#include <QTimer>
 #include <QVBoxLayout>
 
 #include <kpluginfactory.h>
+#include <KConfigGroup>
+#include <KFormat>
 #include <KLocalizedString>
 #include <KMessageBox>
+#include <KMessageWidget>
+#include <KSharedConfig>
 
 K_PLUGIN_FACTORY(UserManagerFactory, registerPlugin<UserManager>();)
 
 UserManager::UserManager(QWidget* parent, const QVariantList& args) 
  : KCModule(parent, args)
- , m_model(new AccountModel(this))
- , m_widget(new AccountInfo(m_model, this))
  , m_ui(new Ui::KCMUserManager)
 {
     Q_UNUSED(args)
 
+    StartupTrace::start();
+    m_model = new AccountModel(this);
+    m_widget = new AccountInfo(m_model, this);
+
+    // Logged in users first, then administrators, unless asked to just sort by name
+    const KConfigGroup listGroup(KSharedConfig::openConfig(QStringLiteral("kcm_usermanagerrc")), "UserList");
+    m_sortModel = new AccountSortModel(this);
+    m_sortModel->setGrouped(listGroup.readEntry("Grouped", true));
+    m_sortModel->setSourceModel(m_model);
+    StartupTrace::mark("account form constructed");
+
     // No default button
     setButtons( Apply | Help);
 
     QVBoxLayout *layout = new QVBoxLayout();
     m_ui->setupUi(this);
     m_ui->accountInfo->setLayout(layout);
+
+    m_messageWidget = new KMessageWidget(this);
+    m_messageWidget->setWordWrap(true);
+    m_messageWidget->hide();
+    QAction *retry = new QAction(QIcon::fromTheme(QStringLiteral("view-refresh")), i18n("Retry"), m_messageWidget);
+    connect(retry, &QAction::triggered, m_model, &AccountModel::cancelPendingCalls);
+    m_messageWidget->addAction(retry);
+    layout->addWidget(m_messageWidget);
     layout->addWidget(m_widget);
 
-    m_selectionModel = new QItemSelectionModel(m_model);
+    m_selectionModel = new QItemSelectionModel(m_sortModel);
     connect(m_selectionModel, &QItemSelectionModel::currentChanged, this, &UserManager::currentChanged);
-    m_selectionModel->setCurrentIndex(m_model->index(0), QItemSelectionModel::SelectCurrent);
+    connect(m_selectionModel, &QItemSelectionModel::selectionChanged, this, &UserManager::updateButtons);
+    m_selectionModel->setCurrentIndex(m_sortModel->mapFromSource(m_model->index(0)), QItemSelectionModel::SelectCurrent);
 
-    m_ui->userList->setModel(m_model);
+    // Without a snapshot only the "new user" row exists yet, the current user is
+    // selected as soon as it shows up at the top, see AccountModel::currentUserFound()
+    m_currentUserPending = !m_model->data(m_model->index(0), AccountModel::Created).toBool();
+    connect(m_model, &QAbstractItemModel::rowsInserted, this, &UserManager::selectCurrentUser);
+    connect(m_model, &QAbstractItemModel::rowsMoved, this, &UserManager::selectCurrentUser);
+
+    m_ui->userList->setModel(m_sortModel);
+    m_ui->userList->viewport()->installEventFilter(this);
     m_ui->userList->setSelectionModel(m_selectionModel);
     const auto iconSize = style()->pixelMetric(QStyle::PM_LargeIconSize);
     m_ui->userList->setIconSize(QSize(iconSize, iconSize));
+    UserDelegate *delegate = new UserDelegate(m_ui->userList);
+    delegate->setIconSize(iconSize);
+    m_ui->userList->setItemDelegate(delegate);
+    m_ui->userList->setUniformItemSizes(true);
 
     ModelTest* test = new ModelTest(m_model, nullptr);
     Q_UNUSED(test)
 
     connect(m_ui->addBtn, &QAbstractButton::clicked, this, &UserManager::addNewUser);
     connect(m_ui->removeBtn, &QAbstractButton::clicked, this, &UserManager::removeUser);
+    connect(m_ui->endSessionsBtn, &QAbstractButton::clicked, this, &UserManager::endSessions);
+    connect(m_ui->passwordStatusBtn, &QAbstractButton::clicked, m_model, &AccountModel::fetchPrivilegedDetails);
     connect(m_widget, &AccountInfo::changed, this, QOverload<bool>::of(&KCModule::changed));
     connect(m_model, &QAbstractItemModel::dataChanged, this, &UserManager::dataChanged);
+    connect(m_model, &AccountModel::callFailed, this, &UserManager::showError);
+    connect(m_model, &AccountModel::degradedChanged, this, &UserManager::degradedChanged);
+    if (m_model->isDegraded()) {
+        degradedChanged(true);
+    }
+
+    // Keep the model informed about what is on screen, so those rows are fetched first
+    QScrollBar *scrollBar = m_ui->userList->verticalScrollBar();
+    connect(scrollBar, &QAbstractSlider::valueChanged, this, &UserManager::updateVisibleRows);
+    connect(scrollBar, &QAbstractSlider::rangeChanged, this, &UserManager::updateVisibleRows);
+    connect(m_model, &QAbstractItemModel::rowsInserted, this, &UserManager::updateVisibleRows);
+    connect(m_model, &QAbstractItemModel::rowsRemoved, this, &UserManager::updateVisibleRows);
+    connect(m_sortModel, &QAbstractItemModel::rowsMoved, this, &UserManager::updateVisibleRows);
+    QTimer::singleShot(0, this, &UserManager::updateVisibleRows);
+
+    StartupTrace::mark("module constructed");
 }
 
 UserManager::~UserManager()
@@ -72,6 +129,17 @@ UserManager::~UserManager()
     delete m_model;
 }
 
+bool UserManager::eventFilter(QObject* watched, QEvent* event)
+{
+    if (!m_firstPaintDone && event->type() == QEvent::Paint && watched == m_ui->userList->viewport()) {
+        m_firstPaintDone = true;
+        StartupTrace::mark(m_model->loadedFromSnapshot() ? "first paint of the user list (from snapshot)"
+                                                         : "first paint of the user list (no snapshot)");
+    }
+
+    return KCModule::eventFilter(watched, event);
+}
+
 void UserManager::load()
 {
     m_widget->loadFromModel();
@@ -85,46 +153,162 @@ void UserManager::save()
 void UserManager::currentChanged(const QModelIndex& selected, const QModelIndex& previous)
 {
     Q_UNUSED(previous)
-    m_widget->setModelIndex(selected);
-    bool enabled = false;
+    m_widget->setModelIndex(m_sortModel->mapToSource(selected));
+    updateButtons();
+}
+
+QModelIndexList UserManager::removableSelection() const
+{
+    QModelIndexList indexes;
+    const QModelIndexList selected = m_selectionModel->selectedRows();
+    for (const QModelIndex &selectedIndex : selected) {
+        //If it is not last and not first
+        const QModelIndex index = m_sortModel->mapToSource(selectedIndex);
+        if (index.row() < m_model->rowCount() - 1 && index.row() > 0) {
+            indexes.append(index);
+        }
+    }
+    return indexes;
+}
+
+void UserManager::updateButtons()
+{
+    const QModelIndexList removable = removableSelection();
+
+    bool logged = false;
+    for (const QModelIndex &index : removable) {
+        if (m_model->data(index, AccountModel::Logged).toBool()) {
+            logged = true;
+            break;
+        }
+    }
+
+    // Removing is all or nothing, the own account or the "new user" row can not go
+    const bool enabled = !removable.isEmpty() && removable.count() == m_selectionModel->selectedRows().count();
+    m_ui->removeBtn->setEnabled(enabled && !m_model->isDegraded());
+    m_ui->endSessionsBtn->setEnabled(logged);
+}
+
+void UserManager::dataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight)
+{
+    updateButtons();
+
+    //Rows come merged into ranges of the source model, the current one may be inside
+    const QModelIndex current = m_selectionModel->currentIndex();
+    const int row = m_sortModel->mapToSource(current).row();
+    if (row < 0 || row < topLeft.row() || row > bottomRight.row()) {
+        return;
+    }
+
+    currentChanged(current, current);
+}
+
+void UserManager::updateVisibleRows()
+{
+    const QRect viewport = m_ui->userList->viewport()->rect();
+    const QModelIndex first = m_ui->userList->indexAt(viewport.topLeft());
+    const QModelIndex last = m_ui->userList->indexAt(viewport.bottomLeft());
+    const int count = m_sortModel->rowCount();
+    const int firstRow = first.isValid() ? first.row() : 0;
+    const int lastRow = last.isValid() ? last.row() : count - 1;
+
+    // Sorted, the rows on screen are scattered over the model
+    QVector<int> visible;
+    for (int row = firstRow; row <= lastRow; ++row) {
+        visible.append(m_sortModel->mapToSource(m_sortModel->index(row, 0)).row());
+    }
 
-    //If it is not last and not first
-    if (selected.row() < m_model->rowCount() - 1 && selected.row() > 0) {
-        enabled = true;
+    // Prefetch one more screen worth of rows below the visible ones
+    QVector<int> lookahead;
+    for (int row = lastRow + 1; row <= lastRow + (lastRow - firstRow + 1) && row < count; ++row) {
+        lookahead.append(m_sortModel->mapToSource(m_sortModel->index(row, 0)).row());
     }
 
-    m_ui->removeBtn->setEnabled(enabled);
-    m_selectionModel->setCurrentIndex(selected, QItemSelectionModel::SelectCurrent);
+    m_model->setVisibleRows(visible, lookahead);
 }
 
-void UserManager::dataChanged(const QModelIndex& topLeft, const QModelIndex& topRight)
+void UserManager::showError(const QString& message)
 {
-    Q_UNUSED(topRight)
-    if (m_selectionModel->currentIndex() != topLeft) {
+    if (m_model->isDegraded()) {
         return;
     }
 
-    currentChanged(topLeft, topLeft);
+    m_messageWidget->setMessageType(KMessageWidget::Error);
+    m_messageWidget->setText(i18n("Could not apply the changes: %1", message));
+    m_messageWidget->animatedShow();
+}
+
+void UserManager::degradedChanged(bool degraded)
+{
+    m_widget->setReadOnly(degraded);
+    m_ui->addBtn->setEnabled(!degraded);
+
+    if (!degraded) {
+        m_messageWidget->animatedHide();
+        const QModelIndex current = m_selectionModel->currentIndex();
+        currentChanged(current, current);
+        return;
+    }
+
+    updateButtons();
+    m_messageWidget->setMessageType(KMessageWidget::Warning);
+    m_messageWidget->setText(i18n("The accounts service is not responding. The last known information is shown and changes are disabled until it responds again."));
+    m_messageWidget->animatedShow();
+}
+
+void UserManager::selectCurrentUser()
+{
+    if (!m_currentUserPending || !m_model->data(m_model->index(0), AccountModel::Created).toBool()) {
+        return;
+    }
+
+    m_currentUserPending = false;
+    m_selectionModel->setCurrentIndex(m_sortModel->mapFromSource(m_model->index(0)), QItemSelectionModel::SelectCurrent);
 }
 
 void UserManager::addNewUser()
 {
-    m_selectionModel->setCurrentIndex(m_model->index(m_model->rowCount()-1), QItemSelectionModel::SelectCurrent);
+    m_currentUserPending = false;
+    m_selectionModel->setCurrentIndex(m_sortModel->mapFromSource(m_model->index(m_model->rowCount()-1)), QItemSelectionModel::SelectCurrent);
 }
 
 void UserManager::removeUser()
 {
-    QModelIndex index = m_selectionModel->currentIndex();
+    const QModelIndexList indexes = removableSelection();
+    if (indexes.isEmpty()) {
+        return;
+    }
+
+    int logged = 0;
+    qint64 homeUsage = 0;
+    for (const QModelIndex &index : indexes) {
+        if (m_model->data(index, AccountModel::Logged).toBool()) {
+            ++logged;
+        }
+        homeUsage += m_model->data(index, AccountModel::HomeUsage).toLongLong();
+    }
 
     KGuiItem keep;
     keep.setText(i18n("Keep files"));
     KGuiItem deletefiles;
     deletefiles.setText(i18n("Delete files"));
 
-    QString warning = i18n("What do you want to do after deleting %1 ?", m_model->data(index, AccountModel::FriendlyName).toString());
-    if (!m_model->data(index, AccountModel::Logged).toBool()) {
+    QString warning;
+    if (indexes.count() == 1) {
+        warning = i18n("What do you want to do after deleting %1 ?", m_model->data(indexes.first(), AccountModel::FriendlyName).toString());
+    } else {
+        warning = i18np("What do you want to do after deleting %1 user?", "What do you want to do after deleting %1 users?", indexes.count());
+    }
+    // Only what was scanned so far, homes of other users are often not readable for us
+    if (homeUsage > 0) {
+        warning.append(QStringLiteral("\n\n"));
+        warning.append(i18np("The home folder takes up %2.", "The home folders take up at least %2.",
+                             indexes.count(), KFormat().formatByteSize(homeUsage)));
+    }
+    if (logged > 0) {
         warning.append(QStringLiteral("\n\n"));
-        warning.append(i18n("This user is using the system right now, removing it will cause problems"));
+        warning.append(i18np("This user is using the system right now, removing it will cause problems",
+                             "%1 of these users are using the system right now, removing them will cause problems", logged));
     }
 
     const int result = KMessageBox::questionYesNoCancel(this, warning, i18n("Delete User"), keep, deletefiles);
@@ -133,9 +317,52 @@ void UserManager::removeUser()
     }
 
     bool deleteFiles  = result == KMessageBox::Yes ? false : true;
-    m_model->removeAccountKeepingFiles(index.row(), deleteFiles);
+
+    // Logged in users are logged out first, each one is deleted as soon as logind let it go
+    bool endSessionsFirst = false;
+    if (logged > 0) {
+        KGuiItem endSessions(i18n("Log Out and Delete"), QStringLiteral("system-log-out"));
+        KGuiItem deleteAnyway(i18n("Delete Anyway"));
+        const int answer = KMessageBox::warningYesNoCancel(this,
+            i18np("End the session of the logged in user before deleting it?",
+                  "End the sessions of the %1 logged in users before deleting them?", logged),
+            i18n("Delete User"), endSessions, deleteAnyway);
+        if (answer == KMessageBox::Cancel) {
+            return;
+        }
+        endSessionsFirst = answer == KMessageBox::Yes;
+    }
+
+    m_model->removeAccounts(indexes, deleteFiles, endSessionsFirst);
 
     emit changed(false);
 }
 
+void UserManager::endSessions()
+{
+    QModelIndexList indexes;
+    const QModelIndexList selected = m_selectionModel->selectedRows();
+    for (const QModelIndex &selectedIndex : selected) {
+        const QModelIndex index = m_sortModel->mapToSource(selectedIndex);
+        if (index.row() > 0 && m_model->data(index, AccountModel::Logged).toBool()) {
+            indexes.append(index);
+        }
+    }
+
+    if (indexes.isEmpty()) {
+        return;
+    }
+
+    const QString question = indexes.count() == 1
+        ? i18n("Log out %1? Unsaved work in the session will be lost.", m_model->data(indexes.first(), AccountModel::FriendlyName).toString())
+        : i18np("Log out %1 user? Unsaved work in the session will be lost.", "Log out %1 users? Unsaved work in their sessions will be lost.", indexes.count());
+    const int result = KMessageBox::warningContinueCancel(this, question, i18n("Log Out Users"),
+                                                          KGuiItem(i18n("Log Out"), QStringLiteral("system-log-out")));
+    if (result != KMessageBox::Continue) {
+        return;
+    }
+
+    m_model->endSessions(indexes);
+}
+
 #include "usermanager.moc"
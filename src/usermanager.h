@@ -29,7 +29,9 @@ namespace Ui
 }
 
 class QModelIndex;
+class KMessageWidget;
 class AccountInfo;
+class AccountSortModel;
 class QItemSelection;
 class QItemSelectionModel;
 class UserManager : public KCModule
@@ -42,16 +44,31 @@ class UserManager : public KCModule
         void load() override;
         void save() override;
 
+    protected:
+        bool eventFilter(QObject *watched, QEvent *event) override;
+
     public Q_SLOTS:
         void currentChanged(const QModelIndex &selected, const QModelIndex &previous);
-        void dataChanged(const QModelIndex &topLeft ,const QModelIndex &topRight);
+        void dataChanged(const QModelIndex &topLeft ,const QModelIndex &bottomRight);
         void addNewUser();
         void removeUser();
+        void endSessions();
+        void updateButtons();
+        void updateVisibleRows();
+        void showError(const QString &message);
+        void degradedChanged(bool degraded);
+        void selectCurrentUser();
 
     private:
+        QModelIndexList removableSelection() const;
+
         bool m_saveNeeded = false;
+        bool m_firstPaintDone = false;
+        bool m_currentUserPending = false;
         AccountModel* m_model = nullptr;
+        AccountSortModel* m_sortModel = nullptr;
         AccountInfo* m_widget = nullptr;
+        KMessageWidget* m_messageWidget = nullptr;
         Ui::KCMUserManager* const m_ui;
         QItemSelectionModel* m_selectionModel = nullptr;
         QMap<AccountModel::Role, QVariant> m_cachedInfo;